@@ -63,10 +63,10 @@ else # 'all' or 'resume'
     packages/geom_svc
     framework/ffaobjects
     framework/fun4all
+    packages/Half
     interface_main
     packages/UtilAna
     online/decoder_maindaq
-    packages/Half
     packages/vararray
     database/pdbcal/base
     database/PHParameter
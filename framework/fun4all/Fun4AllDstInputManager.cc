@@ -14,18 +14,24 @@
 #include <phool/PHCompositeNode.h>
 #include <phool/PHIODataNode.h>
 #include <phool/PHNodeIOManager.h>
+#include <phool/phooldefs.h>
 #include <phool/recoConsts.h>
 
 #include <TH1.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <fstream>
 #include <memory>
+#include <sstream>
 
 using namespace std;
 
 Fun4AllDstInputManager::Fun4AllDstInputManager(const string &name, const string &nodename, const string &topnodename) : 
   Fun4AllInputManager(name, nodename, topnodename),
   readrunttree(1),
+  lazyread(false),
+  lazyfull(false),
   isopen(0),
   events_total(0),
   events_thisfile(0),
@@ -35,7 +41,8 @@ Fun4AllDstInputManager::Fun4AllDstInputManager(const string &name, const string
   dstNode(NULL),
   runNode(NULL),
   IManager(NULL),
-  syncobject(NULL)
+  syncobject(NULL),
+  selectionReady(false)
 {
   return ;
 }
@@ -103,12 +110,14 @@ Fun4AllDstInputManager::fileopen(const string &filenam)
   dstNode = se->getNode(InputNode.c_str(), topNodeName.c_str());
   //IManager = new PHNodeIOManager(frog.location(filename.c_str()), PHReadOnly);
   IManager = new PHNodeIOManager(filenam.c_str(), PHReadOnly);
+  IManager->SetLazyRead(lazyread);
   if (IManager->isFunctional())
     {
       isopen = 1;
       events_thisfile = 0;
       setBranches(); // set branch selections
       AddToFileOpened(filename); // add file to the list of files which were opened
+      selectionReady = false; // the selected entries are looked up at the first read
       return 0;
     }
   else
@@ -150,7 +159,7 @@ int Fun4AllDstInputManager::run(const int nevents)
  readagain:
   PHCompositeNode *dummy;
   int ncount = 0;
-  dummy = IManager->read(dstNode);
+  dummy = ReadNextEvent();
   while (dummy)
     {
       ncount ++;
@@ -158,7 +167,7 @@ int Fun4AllDstInputManager::run(const int nevents)
         {
           break;
         }
-      dummy = IManager->read(dstNode);
+      dummy = ReadNextEvent();
     }
   if (!dummy)
     {
@@ -176,10 +185,21 @@ int Fun4AllDstInputManager::run(const int nevents)
     {
       goto readagain;
     }
+  MaterializeEvent();
   syncobject = findNode::getClass<SyncObject>(dstNode,"Sync");
   return 0;
 }
 
+void
+Fun4AllDstInputManager::MaterializeEvent()
+{
+  // read all the lazy nodes of the accepted event, unless fully lazy
+  if (lazyread && !lazyfull && IManager)
+    {
+      IManager->materializeAll();
+    }
+}
+
 int Fun4AllDstInputManager::fileclose()
 {
   if (!isopen)
@@ -345,6 +365,8 @@ Fun4AllDstInputManager::SyncIt(const SyncObject *mastersync)
               fileclose();
               return Fun4AllReturnCodes::SYNC_FAIL;
             }
+          MaterializeEvent();
+          syncobject = findNode::getClass<SyncObject>(dstNode,"Sync"); // reads the sync node again in the lazy mode
           int iret = syncobject->Different(mastersync); // final check if they really agree
           if (iret) // if not things are severely wrong
             {
@@ -420,8 +442,11 @@ Fun4AllDstInputManager::ReadNextEventSyncObject()
       // so check if IManager is valid before getting a new event
       if (IManager)
 	{
-	  EventOnDst = IManager->getEventNumber(); // this returns the next number of the event
-	  itest = IManager->readSpecific(EventOnDst, syncbranchname.c_str());
+	  if (SkipToSelectedEntry()) // with an event selection only the selected events can sync
+	    {
+	      EventOnDst = IManager->getEventNumber(); // this returns the next number of the event
+	      itest = IManager->readSpecific(EventOnDst, syncbranchname.c_str());
+	    }
 	}
       else
 	{
@@ -434,7 +459,7 @@ Fun4AllDstInputManager::ReadNextEventSyncObject()
     }
   else
     {
-      if (IManager->read(dstNode))
+      if (SkipToSelectedEntry() && IManager->read(dstNode))
         {
           itest = 1;
         }
@@ -467,6 +492,8 @@ Fun4AllDstInputManager::ReadNextEventSyncObject()
     {
       readfull = 0;
     }
+  // in the lazy mode the sync node is not filled by read(), and the node object can change
+  syncobject = findNode::getClass<SyncObject>(dstNode,"Sync");
   return 0;
 }
 
@@ -622,3 +649,164 @@ Fun4AllDstInputManager::PushBackEvents(const int i)
        << " probably the dst is not open yet (you need to call fileopen or run 1 event for lists)" << endl;
   return -1;
 }
+
+PHCompositeNode *
+Fun4AllDstInputManager::ReadNextEvent()
+{
+  if (!SkipToSelectedEntry())
+    {
+      return NULL; // no more selected event in this file
+    }
+  return IManager->read(dstNode);
+}
+
+// Moves the io manager forward to the next selected entry of the current file.
+// Returns false if there is none left; without selection it does nothing.
+bool
+Fun4AllDstInputManager::SkipToSelectedEntry()
+{
+  if (evtSelection.empty())
+    {
+      return true;
+    }
+  size_t next = IManager->getEventNumber();
+  if (!selectionReady)
+    {
+      PrepareSelectedEntries(); // on failure no entry is selected
+      selectionReady = true;
+    }
+  vector<long long>::const_iterator iter = lower_bound(selectedEntries.begin(), selectedEntries.end(), static_cast<long long>(next));
+  if (iter == selectedEntries.end())
+    {
+      return false;
+    }
+  IManager->setEventNumber(*iter);
+  return true;
+}
+
+int
+Fun4AllDstInputManager::AddEventSelection(const int run, const int spill, const int event)
+{
+  evtSelection.push_back(Fun4AllEventIndex::Key(run, spill, event));
+  selectionReady = false;
+  return 0;
+}
+
+int
+Fun4AllDstInputManager::ReadEventList(const string &listfile)
+{
+  ifstream ifs(listfile.c_str());
+  if (!ifs.is_open())
+    {
+      cout << PHWHERE << Name() << ": could not open event list " << listfile << endl;
+      return -1;
+    }
+  string line;
+  int nadded = 0;
+  while (getline(ifs, line))
+    {
+      if (line.empty() || line[0] == '#')
+        {
+          continue;
+        }
+      istringstream iss(line);
+      int run, spill, event;
+      if (iss >> run >> spill >> event)
+        {
+          evtSelection.push_back(Fun4AllEventIndex::Key(run, spill, event));
+          nadded++;
+        }
+    }
+  if (verbosity > 0)
+    {
+      cout << Name() << ": " << nadded << " events selected from " << listfile << endl;
+    }
+  selectionReady = false;
+  return 0;
+}
+
+void
+Fun4AllDstInputManager::ClearEventSelection()
+{
+  evtSelection.clear();
+  selectedEntries.clear();
+  selectionReady = false;
+}
+
+// Translate the event selection into a sorted list of entries of the
+// current file, so that the file is still read forward.
+// The position of the io manager is kept.
+int
+Fun4AllDstInputManager::PrepareSelectedEntries()
+{
+  selectedEntries.clear();
+  size_t next = IManager->getEventNumber();
+  if (evtIndex.Read(filename))
+    {
+      cout << ThisName << ": " << filename << " has no event index,"
+           << " building it from the " << evtIndex.GetNodeName() << " branch" << endl;
+      int iret = BuildEventIndex();
+      IManager->setEventNumber(next);
+      if (iret)
+        {
+          cout << PHWHERE << ThisName << ": could not index " << filename
+               << ", no event will be read from it" << endl;
+          return -1;
+        }
+    }
+  vector<Fun4AllEventIndex::Key>::const_iterator iter;
+  for (iter = evtSelection.begin(); iter != evtSelection.end(); ++iter)
+    {
+      long long entry = evtIndex.Find(*iter);
+      if (entry >= 0)
+        {
+          selectedEntries.push_back(entry);
+        }
+    }
+  sort(selectedEntries.begin(), selectedEntries.end());
+  selectedEntries.erase(unique(selectedEntries.begin(), selectedEntries.end()), selectedEntries.end());
+  if (verbosity > 0)
+    {
+      cout << ThisName << ": " << selectedEntries.size() << " selected events found in "
+           << filename << endl;
+    }
+  return 0;
+}
+
+// Fallback for files written without an index: read only the branch
+// holding the event key for every entry.
+int
+Fun4AllDstInputManager::BuildEventIndex()
+{
+  evtIndex.Clear();
+  IManager->setEventNumber(0);
+  if (!IManager->read(dstNode)) // sets up the node tree and the branch addresses
+    {
+      return -1;
+    }
+  string keybranch;
+  string nodename = evtIndex.GetNodeName();
+  map<string, TBranch*>::const_iterator bIter;
+  for (bIter = IManager->GetBranchMap()->begin(); bIter != IManager->GetBranchMap()->end(); ++bIter)
+    {
+      const string &name = bIter->first;
+      string::size_type pos = name.rfind(nodename);
+      if (pos != string::npos && pos > 0 && pos + nodename.size() == name.size() &&
+          (name.substr(pos - 1, 1) == phooldefs::branchpathdelim || name[pos - 1] == '/'))
+        {
+          keybranch = name;
+          break;
+        }
+    }
+  if (keybranch.empty())
+    {
+      return -1;
+    }
+  for (size_t ient = 0; IManager->readSpecific(ient, keybranch.c_str()) > 0; ient++)
+    {
+      evtIndex.AddFromNode(dstNode, ient);
+    }
+  evtIndex.Sort();
+  IManager->setEventNumber(0);
+  return 0;
+}
@@ -3,8 +3,11 @@
 
 #include "Fun4AllInputManager.h"
 
+#include "Fun4AllEventIndex.h"
+
 #include <string>
 #include <map>
+#include <vector>
 
 class PHCompositeNode;
 class PHNodeIOManager;
@@ -26,10 +29,34 @@ class Fun4AllDstInputManager : public Fun4AllInputManager
   void Print(const std::string &what = "ALL") const;
   int PushBackEvents(const int i);
 
+  //! read only the listed (run, spill, event) triples, seeking via the event index.
+  //! The selection is translated into entries of each file at its first read,
+  //! and is also applied when this input is synchronized to another one.
+  int AddEventSelection(const int run, const int spill, const int event);
+  //! add the triples from a text file with one "run spill event" per line
+  int ReadEventList(const std::string &listfile);
+  void ClearEventSelection();
+  void SetEventIndexNode(const std::string &nodename) { evtIndex.SetNodeName(nodename); }
+
+  //! read each node only when it is first accessed via findNode::getClass in the event.
+  //! By default all the nodes are read once the event passes the SubsysReco modules
+  //! registered to this input manager (e.g. EvtFilter), so that the other modules,
+  //! which may keep node pointers across events, see the current event.
+  //! With "full" the nodes stay lazy for the whole event; then every module
+  //! has to get its nodes via findNode::getClass in each event.
+  void EnableLazyRead(const bool onoff = true, const bool full = false) { lazyread = onoff; lazyfull = full; }
+
  protected:
   int ReadNextEventSyncObject();
+  void MaterializeEvent();
   int OpenNextFile();
+  PHCompositeNode *ReadNextEvent();
+  int PrepareSelectedEntries();
+  bool SkipToSelectedEntry();
+  int BuildEventIndex();
   int readrunttree;
+  bool lazyread;
+  bool lazyfull;
   int isopen;
   int events_total;
   int events_thisfile;
@@ -42,6 +69,10 @@ class Fun4AllDstInputManager : public Fun4AllInputManager
   PHCompositeNode *runNode;
   PHNodeIOManager *IManager;
   SyncObject *syncobject;
+  Fun4AllEventIndex evtIndex;
+  std::vector<Fun4AllEventIndex::Key> evtSelection;
+  std::vector<long long> selectedEntries; // entries of the current file to be read
+  bool selectionReady; // selectedEntries is up to date with evtSelection and the current file
 };
 
 #endif /* __FUN4ALLDSTINPUTMANAGER_H__ */
@@ -1,4 +1,5 @@
 #include "Fun4AllDstOutputManager.h"
+#include "Fun4AllEventIndex.h"
 #include "Fun4AllServer.h"
 
 #include <phool/PHNode.h>
@@ -13,7 +14,8 @@
 using namespace std;
 
 Fun4AllDstOutputManager::Fun4AllDstOutputManager(const string &myname, const string &fname): 
- Fun4AllOutputManager( myname )
+ Fun4AllOutputManager( myname ),
+ evtIndex(0)
 {
   outfilename = fname;
   if (fname == "") {
@@ -33,6 +35,8 @@ Fun4AllDstOutputManager::Fun4AllDstOutputManager(const string &myname, const str
 Fun4AllDstOutputManager::~Fun4AllDstOutputManager()
 {
   delete dstOut;
+  WriteEventIndex();
+  delete evtIndex;
   return ;
 }
 
@@ -73,6 +77,7 @@ Fun4AllDstOutputManager::StripNode(const string &nodename)
 int
 Fun4AllDstOutputManager::outfileopen(const string &fname)
 {
+  outfilename = fname;
   dstOut = new PHNodeIOManager(fname.c_str(), PHWrite);
   if (!dstOut->isFunctional())
     {
@@ -201,6 +206,15 @@ Fun4AllDstOutputManager::Write(PHCompositeNode *startNode)
     }
 
   dstOut->write(startNode);
+  if (evtIndex)
+    {
+      // the io manager has already advanced to the next entry
+      if (evtIndex->AddFromNode(startNode, dstOut->getEventNumber() - 1) && verbosity > 0)
+        {
+          cout << PHWHERE << ThisName << ": no event key in node "
+               << evtIndex->GetNodeName() << ", event not indexed" << endl;
+        }
+    }
   if (savenodes.empty())
     {
       Fun4AllServer *se = Fun4AllServer::instance();
@@ -229,6 +243,7 @@ Fun4AllDstOutputManager::WriteNode(PHCompositeNode *thisNode)
   dstOut->write(thisNode);
   delete dstOut;
   dstOut = 0;
+  WriteEventIndex();
   return 0;
 }
 
@@ -237,3 +252,35 @@ Fun4AllDstOutputManager::EnableRealTimeSave()
 {
   dstOut->SetRealTimeSave(true);
 }
+
+void
+Fun4AllDstOutputManager::EnableEventIndex(const string &nodename)
+{
+  if (!evtIndex)
+    {
+      evtIndex = new Fun4AllEventIndex(nodename);
+    }
+  else
+    {
+      evtIndex->SetNodeName(nodename);
+    }
+}
+
+// The index is appended once the event tree of the current file has been
+// closed, so it never competes with the open PHNodeIOManager for the file.
+int
+Fun4AllDstOutputManager::WriteEventIndex()
+{
+  if (!evtIndex || evtIndex->Size() == 0)
+    {
+      return 0;
+    }
+  int ret = evtIndex->Write(outfilename);
+  if (verbosity > 0)
+    {
+      cout << ThisName << ": wrote event index with " << evtIndex->Size()
+           << " entries to " << outfilename << endl;
+    }
+  evtIndex->Clear();
+  return ret;
+}
@@ -8,6 +8,7 @@
 
 class PHNodeIOManager;
 class PHCompositeNode;
+class Fun4AllEventIndex;
 
 class Fun4AllDstOutputManager: public Fun4AllOutputManager
 {
@@ -28,10 +29,16 @@ class Fun4AllDstOutputManager: public Fun4AllOutputManager
 
   void EnableRealTimeSave();
 
+  //! write a sorted (run, spill, event) -> entry index into each output file
+  void EnableEventIndex(const std::string &nodename = "SQEvent");
+
  protected:
+  int WriteEventIndex();
+
   std::vector <std::string> savenodes;
   std::vector <std::string> stripnodes;
   PHNodeIOManager *dstOut;
+  Fun4AllEventIndex *evtIndex;
 };
 
 #endif /* __FUN4ALLDSTOUTPUTMANAGER_H__ */
@@ -0,0 +1,237 @@
+#include "Fun4AllEventIndex.h"
+
+#include <phool/phool.h>
+#include <phool/PHCompositeNode.h>
+#include <phool/PHIODataNode.h>
+#include <phool/PHNodeIterator.h>
+
+#include <TClass.h>
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TMethodCall.h>
+#include <TROOT.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+const string Fun4AllEventIndex::TREE_NAME = "EvtIdx";
+
+bool
+Fun4AllEventIndex::Key::operator<(const Key &k) const
+{
+  if (run   != k.run  ) return run   < k.run;
+  if (spill != k.spill) return spill < k.spill;
+  return event < k.event;
+}
+
+Fun4AllEventIndex::Fun4AllEventIndex(const string &node_name):
+  m_node_name(node_name),
+  m_sorted(true),
+  m_class(0),
+  m_get_run(0),
+  m_get_spill(0),
+  m_get_event(0)
+{}
+
+Fun4AllEventIndex::~Fun4AllEventIndex()
+{
+  delete m_get_run;
+  delete m_get_spill;
+  delete m_get_event;
+}
+
+void
+Fun4AllEventIndex::Clear()
+{
+  m_items.clear();
+  m_sorted = true;
+}
+
+void
+Fun4AllEventIndex::Add(const Key &key, const long long entry)
+{
+  Item it;
+  it.key   = key;
+  it.entry = entry;
+  if (m_sorted && !m_items.empty() && it < m_items.back())
+    {
+      m_sorted = false;
+    }
+  m_items.push_back(it);
+}
+
+int
+Fun4AllEventIndex::AddFromNode(PHCompositeNode *topNode, const long long entry)
+{
+  Key key;
+  if (ReadKey(topNode, key))
+    {
+      return -1;
+    }
+  Add(key, entry);
+  return 0;
+}
+
+// The getter methods are looked up once per payload class and reused, so that
+// the per-event cost is three calls through the dictionary.
+int
+Fun4AllEventIndex::ReadKey(PHCompositeNode *topNode, Key &key)
+{
+  PHNodeIterator iter(topNode);
+  PHIODataNode<TObject> *node = static_cast<PHIODataNode<TObject> *>(iter.findFirst("PHIODataNode", m_node_name.c_str()));
+  if (!node || !node->getData())
+    {
+      return -1;
+    }
+  TObject *obj = node->getData();
+  TClass *cl = obj->IsA();
+  if (cl != m_class)
+    {
+      delete m_get_run;
+      delete m_get_spill;
+      delete m_get_event;
+      m_class     = cl;
+      m_get_run   = new TMethodCall(cl, "get_run_id"  , "");
+      m_get_spill = new TMethodCall(cl, "get_spill_id", "");
+      m_get_event = new TMethodCall(cl, "get_event_id", "");
+      if (!m_get_run->IsValid() || !m_get_spill->IsValid() || !m_get_event->IsValid())
+        {
+          cout << PHWHERE << "Class " << cl->GetName() << " of node " << m_node_name
+               << " does not provide get_run_id/get_spill_id/get_event_id" << endl;
+          m_class = 0;
+          return -1;
+        }
+    }
+  if (CallGetter(m_get_run  , obj, key.run  ) ||
+      CallGetter(m_get_spill, obj, key.spill) ||
+      CallGetter(m_get_event, obj, key.event))
+    {
+      return -1;
+    }
+  return 0;
+}
+
+int
+Fun4AllEventIndex::CallGetter(TMethodCall *mc, void *obj, int &value) const
+{
+  if (!mc)
+    {
+      return -1;
+    }
+  Long_t ret = 0;
+  mc->Execute(obj, ret);
+  value = static_cast<int>(ret);
+  return 0;
+}
+
+void
+Fun4AllEventIndex::Sort()
+{
+  if (!m_sorted)
+    {
+      stable_sort(m_items.begin(), m_items.end());
+      m_sorted = true;
+    }
+}
+
+long long
+Fun4AllEventIndex::Find(const Key &key) const
+{
+  Item it;
+  it.key = key;
+  it.entry = 0;
+  if (m_sorted)
+    {
+      vector<Item>::const_iterator found = lower_bound(m_items.begin(), m_items.end(), it);
+      if (found != m_items.end() && found->key == key)
+        {
+          return found->entry;
+        }
+      return -1;
+    }
+  for (vector<Item>::const_iterator iter = m_items.begin(); iter != m_items.end(); ++iter)
+    {
+      if (iter->key == key)
+        {
+          return iter->entry;
+        }
+    }
+  return -1;
+}
+
+int
+Fun4AllEventIndex::Write(const string &file_name)
+{
+  Sort();
+  string currdir = gDirectory->GetPath();
+  TFile *file = TFile::Open(file_name.c_str(), "UPDATE");
+  if (!file || !file->IsOpen())
+    {
+      cout << PHWHERE << "Could not open " << file_name << " to write the event index" << endl;
+      delete file;
+      gROOT->cd(currdir.c_str());
+      return -1;
+    }
+  file->cd();
+  TTree *tree = new TTree(TREE_NAME.c_str(), "Event index (run, spill, event) -> entry");
+  Int_t run, spill, event;
+  Long64_t entry;
+  tree->Branch("run_id"  , &run  , "run_id/I");
+  tree->Branch("spill_id", &spill, "spill_id/I");
+  tree->Branch("event_id", &event, "event_id/I");
+  tree->Branch("entry"   , &entry, "entry/L");
+  for (vector<Item>::const_iterator iter = m_items.begin(); iter != m_items.end(); ++iter)
+    {
+      run   = iter->key.run;
+      spill = iter->key.spill;
+      event = iter->key.event;
+      entry = iter->entry;
+      tree->Fill();
+    }
+  tree->Write(0, TObject::kOverwrite);
+  file->Close();
+  delete file;
+  gROOT->cd(currdir.c_str());
+  return 0;
+}
+
+int
+Fun4AllEventIndex::Read(const string &file_name)
+{
+  Clear();
+  string currdir = gDirectory->GetPath();
+  TFile *file = TFile::Open(file_name.c_str());
+  if (!file || !file->IsOpen())
+    {
+      delete file;
+      gROOT->cd(currdir.c_str());
+      return -1;
+    }
+  int ret = -1;
+  TTree *tree = static_cast<TTree *>(file->Get(TREE_NAME.c_str()));
+  if (tree)
+    {
+      Int_t run, spill, event;
+      Long64_t entry;
+      tree->SetBranchAddress("run_id"  , &run  );
+      tree->SetBranchAddress("spill_id", &spill);
+      tree->SetBranchAddress("event_id", &event);
+      tree->SetBranchAddress("entry"   , &entry);
+      Long64_t n_ent = tree->GetEntries();
+      m_items.reserve(n_ent);
+      for (Long64_t i = 0; i < n_ent; i++)
+        {
+          tree->GetEntry(i);
+          Add(Key(run, spill, event), entry);
+        }
+      Sort(); // no-op for indices written by Write()
+      ret = 0;
+    }
+  file->Close();
+  delete file;
+  gROOT->cd(currdir.c_str());
+  return ret;
+}
@@ -0,0 +1,76 @@
+#ifndef FUN4ALLEVENTINDEX_H__
+#define FUN4ALLEVENTINDEX_H__
+
+#include <string>
+#include <vector>
+
+class PHCompositeNode;
+class TClass;
+class TMethodCall;
+
+/// A sorted (run, spill, event) -> TTree-entry index of one DST file.
+/**
+ * Fun4AllDstOutputManager fills it while writing events and stores it in the
+ * DST file as a small TTree (named by TREE_NAME) next to the event tree.
+ * Fun4AllDstInputManager reads it back to seek directly to selected events.
+ *
+ * The event key is taken from the node "node_name" (SQEvent by default)
+ * through its "get_run_id()", "get_spill_id()" and "get_event_id()" methods,
+ * which are called via the ROOT dictionary so that fun4all does not depend on
+ * the SQ interface classes.
+ */
+class Fun4AllEventIndex
+{
+ public:
+  struct Key
+  {
+    int run;
+    int spill;
+    int event;
+    Key(const int r = 0, const int s = 0, const int e = 0) : run(r), spill(s), event(e) {}
+    bool operator<(const Key &k) const;
+    bool operator==(const Key &k) const { return run == k.run && spill == k.spill && event == k.event; }
+  };
+
+  struct Item
+  {
+    Key key;
+    long long entry;
+    bool operator<(const Item &it) const { return key < it.key; }
+  };
+
+  static const std::string TREE_NAME;
+
+  Fun4AllEventIndex(const std::string &node_name = "SQEvent");
+  virtual ~Fun4AllEventIndex();
+
+  void SetNodeName(const std::string &name) { m_node_name = name; }
+  const std::string &GetNodeName() const { return m_node_name; }
+
+  void Clear();
+  void Add(const Key &key, const long long entry);
+  int  AddFromNode(PHCompositeNode *topNode, const long long entry);
+  int  ReadKey(PHCompositeNode *topNode, Key &key);
+  void Sort();
+
+  unsigned int Size() const { return m_items.size(); }
+  const Item &At(const unsigned int i) const { return m_items[i]; }
+  long long Find(const Key &key) const;
+
+  int Write(const std::string &file_name);
+  int Read (const std::string &file_name);
+
+ protected:
+  int CallGetter(TMethodCall *mc, void *obj, int &value) const;
+
+  std::string m_node_name;
+  std::vector<Item> m_items;
+  bool m_sorted;
+
+  TClass *m_class;
+  TMethodCall *m_get_run;
+  TMethodCall *m_get_spill;
+  TMethodCall *m_get_event;
+};
+
+#endif /* FUN4ALLEVENTINDEX_H__ */
@@ -32,7 +32,9 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <ctime>
 #include <exception>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -263,6 +265,10 @@ int Fun4AllServer::registerSubsystem(SubsysReco *subsystem, const string &topnod
     timer_map[timer_name.str()] = timer;
   }
   RetCodes.push_back(iret);  // vector with return codes
+  // resolve the TDirectory and timer once here instead of for every event
+  // (map elements do not move, so the timer pointer stays valid)
+  string subsysdirname = topnodename + "/" + subsystem->Name();
+  ModuleStats.push_back(ModuleStat(gROOT->GetDirectory(subsysdirname.c_str()), &timer_map[timer_name.str()]));
   return 0;
 }
 
@@ -309,6 +315,7 @@ int Fun4AllServer::unregisterSubsystemsNow()
     delete (*removeiter).first;
     // also update the vector with return codes
     RetCodes.erase(RetCodes.begin() + index);
+    ModuleStats.erase(ModuleStats.begin() + index);
     vector<Fun4AllOutputManager *>::iterator outiter;
     for (outiter = OutputManager.begin(); outiter != OutputManager.end(); ++outiter)
     {
@@ -533,9 +540,8 @@ int Fun4AllServer::process_event()
     {
       cout << "Fun4AllServer::process_event processing " << (*iter).first->Name() << endl;
     }
-    ostringstream newdirname;
-    newdirname << (*iter).second->getName() << "/" << (*iter).first->Name();
-    if (!gROOT->cd(newdirname.str().c_str()))
+    ModuleStat &modstat = ModuleStats[icnt];
+    if (!modstat.tdir || !modstat.tdir->cd())
     {
       cout << PHWHERE << "Unexpected TDirectory Problem cd'ing to "
            << (*iter).second->getName()
@@ -546,31 +552,17 @@ int Fun4AllServer::process_event()
     {
       if (verbosity >= VERBOSITY_EVEN_MORE)
       {
-        cout << "process_event: cded to " << newdirname.str().c_str() << endl;
+        cout << "process_event: cded to " << modstat.tdir->GetPath() << endl;
       }
     }
 
     try
     {
-      ostringstream timer_name;
-      timer_name << (*iter).first->Name() << "_" << (*iter).second->getName();
-      std::map<const std::string, PHTimer>::iterator titer = timer_map.find(timer_name.str());
-      bool timer_found = false;
-      if (titer != timer_map.end())
-      {
-        timer_found = true;
-	titer->second.restart();
-      }
-      else
-      {
-	cout << "could not find timer for " << timer_name << endl;
-      }
+      clock_t cpu_start = clock();
+      modstat.timer->restart();
       RetCodes[icnt] = (*iter).first->process_event((*iter).second);
-      if (timer_found)
-      {
-	titer->second.stop();
-      }
-
+      modstat.timer->stop();
+      modstat.Fill(modstat.timer->elapsed(), 1000. * (clock() - cpu_start) / CLOCKS_PER_SEC, RetCodes[icnt]);
     }
     catch (const exception &e)
     {
@@ -1055,6 +1047,11 @@ int Fun4AllServer::End()
   // done inside outfileclose())
   outfileclose();
 
+  if (!modulestatfile.empty())
+  {
+    WriteModuleStat(modulestatfile);
+  }
+
   if (ScreamEveryEvent)
   {
     cout << "*******************************************************************************" << endl;
@@ -1668,3 +1665,133 @@ void Fun4AllServer::PrintTimer(const string &name)
   }
   return;
 }
+
+Fun4AllServer::ModuleStat::ModuleStat(TDirectory *dir, PHTimer *tim)
+  : tdir(dir)
+  , timer(tim)
+  , ncall(0)
+  , nok(0)
+  , ndiscard(0)
+  , nabortevent(0)
+  , nabortrun(0)
+  , nother(0)
+  , wall_ms(0)
+  , cpu_ms(0)
+  , wall_max_ms(0)
+{
+  fill(lathist, lathist + NLATBIN, 0);
+}
+
+void Fun4AllServer::ModuleStat::Fill(const double wall, const double cpu, const int retcode)
+{
+  ncall++;
+  wall_ms += wall;
+  cpu_ms += cpu;
+  if (wall > wall_max_ms) wall_max_ms = wall;
+  switch (retcode)
+  {
+  case Fun4AllReturnCodes::EVENT_OK:
+    nok++;
+    break;
+  case Fun4AllReturnCodes::DISCARDEVENT:
+    ndiscard++;
+    break;
+  case Fun4AllReturnCodes::ABORTEVENT:
+    nabortevent++;
+    break;
+  case Fun4AllReturnCodes::ABORTRUN:
+    nabortrun++;
+    break;
+  default:
+    nother++;
+    break;
+  }
+  // bin 0 holds everything below 1 us, the last bin the overflow
+  int ibin = 0;
+  if (wall > 1e-3)
+  {
+    ibin = 1 + static_cast<int>(LATBINPERDECADE * log10(wall * 1e3));
+    if (ibin >= NLATBIN) ibin = NLATBIN - 1;
+  }
+  lathist[ibin]++;
+}
+
+double Fun4AllServer::ModuleStat::BinUpEdge(const int ibin)
+{
+  return 1e-3 * pow(10., static_cast<double>(ibin) / LATBINPERDECADE);  // in ms
+}
+
+double Fun4AllServer::ModuleStat::Percentile(const double frac) const
+{
+  if (ncall == 0) return 0;
+  unsigned long target = static_cast<unsigned long>(ceil(frac * ncall));
+  unsigned long sum = 0;
+  for (int ibin = 0; ibin < NLATBIN; ibin++)
+  {
+    sum += lathist[ibin];
+    if (sum >= target) return min(BinUpEdge(ibin), wall_max_ms);
+  }
+  return wall_max_ms;
+}
+
+void Fun4AllServer::PrintModuleStat(std::ostream &out) const
+{
+  out << "--------------------------------------" << endl
+      << "Module statistics of Fun4AllServer (times in ms):" << endl;
+  for (unsigned int i = 0; i < Subsystems.size(); i++)
+  {
+    const ModuleStat &st = ModuleStats[i];
+    out << Subsystems[i].first->Name() << " (" << Subsystems[i].second->getName() << "): "
+        << st.ncall << " calls, ok " << st.nok << ", discard " << st.ndiscard
+        << ", abort " << st.nabortevent << endl
+        << "  wall " << st.wall_ms << " (" << (st.ncall ? st.wall_ms / st.ncall : 0) << "/evt)"
+        << ", cpu " << st.cpu_ms << ", p50 " << st.Percentile(0.5)
+        << ", p99 " << st.Percentile(0.99) << ", max " << st.wall_max_ms << endl;
+  }
+}
+
+int Fun4AllServer::WriteModuleStat(const string &filename) const
+{
+  ofstream ofs(filename.c_str());
+  if (!ofs.is_open())
+  {
+    cout << PHWHERE << " Cannot open " << filename << " to write the module statistics" << endl;
+    return -1;
+  }
+  ofs << "{\n  \"latency_bin_edges_ms\": [";
+  for (int ibin = 0; ibin < ModuleStat::NLATBIN; ibin++)
+  {
+    ofs << (ibin ? ", " : "") << ModuleStat::BinUpEdge(ibin);
+  }
+  ofs << "],\n  \"modules\": [";
+  for (unsigned int i = 0; i < Subsystems.size(); i++)
+  {
+    const ModuleStat &st = ModuleStats[i];
+    ofs << (i ? "," : "") << "\n    {\"name\": \"" << Subsystems[i].first->Name() << "\""
+        << ", \"topnode\": \"" << Subsystems[i].second->getName() << "\""
+        << ", \"ncall\": " << st.ncall
+        << ", \"nok\": " << st.nok
+        << ", \"ndiscard\": " << st.ndiscard
+        << ", \"nabortevent\": " << st.nabortevent
+        << ", \"nabortrun\": " << st.nabortrun
+        << ", \"nother\": " << st.nother
+        << ", \"wall_ms\": " << st.wall_ms
+        << ", \"cpu_ms\": " << st.cpu_ms
+        << ", \"wall_max_ms\": " << st.wall_max_ms
+        << ", \"p50_ms\": " << st.Percentile(0.5)
+        << ", \"p90_ms\": " << st.Percentile(0.9)
+        << ", \"p99_ms\": " << st.Percentile(0.99)
+        << ", \"latency_hist\": [";
+    for (int ibin = 0; ibin < ModuleStat::NLATBIN; ibin++)
+    {
+      ofs << (ibin ? ", " : "") << st.lathist[ibin];
+    }
+    ofs << "]}";
+  }
+  ofs << "\n  ]\n}\n";
+  if (verbosity > 0)
+  {
+    cout << "Fun4AllServer: module statistics written to " << filename << endl;
+  }
+  return 0;
+}
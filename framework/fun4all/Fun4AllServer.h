@@ -104,7 +104,36 @@ class Fun4AllServer : public Fun4AllBase
   void KeepDBConnection(const int i = 1) { keep_db_connected = i; }
   void PrintTimer(const std::string &name = "");
 
+  //! per-module process_event statistics (wall/CPU time, return codes, latency histogram)
+  void PrintModuleStat(std::ostream &out = std::cout) const;
+  //! write the per-module statistics as JSON, also done in End() if a file name is set
+  int WriteModuleStat(const std::string &filename) const;
+  void SetModuleStatFile(const std::string &filename) { modulestatfile = filename; }
+
  protected:
+  //! bookkeeping slot of one registered subsystem, filled without lookups in process_event
+  struct ModuleStat
+  {
+    static const int NLATBIN = 64;  // log-spaced latency bins, LATBINPERDECADE per decade from 1 us
+    static const int LATBINPERDECADE = 8;
+    TDirectory *tdir;
+    PHTimer *timer;
+    unsigned long ncall;
+    unsigned long nok;
+    unsigned long ndiscard;
+    unsigned long nabortevent;
+    unsigned long nabortrun;
+    unsigned long nother;
+    double wall_ms;
+    double cpu_ms;
+    double wall_max_ms;
+    unsigned long lathist[NLATBIN];
+    ModuleStat(TDirectory *dir = 0, PHTimer *tim = 0);
+    void Fill(const double wall, const double cpu, const int retcode);
+    double Percentile(const double frac) const;
+    static double BinUpEdge(const int ibin);
+  };
+
   Fun4AllServer(const std::string &name = "Fun4AllServer");
   int InitNodeTree(PHCompositeNode *topNode);
   int CountOutNodes(PHCompositeNode *startNode);
@@ -124,6 +153,8 @@ class Fun4AllServer : public Fun4AllBase
   std::vector<std::pair<SubsysReco *, PHCompositeNode *> > Subsystems;
   std::vector<std::pair<SubsysReco *, PHCompositeNode *> > DeleteSubsystems;
   std::vector<int> RetCodes;
+  std::vector<ModuleStat> ModuleStats;  // parallel to Subsystems
+  std::string modulestatfile;
   std::vector<Fun4AllOutputManager *> OutputManager;
   std::vector<TDirectory *> TDirCollection;
   Fun4AllHistoManager *ServerHistoManager;
@@ -23,17 +23,56 @@ class PHIODataNode : public PHDataNode <T>
   T* operator*() {return this->getData();}
   PHIODataNode(T*, const std::string &);
   PHIODataNode(T*, const std::string &, const std::string &);
-  virtual ~PHIODataNode() {}
+  virtual ~PHIODataNode();
   typedef PHTypedNodeIterator<T> iterator;
 
+  virtual void materialize();
+  void setLazySource(PHNodeIOManager *io, TBranch *branch);
+
  protected:
   virtual bool write(PHIOManager *, const std::string& = "");
-  PHIODataNode() {}
+  PHIODataNode() : lazyIO(0), lazyBranch(0), lazyLoaded(-1) {}
+
+  // Set only when the node is read lazily by PHNodeIOManager
+  PHNodeIOManager *lazyIO;
+  TBranch *lazyBranch;
+  long long lazyLoaded; // serial number of the read held by the payload
 };
 
+template <class T>
+PHIODataNode<T>::~PHIODataNode()
+{
+  if (lazyIO)
+    {
+      lazyIO->forgetLazyNode(this);
+    }
+}
+
+template <class T>
+void
+PHIODataNode<T>::materialize()
+{
+  if (lazyIO)
+    {
+      lazyIO->readLazyBranch(lazyBranch, lazyLoaded);
+    }
+}
+
+template <class T>
+void
+PHIODataNode<T>::setLazySource(PHNodeIOManager *io, TBranch *branch)
+{
+  lazyIO = io;
+  lazyBranch = branch;
+  lazyLoaded = -1;
+}
+
 template <class T>
 PHIODataNode<T>::PHIODataNode(T* d, const std::string& name)
-  : PHDataNode<T>(d, name)
+  : PHDataNode<T>(d, name),
+    lazyIO(0),
+    lazyBranch(0),
+    lazyLoaded(-1)
 {
   this->type = "PHIODataNode";
   TObject *TO = static_cast<TObject *> (d);
@@ -43,7 +82,10 @@ PHIODataNode<T>::PHIODataNode(T* d, const std::string& name)
 template <class T>
 PHIODataNode<T>::PHIODataNode(T* d, const std::string& name,
                               const std::string& objtype)
-  : PHDataNode<T>(d, name, objtype)
+  : PHDataNode<T>(d, name, objtype),
+    lazyIO(0),
+    lazyBranch(0),
+    lazyLoaded(-1)
 {
   this->type = "PHIODataNode";
   TObject *TO = static_cast<TObject *> (d);
@@ -61,6 +103,7 @@ PHIODataNode<T>::write(PHIOManager* IOManager, const std::string& path)
         {
 	  std::string newPath = path + phooldefs::branchpathdelim + this->name;
 	  bool bret = false;
+	  materialize(); // an unread lazy payload must not be written stale
 	  if (dynamic_cast<TObject *> (this->data.data))
 	    {
 	      bret =  np->write(&(this->data.tobj), newPath);
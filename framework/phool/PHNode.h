@@ -39,6 +39,8 @@ public:
   virtual void print(const std::string &) = 0;
   virtual void forgetMe(PHNode*) = 0;
   virtual bool write(PHIOManager *, const std::string& = "") = 0;
+  // make sure the payload is filled (used by nodes read lazily from file)
+  virtual void materialize() {}
 
   virtual void setResetFlag(const int val);
   virtual PHBoolean getResetFlag() const;
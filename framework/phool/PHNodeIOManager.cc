@@ -42,6 +42,9 @@ PHNodeIOManager::PHNodeIOManager ():
   accessMode(PHReadOnly),
   CompressionLevel(3),
   realTimeSave(false), 
+  lazyRead(false),
+  currentEntry(-1),
+  readSerial(0),
   isFunctionalFlag(0)
 {}
 
@@ -51,7 +54,10 @@ PHNodeIOManager::PHNodeIOManager (const string& f,
   tree(NULL),
   TreeName("T"),
   CompressionLevel(3),
-  realTimeSave(false)
+  realTimeSave(false),
+  lazyRead(false),
+  currentEntry(-1),
+  readSerial(0)
 {
   isFunctionalFlag = setFile(f, "titled by PHOOL", a) ? 1 : 0;
 }
@@ -62,7 +68,10 @@ PHNodeIOManager::PHNodeIOManager (const string& f, const string& title,
   tree(NULL),
   TreeName("T"),
   CompressionLevel(3),
-  realTimeSave(false)
+  realTimeSave(false),
+  lazyRead(false),
+  currentEntry(-1),
+  readSerial(0)
 {
   isFunctionalFlag = setFile(f, title , a) ? 1 : 0;
 }
@@ -73,7 +82,10 @@ PHNodeIOManager::PHNodeIOManager (const string& f, const PHAccessType a,
   tree(NULL),
   TreeName("T"),
   CompressionLevel(3),
-  realTimeSave(false)
+  realTimeSave(false),
+  lazyRead(false),
+  currentEntry(-1),
+  readSerial(0)
 {
   if (treeindex != PHEventTree)
     {
@@ -86,6 +98,13 @@ PHNodeIOManager::PHNodeIOManager (const string& f, const PHAccessType a,
 
 PHNodeIOManager::~PHNodeIOManager ()
 {
+  // the nodes outlive this manager, so cut their link to our branches
+  vector<PHIODataNode<TObject>*>::iterator iter;
+  for (iter = lazyNodes.begin(); iter != lazyNodes.end(); ++iter)
+    {
+      (*iter)->setLazySource(0, 0);
+    }
+  lazyNodes.clear();
   closeFile ();
   //   if (tree)
   //     {
@@ -344,6 +363,20 @@ PHNodeIOManager::readEventFromFile(size_t requestedEvent)
   // to cd() in the current file before trying to fetch any event,
   // otherwise mixing of reading 2.25/03 DST with writing some
   // 3.01/05 trees will fail.
+  if (lazyRead)
+    {
+      // Only position the tree; the branches are read on demand.
+      size_t entry = requestedEvent ? requestedEvent : eventNumber;
+      if (entry >= static_cast<size_t>(tree->GetEntries()))
+        {
+          return False;
+        }
+      eventNumber = entry + 1;
+      currentEntry = entry;
+      readSerial++; // also invalidates payloads of a re-read entry
+      return True;
+    }
+
   string currdir = gDirectory->GetPath();
   TFile* file_ptr = gFile; // save current gFile
   file->cd();
@@ -389,6 +422,12 @@ PHNodeIOManager::readSpecific(size_t requestedEvent, const char* objectName)
       TBranch* branch = p->second;
       if (branch)
         {
+          if (lazyRead)
+            {
+              // the other lazy nodes must follow this entry, not the previous one
+              currentEntry = requestedEvent;
+              readSerial++;
+            }
           return branch->GetEvent(requestedEvent);
         }
     }
@@ -546,6 +585,11 @@ PHNodeIOManager::reconstructNodeTree(PHCompositeNode* topNode)
 	  newIODataNode->setObjectType("PHObject");
 	}
       thisBranch->SetAddress(&(newIODataNode->data));
+      if (lazyRead)
+	{
+	  newIODataNode->setLazySource(this, thisBranch);
+	  lazyNodes.push_back(newIODataNode);
+	}
 	      for (j = 1; j < splitvec.size() - 1; j++)
 	{
 	  nodeIter.cd("..");
@@ -555,6 +599,51 @@ PHNodeIOManager::reconstructNodeTree(PHCompositeNode* topNode)
   return topNode;
 }
 
+void
+PHNodeIOManager::readLazyBranch(TBranch *branch, long long &loadedRead)
+{
+  if (!branch || currentEntry < 0 || loadedRead == readSerial)
+    {
+      return;
+    }
+  string currdir = gDirectory->GetPath();
+  TFile* file_ptr = gFile; // same gFile protection as in readEventFromFile
+  file->cd();
+  int bytesRead = branch->GetEntry(currentEntry);
+  gFile = file_ptr;
+  gROOT->cd(currdir.c_str());
+  if (bytesRead == -1)
+    {
+      cout << PHWHERE << "Error: Input TTree corrupt, exiting now" << endl;
+      exit(1);
+    }
+  loadedRead = readSerial;
+}
+
+void
+PHNodeIOManager::materializeAll()
+{
+  vector<PHIODataNode<TObject>*>::iterator iter;
+  for (iter = lazyNodes.begin(); iter != lazyNodes.end(); ++iter)
+    {
+      (*iter)->materialize();
+    }
+}
+
+void
+PHNodeIOManager::forgetLazyNode(PHNode *node)
+{
+  vector<PHIODataNode<TObject>*>::iterator iter;
+  for (iter = lazyNodes.begin(); iter != lazyNodes.end(); ++iter)
+    {
+      if (static_cast<PHNode*>(*iter) == node)
+	{
+	  lazyNodes.erase(iter);
+	  return;
+	}
+    }
+}
+
 void
 PHNodeIOManager::selectObjectToRead(const char* objectName, PHBoolean readit)
 {
@@ -8,12 +8,15 @@
 #include "PHIOManager.h"
 #include <string>
 #include <map>
+#include <vector>
 
 
 class TObject;
 class TFile;
 class TTree;
 class TBranch;
+class PHNode;
+template <class T> class PHIODataNode;
 
 class PHNodeIOManager : public PHIOManager { 
 public: 
@@ -40,6 +43,17 @@ public:
    std::map<std::string,TBranch*> *GetBranchMap();
    void SetRealTimeSave(const bool onoff) { realTimeSave = onoff; }
 
+   // In the lazy mode a branch is read only when its node is first
+   // accessed (findNode::getClass) in the current event.
+   // It has to be set before the first read.
+   void SetLazyRead(const bool onoff) { lazyRead = onoff; }
+   bool GetLazyRead() const { return lazyRead; }
+   // The entry used by the lazy nodes is set by read() and readSpecific().
+   // setEventNumber() only moves the next entry to be read, as in the normal mode.
+   void readLazyBranch(TBranch *branch, long long &loadedRead);
+   void materializeAll();
+   void forgetLazyNode(PHNode *node);
+
 public:
    PHBoolean write(TObject**, const std::string&);
 private:
@@ -56,6 +70,10 @@ private:
   int   accessMode;
   int   CompressionLevel;
   bool  realTimeSave;
+  bool  lazyRead;
+  long long currentEntry; // entry selected by the last read in the lazy mode
+  long long readSerial;   // incremented on every read in the lazy mode
+  std::vector<PHIODataNode<TObject>*> lazyNodes;
   std::map<std::string,TBranch*> fBranches ;
   std::map<std::string,PHBoolean> objectToRead ;
 
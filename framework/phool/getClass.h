@@ -23,6 +23,7 @@ namespace findNode
 	{
 	  return NULL;
 	}
+      FoundNode->materialize(); // read the payload now if the node is lazy
       // first test if it is a PHDataNode
       PHDataNode<T> *DNode = dynamic_cast<PHDataNode<T>*>(FoundNode);
       if (DNode)
@@ -80,6 +80,8 @@ void recoConsts::set_defaults()
   set_DoubleFlag("BAD_HIT_REJECTION", 3.);
   set_DoubleFlag("MERGE_THRESH", 0.015);
   set_DoubleFlag("RESOLUTION_FACTOR", 1.6);
+  //straight-line transport in the field-free gaps of the Kalman filter, neglects the energy loss there
+  set_BoolFlag("KF_STRAIGHT_LINE", false);
 
   set_DoubleFlag("X_BEAM", 0.);
   set_DoubleFlag("Y_BEAM", 0.);
@@ -95,6 +97,9 @@ void recoConsts::set_defaults()
   set_IntFlag("NSTEPS_SHIELDING", 50);
   set_IntFlag("NSTEPS_TARGET", 100);
 
+  //storage of the SRecTrack node covariances: 0 - half float, 1 - float, 2 - double
+  set_IntFlag("SRECTRACK_DETAIL", 1);
+
   set_DoubleFlag("TDCTimeOffset", 0.);
 
   set_DoubleFlag("RejectWinDC0", 0.12);
@@ -15,6 +15,7 @@ from Kun to E1039 experiment in Fun4All framework
 #include <gsl/gsl_rng.h>
 #endif
 
+#include <vector>
 #include <TGenPhaseSpace.h>
 #include <g4main/PHG4ParticleGeneratorBase.h>
 
@@ -27,6 +28,7 @@ class SQMCEvent;
 class SQDimuon;
 class SQDimuonVector;
 class SQPrimaryVertexGen;
+class TGeoNode;
 
 //==========
 class SQPrimaryParticleGen: public PHG4ParticleGeneratorBase
@@ -71,6 +73,15 @@ public:
     void enableDrellYanGen(){_DrellYanGen = true;}
     bool _DrellYanGen;
     bool drellyanMode;
+    //! Generate Drell-Yan (mass, xF) following a cross-section table made at Init, instead of uniformly.
+    //! The event weight carries the correction, so it stays close to the cross section per generated event.
+    void enableDrellYanImportanceSampling(const int nMassBins = 100, const int nXFBins = 100, const double uniformFrac = 0.05){
+      _DrellYanImportance = true;
+      _dyNMass = nMassBins;
+      _dyNXF = nXFBins;
+      _dyUniformFrac = uniformFrac;
+    }
+    bool _DrellYanImportance;
     void enableJPsiGen(){_JPsiGen = true;}
     bool _JPsiGen;
     void enablePsipGen(){_PsipGen = true;}
@@ -95,6 +106,8 @@ public:
 
     SQDimuon* _dim_gen; //< To hold the kinematics of a dimuon generated
 
+    TGeoNode* _geomTop; //< Top node of the geometry used by the vertex generator, looked up once per run
+
     //Pythia generator
     Pythia8::Pythia ppGen;    //!< Pythia pp generator
     Pythia8::Pythia pnGen;    //!< Pythia pn generator
@@ -123,6 +136,18 @@ public:
     double zOffsetMin = -1.;
     double zOffsetMax = 1.;
 
+    //!Drell-Yan cross-section pieces
+    double drellYanPDF(double x1, double x2, double mass, double zOverA, double nOverA);
+    double drellYanKFactor(double mass);
+
+    //!Importance sampling of the Drell-Yan (mass, xF)
+    void initDrellYanGrid();
+    void sampleDrellYanMassXF(double& mass, double& xF, double& weight);
+    int _dyNMass;
+    int _dyNXF;
+    double _dyUniformFrac;            //< fraction of the events generated uniformly
+    std::vector<double> _dyCDF;       //< cumulative probability of the (mass, xF) cells, mass-major
+
     void InsertMuonPair(TVector3& vtx);
     void InsertEventInfo(double xsec, TVector3& vtx);
 };
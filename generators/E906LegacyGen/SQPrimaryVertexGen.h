@@ -31,12 +31,14 @@ public:
     //Initialize files
     void Initfile();
 
-    //Initialize at the begining of Run
+    //Initialize at the begining of Run, the material tables are re-built from the geometry afterwards
     void InitRun(PHCompositeNode* topNode);
 
-    //Tree traversal
+    //Generate one vertex from the beamline volumes under node
     void traverse(TGeoNode* node, double&xvertex,double&yvertex,double&zvertex);
 
+    //Generate n vertices at once, with the proton/neutron ratio of the piece hit by each of them
+    void generateVertices(TGeoNode* node, unsigned int n, std::vector<TVector3>& vertices, std::vector<double>& pARatios);
 
     //get the vertex generated
     // TVector3 generateVertex();
@@ -49,24 +51,43 @@ public:
     void findInteractingPiece();
 
     //get the proton/neutron ratio of the piece, must be called after generateVertex
-    double getPARatio() { return interactables[index].protonPerc(); }
+    double getPARatio() { return current->interactables[index].protonPerc(); }
     
     //get the relative luminosity on this target
     //double getLuminosity() { return p_config->biasVertexGen ? interactables[index].prob : probSum; }
-    double getLuminosity() { return  probSum; }
+    double getLuminosity() { return current->probSum; }
 
    //get the reference to the chosen objects
    //const BeamlineObject& getInteractable() { return interactables[index]; } 
 
 private:
-    //Array of beamline objects
-    unsigned int nPieces;
-    double probSum;
-    double accumulatedProbs[100]; //for now set to no more than 100 objects
- 
-      //vector of the interactable stuff
-    std::vector<SQBeamlineObject> interactables;
+    //Beamline objects seen by the beam in one transverse region, with the alias table to sample them
+    struct VertexTable
+    {
+        VertexTable(): built(false), probSum(0.) {}
 
+        bool built;
+        double probSum;
+        std::vector<SQBeamlineObject> interactables;
+
+        //Walker alias table: piece i is taken if the uniform fraction is below aliasProb[i], aliasIndex[i] otherwise
+        std::vector<double> aliasProb;
+        std::vector<unsigned int> aliasIndex;
+    };
+
+    //Build the table of the region which contains (x, y)
+    void buildTable(TGeoNode* node, double x, double y, VertexTable& table);
+    void clearTables();
+
+    //The transverse regions differ by the holes of the shielding, target and collimator the beam goes through
+    static const int nRegions = 8;
+    static int regionKey(double x, double y);
+
+    VertexTable tables[nRegions];
+
+    //geometry the tables were built from and the table used by the last vertex
+    TGeoNode* geomNode;
+    VertexTable* current;
 
     //the index of the piece that is chosen
     int index;
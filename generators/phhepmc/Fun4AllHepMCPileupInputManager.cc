@@ -14,9 +14,11 @@
 #include <phool/PHCompositeNode.h>
 #include <phool/PHDataNode.h>
 #include <phool/PHRandomSeed.h>
+#include <phool/phool.h>
 
 #include <HepMC/GenEvent.h>
 #include <HepMC/IO_GenEvent.h>
+#include <HepMC/Units.h>
 
 #include <TPRegexp.h>
 #include <TString.h>
@@ -30,6 +32,7 @@
 #include <boost/iostreams/filter/gzip.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
 
+#include <algorithm>
 #include <cstdlib>
 #include <memory>
 
@@ -53,6 +56,7 @@ Fun4AllHepMCPileupInputManager::Fun4AllHepMCPileupInputManager(
   _max_crossing(0)
   ,  // recalculated
   _first_run(true)
+  , _pool_size(0)
 {
 
   //! repeatedly read the input file
@@ -70,12 +74,21 @@ Fun4AllHepMCPileupInputManager::Fun4AllHepMCPileupInputManager(
   unsigned int seed = PHRandomSeed();  // fixed seed is handled in this funtcion
   gsl_rng_set(RandomGenerator, seed);
 
+  PoolRandomGenerator = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(PoolRandomGenerator, PHRandomSeed());
+
   return;
 }
 
 Fun4AllHepMCPileupInputManager::~Fun4AllHepMCPileupInputManager()
 {
   gsl_rng_free(RandomGenerator);
+  gsl_rng_free(PoolRandomGenerator);
+}
+
+void Fun4AllHepMCPileupInputManager::set_pool_seed(const unsigned int seed)
+{
+  gsl_rng_set(PoolRandomGenerator, seed);
 }
 
 int Fun4AllHepMCPileupInputManager::run(const int nevents)
@@ -96,6 +109,12 @@ int Fun4AllHepMCPileupInputManager::run(const int nevents)
       cout << " _max_crossing = " << _max_crossing;
       cout << ". Start first event."<<endl;
     }
+
+    if (_pool.empty() && (_pool_size > 0 || !_pool_cache.empty()))
+    {
+      int iret = _pool_cache.empty() ? FillPool() : ReadPoolCache(_pool_cache);
+      if (iret) return iret;
+    }
   }
 
   // toss multiple crossings all the way back
@@ -111,77 +130,14 @@ int Fun4AllHepMCPileupInputManager::run(const int nevents)
     {
       double t0 = crossing_time;
 
-      // loop until retrieve a valid event
-      while (true)
+      if (!_pool.empty())
       {
-        if (!isopen)
-        {
-          if (!filelist.size())
-          {
-            if (verbosity > 0)
-            {
-              cout << Name() << ": No Input file open" << endl;
-            }
-            return -1;
-          }
-          else
-          {
-            if (OpenNextFile())
-            {
-              cout << Name() << ": No Input file from filelist opened" << endl;
-              return -1;
-            }
-          }
-        }
-
-        if (save_evt)
-        {  // if an event was pushed back, copy saved pointer and
-           // reset save_evt pointer
-          evt = save_evt;
-          save_evt = NULL;
-        }
-        else
-        {
-          if (readoscar)
-          {
-            evt = ConvertFromOscar();
-          }
-          else
-          {
-            evt = ascii_in->read_next_event();
-          }
-        }
-
-        if (!evt)
-        {
-          if (verbosity > 1)
-          {
-            cout << "error type: " << ascii_in->error_type()
-                 << ", rdstate: " << ascii_in->rdstate() << endl;
-          }
-          fileclose();
-        }
-        else
-        {
-          mySyncManager->CurrentEvent(evt->event_number());
-          if (verbosity > 0)
-          {
-            cout << "hepmc evt no: " << evt->event_number() << endl;
-          }
-        }
-        events_total++;
-        events_thisfile++;
-        // check if the local SubsysReco discards this event
-        if (RejectEvent() != Fun4AllReturnCodes::EVENT_OK)
-        {
-          ResetEvent();
-          //	goto readagain;
-        }
-        else
-        {
-          break;  // got the evt, move on
-        }
-      }  // loop until retrieve a valid event
+        evt = UnpackPoolEvent(_pool[gsl_rng_uniform_int(PoolRandomGenerator, _pool.size())]);
+      }
+      else if (ReadNextValidEvent())
+      {
+        return -1;
+      }
 
       PHHepMCGenEventMap *geneventmap = hepmc_helper.get_geneventmap();
       PHHepMCGenEvent *genevent = nullptr;
@@ -209,3 +165,280 @@ int Fun4AllHepMCPileupInputManager::run(const int nevents)
 
   return 0;
 }
+
+int Fun4AllHepMCPileupInputManager::ReadNextValidEvent()
+{
+  // loop until retrieve a valid event
+  while (true)
+  {
+    if (!isopen)
+    {
+      if (!filelist.size())
+      {
+        if (verbosity > 0)
+        {
+          cout << Name() << ": No Input file open" << endl;
+        }
+        return -1;
+      }
+      else
+      {
+        if (OpenNextFile())
+        {
+          cout << Name() << ": No Input file from filelist opened" << endl;
+          return -1;
+        }
+      }
+    }
+
+    if (save_evt)
+    {  // if an event was pushed back, copy saved pointer and
+       // reset save_evt pointer
+      evt = save_evt;
+      save_evt = NULL;
+    }
+    else
+    {
+      if (readoscar)
+      {
+        evt = ConvertFromOscar();
+      }
+      else
+      {
+        evt = ascii_in->read_next_event();
+      }
+    }
+
+    if (!evt)
+    {
+      if (verbosity > 1)
+      {
+        cout << "error type: " << ascii_in->error_type()
+             << ", rdstate: " << ascii_in->rdstate() << endl;
+      }
+      fileclose();
+    }
+    else
+    {
+      mySyncManager->CurrentEvent(evt->event_number());
+      if (verbosity > 0)
+      {
+        cout << "hepmc evt no: " << evt->event_number() << endl;
+      }
+    }
+    events_total++;
+    events_thisfile++;
+    // check if the local SubsysReco discards this event
+    if (RejectEvent() != Fun4AllReturnCodes::EVENT_OK)
+    {
+      ResetEvent();
+      //	goto readagain;
+    }
+    else
+    {
+      break;  // got the evt, move on
+    }
+  }  // loop until retrieve a valid event
+
+  return 0;
+}
+
+//! Decode _pool_size events from the input files into the pool
+int Fun4AllHepMCPileupInputManager::FillPool()
+{
+  _pool.clear();
+  _pool.reserve(_pool_size);
+  while (_pool.size() < _pool_size)
+  {
+    if (ReadNextValidEvent()) break;
+    if (!evt) continue;
+
+    _pool.push_back(PoolEvent());
+    PackPoolEvent(evt, _pool.back());
+    delete evt;
+    evt = NULL;
+  }
+
+  if (_pool.empty())
+  {
+    cout << Name() << ": No event for the pileup pool" << endl;
+    return -1;
+  }
+  if (Verbosity() >= VERBOSITY_SOME)
+  {
+    cout << Name() << ": pileup pool filled with " << _pool.size() << " events" << endl;
+  }
+  return 0;
+}
+
+namespace
+{
+  const char pool_cache_magic[8] = {'P', 'H', 'M', 'C', 'P', 'O', 'O', 'L'};
+  const int pool_cache_version = 1;
+}
+
+/**
+ * The cache is a plain binary dump in the byte order of the machine which wrote it:
+ * a header (magic, version, number of events) followed by, for each event, the event number,
+ * the number of vertices and the vertices, the number of particles and the particles.
+ */
+int Fun4AllHepMCPileupInputManager::write_pool_cache(const string &filename)
+{
+  if (_pool.empty())
+  {
+    if (_pool_size == 0)
+    {
+      cout << PHWHERE << " set_pool_size() first" << endl;
+      return -1;
+    }
+    if (FillPool()) return -1;
+  }
+
+  ofstream out(filename.c_str(), ios::binary);
+  if (!out)
+  {
+    cout << PHWHERE << " cannot open " << filename << endl;
+    return -1;
+  }
+
+  unsigned int nevt = _pool.size();
+  out.write(pool_cache_magic, sizeof(pool_cache_magic));
+  out.write(reinterpret_cast<const char *>(&pool_cache_version), sizeof(int));
+  out.write(reinterpret_cast<const char *>(&nevt), sizeof(unsigned int));
+  for (vector<PoolEvent>::const_iterator iter = _pool.begin(); iter != _pool.end(); ++iter)
+  {
+    unsigned int nvtx = iter->vertices.size();
+    unsigned int npar = iter->particles.size();
+    out.write(reinterpret_cast<const char *>(&iter->event_number), sizeof(int));
+    out.write(reinterpret_cast<const char *>(&nvtx), sizeof(unsigned int));
+    out.write(reinterpret_cast<const char *>(iter->vertices.data()), nvtx * sizeof(PoolVertex));
+    out.write(reinterpret_cast<const char *>(&npar), sizeof(unsigned int));
+    out.write(reinterpret_cast<const char *>(iter->particles.data()), npar * sizeof(PoolParticle));
+  }
+
+  if (!out)
+  {
+    cout << PHWHERE << " error writing " << filename << endl;
+    return -1;
+  }
+  if (Verbosity() >= VERBOSITY_SOME)
+  {
+    cout << Name() << ": wrote " << nevt << " pileup events to " << filename << endl;
+  }
+  return 0;
+}
+
+int Fun4AllHepMCPileupInputManager::ReadPoolCache(const string &filename)
+{
+  ifstream in(filename.c_str(), ios::binary);
+  if (!in)
+  {
+    cout << PHWHERE << " cannot open " << filename << endl;
+    return -1;
+  }
+
+  char magic[sizeof(pool_cache_magic)];
+  int version = 0;
+  unsigned int nevt = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char *>(&version), sizeof(int));
+  in.read(reinterpret_cast<char *>(&nevt), sizeof(unsigned int));
+  if (!in || !equal(magic, magic + sizeof(magic), pool_cache_magic) || version != pool_cache_version)
+  {
+    cout << PHWHERE << " " << filename << " is not a pileup pool cache of version " << pool_cache_version << endl;
+    return -1;
+  }
+  if (_pool_size > 0 && _pool_size < nevt) nevt = _pool_size;
+
+  _pool.clear();
+  _pool.resize(nevt);
+  for (unsigned int i = 0; i < nevt; ++i)
+  {
+    PoolEvent &poolevt = _pool[i];
+    unsigned int nvtx = 0;
+    unsigned int npar = 0;
+    in.read(reinterpret_cast<char *>(&poolevt.event_number), sizeof(int));
+    in.read(reinterpret_cast<char *>(&nvtx), sizeof(unsigned int));
+    if (!in) break;
+    poolevt.vertices.resize(nvtx);
+    in.read(reinterpret_cast<char *>(poolevt.vertices.data()), nvtx * sizeof(PoolVertex));
+    in.read(reinterpret_cast<char *>(&npar), sizeof(unsigned int));
+    if (!in) break;
+    poolevt.particles.resize(npar);
+    in.read(reinterpret_cast<char *>(poolevt.particles.data()), npar * sizeof(PoolParticle));
+    if (!in) break;
+  }
+
+  if (!in)
+  {
+    cout << PHWHERE << " " << filename << " is truncated" << endl;
+    _pool.clear();
+    return -1;
+  }
+  if (Verbosity() >= VERBOSITY_SOME)
+  {
+    cout << Name() << ": pileup pool read with " << _pool.size() << " events from " << filename << endl;
+  }
+  return 0;
+}
+
+void Fun4AllHepMCPileupInputManager::PackPoolEvent(const HepMC::GenEvent *genevt, PoolEvent &poolevt) const
+{
+  double mom_unit = HepMC::Units::conversion_factor(genevt->momentum_unit(), HepMC::Units::GEV);
+  double len_unit = HepMC::Units::conversion_factor(genevt->length_unit(), HepMC::Units::MM);
+
+  poolevt.event_number = genevt->event_number();
+  poolevt.vertices.clear();
+  poolevt.particles.clear();
+
+  map<const HepMC::GenVertex *, int> vtx_index;
+  for (HepMC::GenEvent::vertex_const_iterator v = genevt->vertices_begin(); v != genevt->vertices_end(); ++v)
+  {
+    vtx_index[*v] = poolevt.vertices.size();
+    PoolVertex vtx;
+    vtx.x = (*v)->position().x() * len_unit;
+    vtx.y = (*v)->position().y() * len_unit;
+    vtx.z = (*v)->position().z() * len_unit;
+    vtx.t = (*v)->position().t() * len_unit;
+    poolevt.vertices.push_back(vtx);
+  }
+
+  for (HepMC::GenEvent::particle_const_iterator p = genevt->particles_begin(); p != genevt->particles_end(); ++p)
+  {
+    PoolParticle par;
+    par.px = (*p)->momentum().px() * mom_unit;
+    par.py = (*p)->momentum().py() * mom_unit;
+    par.pz = (*p)->momentum().pz() * mom_unit;
+    par.e = (*p)->momentum().e() * mom_unit;
+    par.m = (*p)->generated_mass() * mom_unit;
+    par.pdg = (*p)->pdg_id();
+    par.status = (*p)->status();
+    par.prod_vtx = (*p)->production_vertex() ? vtx_index[(*p)->production_vertex()] : -1;
+    par.end_vtx = (*p)->end_vertex() ? vtx_index[(*p)->end_vertex()] : -1;
+    poolevt.particles.push_back(par);
+  }
+}
+
+HepMC::GenEvent *Fun4AllHepMCPileupInputManager::UnpackPoolEvent(const PoolEvent &poolevt) const
+{
+  HepMC::GenEvent *genevt = new HepMC::GenEvent(HepMC::Units::GEV, HepMC::Units::MM);
+  genevt->set_event_number(poolevt.event_number);
+
+  vector<HepMC::GenVertex *> vertices(poolevt.vertices.size());
+  for (unsigned int i = 0; i < poolevt.vertices.size(); ++i)
+  {
+    const PoolVertex &vtx = poolevt.vertices[i];
+    vertices[i] = new HepMC::GenVertex(HepMC::FourVector(vtx.x, vtx.y, vtx.z, vtx.t));
+    genevt->add_vertex(vertices[i]);
+  }
+
+  for (vector<PoolParticle>::const_iterator par = poolevt.particles.begin(); par != poolevt.particles.end(); ++par)
+  {
+    HepMC::GenParticle *p = new HepMC::GenParticle(HepMC::FourVector(par->px, par->py, par->pz, par->e), par->pdg, par->status);
+    p->set_generated_mass(par->m);
+    if (par->prod_vtx >= 0) vertices[par->prod_vtx]->add_particle_out(p);
+    if (par->end_vtx >= 0) vertices[par->end_vtx]->add_particle_in(p);
+  }
+
+  return genevt;
+}
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <fstream>
 #include <iostream>
 
@@ -46,8 +47,52 @@ class Fun4AllHepMCPileupInputManager : public Fun4AllHepMCInputManager
   void set_collision_rate(double Hz) {_collision_rate = Hz;}
   /// time between bunch crossing in ns
   void set_time_between_crossings(double nsec) {_time_between_crossings = nsec;}
-  
+
+  //! Pre-decoded pileup pool
+  //! Decode this many background events once at the first event and draw every collision from them,
+  //! randomly with replacement, instead of parsing the input for each collision. 0 (default) disables the pool.
+  //! Only the vertices and particles are kept, the other event information (weights, PDF info...) is dropped.
+  void set_pool_size(const unsigned int n) {_pool_size = n;}
+  //! Seed of the sampling from the pool, taken from PHRandomSeed() by default
+  void set_pool_seed(const unsigned int seed);
+  //! Fill the pool from a binary cache file written by write_pool_cache() instead of the input files
+  void set_pool_cache(const std::string &filename) {_pool_cache = filename;}
+  //! Decode set_pool_size() events from the input files (HepMC or Oscar) and write them to a binary cache file.
+  //! The manager has to be registered to Fun4AllServer and have its input files set. The pool is then also used by run().
+  int write_pool_cache(const std::string &filename);
+
  private:
+  //! Read the next event accepted by the local SubsysReco into evt, non-zero if no input is left
+  int ReadNextValidEvent();
+
+  //! One background event of the pool, momenta in GeV and positions in mm
+  struct PoolVertex
+  {
+    double x, y, z, t;
+  };
+  struct PoolParticle
+  {
+    double px, py, pz, e, m;
+    int pdg;
+    int status;
+    int prod_vtx;  // index in the vertex list, -1 if none
+    int end_vtx;
+  };
+  struct PoolEvent
+  {
+    int event_number;
+    std::vector<PoolVertex> vertices;
+    std::vector<PoolParticle> particles;
+  };
+
+  int FillPool();
+  int ReadPoolCache(const std::string &filename);
+  void PackPoolEvent(const HepMC::GenEvent *genevt, PoolEvent &poolevt) const;
+  HepMC::GenEvent *UnpackPoolEvent(const PoolEvent &poolevt) const;
+
+  unsigned int _pool_size;
+  std::string _pool_cache;
+  std::vector<PoolEvent> _pool;
 
   /// past times are negative, future times are positive
   double _min_integration_time;
@@ -66,6 +111,7 @@ class Fun4AllHepMCPileupInputManager : public Fun4AllHepMCInputManager
 
 #ifndef __CINT__
   gsl_rng *RandomGenerator;
+  gsl_rng *PoolRandomGenerator;
 #endif
 
 //  unsigned int seed;
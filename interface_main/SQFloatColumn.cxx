@@ -0,0 +1,41 @@
+/*
+ * SQFloatColumn.cxx
+ */
+#include <half/half.h>
+#include "SQFloatColumn.h"
+
+using namespace std;
+
+void SQFloatColumn::set_half(const bool a) {
+  if (a == _half) return;
+  if (a) {
+    _h.resize(_f.size());
+    for (size_t i = 0; i < _f.size(); i++) _h[i] = ToHalf(_f[i]);
+    vector<float>().swap(_f);
+  } else {
+    _f.resize(_h.size());
+    for (size_t i = 0; i < _h.size(); i++) _f[i] = ToFloat(_h[i]);
+    vector<unsigned short>().swap(_h);
+  }
+  _half = a;
+}
+
+void SQFloatColumn::reserve(const size_t n) {
+  if (_half) _h.reserve(n);
+  else       _f.reserve(n);
+}
+
+void SQFloatColumn::erase(const size_t i) {
+  if (_half) _h.erase(_h.begin() + i);
+  else       _f.erase(_f.begin() + i);
+}
+
+float SQFloatColumn::ToFloat(const unsigned short bits) {
+  half h;
+  h.setBits(bits);
+  return h;
+}
+
+unsigned short SQFloatColumn::ToHalf(const float a) {
+  return half(a).bits();
+}
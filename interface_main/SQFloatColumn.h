@@ -0,0 +1,42 @@
+/*
+ * SQFloatColumn.h
+ */
+
+#ifndef _H_SQFloatColumn_H_
+#define _H_SQFloatColumn_H_
+
+#include <vector>
+#include <cstddef>
+
+/// One float column of a column-wise container like SQHitVector_v2.
+/**
+ * The values are held either as float or, when set_half() is enabled, as 16-bit half floats
+ * (see the Half package), which halves the size of the column in memory and on disk
+ * at the cost of a relative precision of about 5e-4.  Only one of the two vectors is filled.
+ */
+class SQFloatColumn {
+public:
+  SQFloatColumn() : _half(false) {}
+
+  bool   is_half() const {return _half;}
+  void   set_half(const bool a); ///< Switch the storage, converting the values already stored
+
+  size_t size() const {return _half ? _h.size() : _f.size();}
+  void   reserve(const size_t n);
+  void   clear() {_f.clear(); _h.clear();}
+
+  float  get(const size_t i) const {return _half ? ToFloat(_h[i]) : _f[i];}
+  void   set(const size_t i, const float a) {if (_half) _h[i] = ToHalf(a); else _f[i] = a;}
+  void   push_back(const float a) {if (_half) _h.push_back(ToHalf(a)); else _f.push_back(a);}
+  void   erase(const size_t i);
+
+private:
+  static float          ToFloat(const unsigned short bits);
+  static unsigned short ToHalf (const float a);
+
+  bool _half;
+  std::vector<float>          _f;
+  std::vector<unsigned short> _h; ///< half-float bits
+};
+
+#endif /* _H_SQFloatColumn_H_ */
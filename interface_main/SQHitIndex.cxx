@@ -0,0 +1,78 @@
+#include <algorithm>
+#include "SQHit.h"
+#include "SQHitIndex.h"
+using namespace std;
+
+namespace {
+  /// Element ID ascending, then TDC time descending, so the first of each element is its earliest hit.
+  bool FirstHitOrder(const SQHit* a, const SQHit* b)
+  {
+    if (a->get_element_id() != b->get_element_id()) return a->get_element_id() < b->get_element_id();
+    return a->get_tdc_time() > b->get_tdc_time();
+  }
+};
+
+SQHitView SQHitIndex::Hits(const vector<SQHit*>& hits, const short det_id)
+{
+  if (! _hits_ok) BuildHits(hits);
+  if (det_id < 0 || det_id + 1 >= (int)_pos.size()) return SQHitView();
+  return SQHitView(_hits.data() + _pos[det_id], _hits.data() + _pos[det_id+1]);
+}
+
+SQHitView SQHitIndex::FirstHits(const vector<SQHit*>& hits, const short det_id)
+{
+  if (! _first_ok) BuildFirstHits(hits);
+  if (det_id < 0 || det_id + 1 >= (int)_pos_first.size()) return SQHitView();
+  return SQHitView(_first.data() + _pos_first[det_id], _first.data() + _pos_first[det_id+1]);
+}
+
+/**
+ * Counting sort on the detector ID, which keeps the stored order within each detector.
+ * Hits with a negative detector ID are not indexed.
+ */
+void SQHitIndex::BuildHits(const vector<SQHit*>& hits)
+{
+  int id_max = -1;
+  for (vector<SQHit*>::const_iterator it = hits.begin(); it != hits.end(); it++) {
+    int det_id = (*it)->get_detector_id();
+    if (det_id > id_max) id_max = det_id;
+  }
+
+  _pos.assign(id_max + 2, 0);
+  for (vector<SQHit*>::const_iterator it = hits.begin(); it != hits.end(); it++) {
+    int det_id = (*it)->get_detector_id();
+    if (det_id >= 0) _pos[det_id + 1]++;
+  }
+  for (unsigned int i = 1; i < _pos.size(); i++) _pos[i] += _pos[i-1];
+
+  _hits.resize(_pos.back());
+  vector<unsigned int> fill(_pos.begin(), _pos.end() - 1);
+  for (vector<SQHit*>::const_iterator it = hits.begin(); it != hits.end(); it++) {
+    int det_id = (*it)->get_detector_id();
+    if (det_id >= 0) _hits[fill[det_id]++] = *it;
+  }
+  _hits_ok = true;
+  _first_ok = false;
+}
+
+/**
+ * The ties in TDC time are resolved in favor of the hit stored first, as UtilSQHit::FindFirstHits() always did.
+ */
+void SQHitIndex::BuildFirstHits(const vector<SQHit*>& hits)
+{
+  if (! _hits_ok) BuildHits(hits);
+
+  vector<SQHit*> sorted(_hits);
+  _first.clear();
+  _pos_first.assign(_pos.size(), 0);
+  for (unsigned int det_id = 0; det_id + 1 < _pos.size(); det_id++) {
+    vector<SQHit*>::iterator b = sorted.begin() + _pos[det_id];
+    vector<SQHit*>::iterator e = sorted.begin() + _pos[det_id+1];
+    stable_sort(b, e, FirstHitOrder);
+    for (vector<SQHit*>::iterator it = b; it != e; it++) {
+      if (it == b || (*it)->get_element_id() != (*(it-1))->get_element_id()) _first.push_back(*it);
+    }
+    _pos_first[det_id+1] = _first.size();
+  }
+  _first_ok = true;
+}
@@ -0,0 +1,74 @@
+#ifndef _H_SQHitIndex_H_
+#define _H_SQHitIndex_H_
+
+#include <vector>
+#include <cstddef>
+
+class SQHit;
+
+/// A non-owning, read-only range of hits returned by SQHitVector::get_hits() and UtilSQHit.
+/**
+ * No hit is copied.  The view points into the index cached in the hit vector,
+ * so it stays valid only until the hit vector is modified (push_back, erase, clear, Reset) or deleted.
+ * @code
+ * SQHitView hv = hit_vec->get_hits(det_id);
+ * for (SQHitView::ConstIter it = hv.begin(); it != hv.end(); it++) {
+ *   SQHit* hit = *it;
+ * }
+ * @endcode
+ */
+class SQHitView {
+public:
+  typedef SQHit* const* ConstIter;
+
+  SQHitView() : _begin(0), _end(0) {}
+  SQHitView(ConstIter b, ConstIter e) : _begin(b), _end(e) {}
+
+  bool      empty()               const {return _begin == _end;}
+  size_t     size()               const {return _end - _begin;}
+  SQHit*       at(const size_t i) const {return i < size() ? _begin[i] : 0;}
+  SQHit* operator[](const size_t i) const {return _begin[i];}
+
+  ConstIter begin() const {return _begin;}
+  ConstIter   end() const {return _end;}
+
+private:
+  ConstIter _begin;
+  ConstIter _end;
+};
+
+/// Per-detector index of the hits held by an SQHitVector implementation.
+/**
+ * The index is built at the first query after a change of the hit list and then re-used,
+ * so repeated per-detector lookups in one event cost one pass over the hits in total.
+ * The owner has to call Invalidate() whenever hits are added or removed, and after each ROOT read
+ * (via a "#pragma read" rule on the transient index in its LinkDef).
+ * Changing the detector ID of a stored hit in place also requires Invalidate().
+ * Queries fill the cache lazily and are not thread-safe.
+ */
+class SQHitIndex {
+public:
+  SQHitIndex() : _hits_ok(false), _first_ok(false) {}
+
+  void Invalidate() { _hits_ok = _first_ok = false; }
+
+  /// Hits of the given detector, in the order of "hits".
+  SQHitView Hits     (const std::vector<SQHit*>& hits, const short det_id);
+
+  /// Earliest (i.e. largest TDC time) hit per element of the given detector, in element ID order.
+  SQHitView FirstHits(const std::vector<SQHit*>& hits, const short det_id);
+
+private:
+  void BuildHits     (const std::vector<SQHit*>& hits);
+  void BuildFirstHits(const std::vector<SQHit*>& hits);
+
+  bool _hits_ok;
+  bool _first_ok;
+
+  std::vector<SQHit*>       _hits;      ///< All hits grouped by detector ID
+  std::vector<unsigned int> _pos;       ///< [det_id] = first position in _hits, of size (max det_id)+2
+  std::vector<SQHit*>       _first;     ///< First hits grouped by detector ID
+  std::vector<unsigned int> _pos_first; ///< Same as _pos for _first
+};
+
+#endif /* _H_SQHitIndex_H_ */
@@ -15,6 +15,7 @@
 #include <iostream>
 
 #include "SQHit.h"
+#include "SQHitIndex.h"
 
 /// An SQ interface class to hold a list of SQHit objects.
 /**
@@ -27,6 +28,12 @@
  * }
  * @endcode
  *
+ * The hits of one detector can be looked up without scanning all hits nor copying them;
+ * @code
+ * SQHitView hv = hit_vec->get_hits(det_id);
+ * for (SQHitView::ConstIter it = hv.begin(); it != hv.end(); it++) { ... }
+ * @endcode
+ *
  * You can use utility functions defined in UtilSQHit for more complicated manipulations.
  */
 class SQHitVector : public PHObject {
@@ -55,12 +62,42 @@ public:
   virtual       void   push_back(const SQHit *hit) {}
   virtual       size_t erase(const size_t idkey) {return 0;}
 
+  /// Reserve the capacity for "n" hits in total.
+  virtual       void   reserve(const size_t n) {}
+  /// Append a default hit owned by this vector and return it to be filled in place.
+  /**
+   * Unlike push_back(), no temporary hit has to be created and copied.
+   * "mc = true" asks for a hit which can hold the MC truth (SQMCHit).
+   */
+  virtual       SQHit* emplace_back(const bool mc = false) = 0;
+  /// Append "hit" and take over its ownership.  "hit" must have been created by "new".
+  virtual       void   adopt(SQHit *hit) {push_back(hit); delete hit;}
+
+#ifndef __CINT__
+  /// Append "n" hits converted from the contiguous records "rec", e.g. the decoder hit list.
+  /**
+   * "filler(rec[i], hit)" sets the variables of each new hit:
+   * @code
+   * hit_vec->fill(list.data(), list.size(), [](const HitData& hd, SQHit* hit) { hit->set_hit_id(hd.id); ... });
+   * @endcode
+   */
+  template<class Record, class Filler> void fill(const Record* rec, const size_t n, Filler filler) {
+    reserve(size() + n);
+    for (size_t i = 0; i < n; i++) filler(rec[i], emplace_back());
+  }
+#endif
+
   virtual ConstIter begin()                   const {return HitVector().end();}
   virtual ConstIter   end()                   const {return HitVector().end();}
 
   virtual Iter begin()                   {return HitVector().end();}
   virtual Iter   end()                   {return HitVector().end();}
 
+  /// Return the hits of the given detector in stored order, valid until this vector is modified.  See SQHitView.
+  virtual SQHitView get_hits      (const short det_id) const = 0;
+  /// Return the earliest (i.e. largest TDC time) hit per element of the given detector, in element ID order.
+  virtual SQHitView get_first_hits(const short det_id) const = 0;
+
 protected:
   SQHitVector() {}
 
@@ -10,6 +10,8 @@
 
 #include <vector>
 #include "SQHit.h"
+#include "SQHit_v1.h"
+#include "SQMCHit_v1.h"
 
 using namespace std;
 
@@ -47,6 +49,7 @@ SQHitVector_v1::~SQHitVector_v1() {
 void SQHitVector_v1::Reset() {
 	for(auto iter = _vector.begin(); iter!=_vector.end(); ++iter) delete (*iter);
   _vector.clear();
+  _index.Invalidate();
 }
 
 void SQHitVector_v1::identify(ostream& os) const {
@@ -66,6 +69,19 @@ SQHit* SQHitVector_v1::at(const size_t id) {
 
 void SQHitVector_v1::push_back(const SQHit *hit) {
   _vector.push_back(hit->Clone());
+  _index.Invalidate();
+}
+
+SQHit* SQHitVector_v1::emplace_back(const bool mc) {
+  SQHit* hit = mc ? static_cast<SQHit*>(new SQMCHit_v1()) : static_cast<SQHit*>(new SQHit_v1());
+  _vector.push_back(hit);
+  _index.Invalidate();
+  return hit;
+}
+
+void SQHitVector_v1::adopt(SQHit *hit) {
+  _vector.push_back(hit);
+  _index.Invalidate();
 }
 
 
@@ -36,9 +36,13 @@ public:
   const SQHit* at(const size_t idkey) const;
   SQHit*       at(const size_t idkey);
   void         push_back(const SQHit *hit);
+  void         reserve(const size_t n) {_vector.reserve(n);}
+  SQHit*       emplace_back(const bool mc = false);
+  void         adopt(SQHit *hit);
   size_t       erase(const size_t idkey) {
 	  delete _vector[idkey];
 	  _vector.erase(_vector.begin() + idkey);
+	  _index.Invalidate();
 	  return _vector.size();
 	}
 
@@ -48,8 +52,12 @@ public:
   Iter begin()                   {return _vector.begin();}
   Iter   end()                   {return _vector.end();}
 
+  SQHitView get_hits      (const short det_id) const {return _index.Hits     (_vector, det_id);}
+  SQHitView get_first_hits(const short det_id) const {return _index.FirstHits(_vector, det_id);}
+
 private:
   HitVector _vector;
+  mutable SQHitIndex _index; //! per-detector index, rebuilt on demand after any change of _vector and after each read
 
   ClassDef(SQHitVector_v1, 1);
 };
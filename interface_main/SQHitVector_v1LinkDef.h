@@ -2,4 +2,7 @@
 
 #pragma link C++ class SQHitVector_v1+;
 
+// The hits are replaced by every read, so the cached index must not survive it
+#pragma read sourceClass="SQHitVector_v1" version="[1-]" targetClass="SQHitVector_v1" source="" target="_index" code="{ _index.Invalidate(); }"
+
 #endif /* __CINT__ */
@@ -0,0 +1,333 @@
+/*
+ * SQHitVector_v2.cxx
+ */
+#include "SQHitVector_v2.h"
+
+#include <limits>
+#include "SQHit_v1.h"
+#include "SQMCHit_v1.h"
+
+using namespace std;
+
+ClassImp(SQHitVector_v2)
+
+/// Row of an SQHitVector_v2 seen through the SQHit interface.
+class SQHitProxy_v2 : public SQHit {
+public:
+  SQHitProxy_v2(SQHitVector_v2* vec, const size_t row) : _vec(vec), _row(row) {}
+  virtual ~SQHitProxy_v2() {}
+
+  void   identify(std::ostream& os = std::cout) const {
+    os << "---SQHitProxy_v2 row " << _row << "----------" << endl;
+    SQHit* hit = Clone();
+    hit->identify(os);
+    delete hit;
+  }
+  int    isValid() const {return 1;}
+  SQHit* Clone() const;
+
+  int    get_hit_id() const                { return _vec->_hit_id[_row]; }
+  void   set_hit_id(const int a)           { _vec->_hit_id[_row] = a; }
+
+  short  get_detector_id() const           { return _vec->_detector_id[_row]; }
+  void   set_detector_id(const short a)    { _vec->_detector_id[_row] = a; _vec->_index.Invalidate(); }
+
+  short  get_element_id() const            { return _vec->_element_id[_row]; }
+  void   set_element_id(const short a)     { _vec->_element_id[_row] = a; _vec->_index.Invalidate(); }
+
+  short  get_level() const                 { return _vec->_level[_row]; }
+  void   set_level(const short a)          { _vec->_level[_row] = a; }
+
+  float  get_tdc_time() const              { return _vec->_tdc_time.get(_row); }
+  void   set_tdc_time(const float a)       { _vec->_tdc_time.set(_row, a); _vec->_index.Invalidate(); }
+
+  float  get_drift_distance() const        { return _vec->_drift_distance.get(_row); }
+  void   set_drift_distance(const float a) { _vec->_drift_distance.set(_row, a); }
+
+  float  get_pos() const                   { return _vec->_pos.get(_row); }
+  void   set_pos(const float a)            { _vec->_pos.set(_row, a); }
+
+  bool   is_in_time() const                { return (_vec->_flag[_row] & SQHit::InTime) != 0; }
+  void   set_in_time(const bool a)         { SetFlag(SQHit::InTime, a); }
+
+  bool   is_hodo_mask() const              { return (_vec->_flag[_row] & SQHit::HodoMask) != 0; }
+  void   set_hodo_mask(const bool a)       { SetFlag(SQHit::HodoMask, a); }
+
+  bool   is_trigger_mask() const           { return (_vec->_flag[_row] & SQHit::TriggerMask) != 0; }
+  void   set_trigger_mask(const bool a)    { SetFlag(SQHit::TriggerMask, a); }
+
+  int    get_track_id() const              { return _vec->_mc ? _vec->_track_id[_row] : SQHit::get_track_id(); }
+  void   set_track_id(const int a)         { if (_vec->_mc) _vec->_track_id[_row] = a; }
+
+  PHG4HitDefs::keytype get_g4hit_id() const            { return _vec->_mc ? _vec->_g4hit_id[_row] : SQHit::get_g4hit_id(); }
+  void   set_g4hit_id(const PHG4HitDefs::keytype a)    { if (_vec->_mc) _vec->_g4hit_id[_row] = a; }
+
+  float  get_truth_x () const        { return _vec->_mc ? _vec->_truth_x .get(_row) : SQHit::get_truth_x (); }
+  void   set_truth_x (const float a) { if (_vec->_mc) _vec->_truth_x .set(_row, a); }
+  float  get_truth_y () const        { return _vec->_mc ? _vec->_truth_y .get(_row) : SQHit::get_truth_y (); }
+  void   set_truth_y (const float a) { if (_vec->_mc) _vec->_truth_y .set(_row, a); }
+  float  get_truth_z () const        { return _vec->_mc ? _vec->_truth_z .get(_row) : SQHit::get_truth_z (); }
+  void   set_truth_z (const float a) { if (_vec->_mc) _vec->_truth_z .set(_row, a); }
+  float  get_truth_px() const        { return _vec->_mc ? _vec->_truth_px.get(_row) : SQHit::get_truth_px(); }
+  void   set_truth_px(const float a) { if (_vec->_mc) _vec->_truth_px.set(_row, a); }
+  float  get_truth_py() const        { return _vec->_mc ? _vec->_truth_py.get(_row) : SQHit::get_truth_py(); }
+  void   set_truth_py(const float a) { if (_vec->_mc) _vec->_truth_py.set(_row, a); }
+  float  get_truth_pz() const        { return _vec->_mc ? _vec->_truth_pz.get(_row) : SQHit::get_truth_pz(); }
+  void   set_truth_pz(const float a) { if (_vec->_mc) _vec->_truth_pz.set(_row, a); }
+
+  void   SetRow(SQHitVector_v2* vec, const size_t row) { _vec = vec; _row = row; }
+
+private:
+  void SetFlag(const unsigned short bit, const bool a) {
+    if (a) _vec->_flag[_row] |=  bit;
+    else   _vec->_flag[_row] &= ~bit;
+  }
+
+  SQHitVector_v2* _vec;
+  size_t _row;
+};
+
+/**
+ * The copy is a stand-alone object, independent of the vector.
+ */
+SQHit* SQHitProxy_v2::Clone() const {
+  SQHit* hit = _vec->_mc ? new SQMCHit_v1() : new SQHit_v1();
+  hit->set_hit_id        (get_hit_id        ());
+  hit->set_detector_id   (get_detector_id   ());
+  hit->set_element_id    (get_element_id    ());
+  hit->set_level         (get_level         ());
+  hit->set_tdc_time      (get_tdc_time      ());
+  hit->set_drift_distance(get_drift_distance());
+  hit->set_pos           (get_pos           ());
+  hit->set_in_time       (is_in_time        ());
+  hit->set_hodo_mask     (is_hodo_mask      ());
+  hit->set_trigger_mask  (is_trigger_mask   ());
+  if (_vec->_mc) {
+    hit->set_track_id(get_track_id());
+    hit->set_g4hit_id(get_g4hit_id());
+    hit->set_truth_x (get_truth_x ());
+    hit->set_truth_y (get_truth_y ());
+    hit->set_truth_z (get_truth_z ());
+    hit->set_truth_px(get_truth_px());
+    hit->set_truth_py(get_truth_py());
+    hit->set_truth_pz(get_truth_pz());
+  }
+  return hit;
+}
+
+SQHitVector_v2::SQHitVector_v2(const bool mc)
+  : _mc(mc) {
+}
+
+SQHitVector_v2::SQHitVector_v2(const SQHitVector_v2& hitvector)
+  : SQHitVector(hitvector) {
+  *this = hitvector;
+}
+
+/**
+ * Copy the columns only.  The proxies of this vector are kept and re-pointed to the new rows.
+ */
+SQHitVector_v2& SQHitVector_v2::operator=(const SQHitVector_v2& hitvector) {
+  if (this == &hitvector) return *this;
+  _mc             = hitvector._mc;
+  _hit_id         = hitvector._hit_id;
+  _detector_id    = hitvector._detector_id;
+  _element_id     = hitvector._element_id;
+  _level          = hitvector._level;
+  _flag           = hitvector._flag;
+  _tdc_time       = hitvector._tdc_time;
+  _drift_distance = hitvector._drift_distance;
+  _pos            = hitvector._pos;
+  _track_id       = hitvector._track_id;
+  _g4hit_id       = hitvector._g4hit_id;
+  _truth_x        = hitvector._truth_x;
+  _truth_y        = hitvector._truth_y;
+  _truth_z        = hitvector._truth_z;
+  _truth_px       = hitvector._truth_px;
+  _truth_py       = hitvector._truth_py;
+  _truth_pz       = hitvector._truth_pz;
+  _index.Invalidate();
+  return *this;
+}
+
+SQHitVector_v2::~SQHitVector_v2() {
+  DeleteProxies();
+}
+
+/**
+ * The column capacities and the proxies are kept for the next event.
+ */
+void SQHitVector_v2::Reset() {
+  _hit_id        .clear();
+  _detector_id   .clear();
+  _element_id    .clear();
+  _level         .clear();
+  _flag          .clear();
+  _tdc_time      .clear();
+  _drift_distance.clear();
+  _pos           .clear();
+  _track_id      .clear();
+  _g4hit_id      .clear();
+  _truth_x       .clear();
+  _truth_y       .clear();
+  _truth_z       .clear();
+  _truth_px      .clear();
+  _truth_py      .clear();
+  _truth_pz      .clear();
+  _index.Invalidate();
+}
+
+void SQHitVector_v2::identify(ostream& os) const {
+  os << "SQHitVector_v2: size = " << size() << (_mc ? ", MC" : "") << (get_half_precision() ? ", half precision" : "") << endl;
+  return;
+}
+
+const SQHit* SQHitVector_v2::at(const size_t id) const {
+  if(id>= size()) return nullptr;
+  SyncProxies();
+  return _proxies[id];
+}
+
+SQHit* SQHitVector_v2::at(const size_t id) {
+  if(id>= size()) return nullptr;
+  SyncProxies();
+  return _proxies[id];
+}
+
+void SQHitVector_v2::push_back(const SQHit *hit) {
+  _hit_id        .push_back(hit->get_hit_id        ());
+  _detector_id   .push_back(hit->get_detector_id   ());
+  _element_id    .push_back(hit->get_element_id    ());
+  _level         .push_back(hit->get_level         ());
+  _tdc_time      .push_back(hit->get_tdc_time      ());
+  _drift_distance.push_back(hit->get_drift_distance());
+  _pos           .push_back(hit->get_pos           ());
+
+  unsigned short flag = 0;
+  if (hit->is_in_time     ()) flag |= SQHit::InTime;
+  if (hit->is_hodo_mask   ()) flag |= SQHit::HodoMask;
+  if (hit->is_trigger_mask()) flag |= SQHit::TriggerMask;
+  _flag.push_back(flag);
+
+  if (_mc) {
+    _track_id.push_back(hit->get_track_id());
+    _g4hit_id.push_back(hit->get_g4hit_id());
+    _truth_x .push_back(hit->get_truth_x ());
+    _truth_y .push_back(hit->get_truth_y ());
+    _truth_z .push_back(hit->get_truth_z ());
+    _truth_px.push_back(hit->get_truth_px());
+    _truth_py.push_back(hit->get_truth_py());
+    _truth_pz.push_back(hit->get_truth_pz());
+  }
+  _index.Invalidate();
+}
+
+/**
+ * The new row holds the same default values as a new SQHit_v1, the truth momentum and position are NaN.
+ */
+SQHit* SQHitVector_v2::emplace_back(const bool mc) {
+  _hit_id        .push_back(numeric_limits<int  >::max());
+  _detector_id   .push_back(numeric_limits<short>::max());
+  _element_id    .push_back(numeric_limits<short>::max());
+  _level         .push_back(numeric_limits<short>::max());
+  _flag          .push_back(0);
+  _tdc_time      .push_back(numeric_limits<float>::quiet_NaN());
+  _drift_distance.push_back(numeric_limits<float>::quiet_NaN());
+  _pos           .push_back(numeric_limits<float>::quiet_NaN());
+  if (_mc) {
+    _track_id.push_back(numeric_limits<int>::max());
+    _g4hit_id.push_back(numeric_limits<PHG4HitDefs::keytype>::max());
+    _truth_x .push_back(numeric_limits<float>::quiet_NaN());
+    _truth_y .push_back(numeric_limits<float>::quiet_NaN());
+    _truth_z .push_back(numeric_limits<float>::quiet_NaN());
+    _truth_px.push_back(numeric_limits<float>::quiet_NaN());
+    _truth_py.push_back(numeric_limits<float>::quiet_NaN());
+    _truth_pz.push_back(numeric_limits<float>::quiet_NaN());
+  }
+  _index.Invalidate();
+  SyncProxies();
+  return _proxies.back();
+}
+
+size_t SQHitVector_v2::erase(const size_t id) {
+  if (id >= size()) return size();
+  _hit_id        .erase(_hit_id     .begin() + id);
+  _detector_id   .erase(_detector_id.begin() + id);
+  _element_id    .erase(_element_id .begin() + id);
+  _level         .erase(_level      .begin() + id);
+  _flag          .erase(_flag       .begin() + id);
+  _tdc_time      .erase(id);
+  _drift_distance.erase(id);
+  _pos           .erase(id);
+  if (_mc) {
+    _track_id.erase(_track_id.begin() + id);
+    _g4hit_id.erase(_g4hit_id.begin() + id);
+    _truth_x .erase(id);
+    _truth_y .erase(id);
+    _truth_z .erase(id);
+    _truth_px.erase(id);
+    _truth_py.erase(id);
+    _truth_pz.erase(id);
+  }
+  _index.Invalidate();
+  return size();
+}
+
+void SQHitVector_v2::set_half_precision(const bool a) {
+  _tdc_time      .set_half(a);
+  _drift_distance.set_half(a);
+  _pos           .set_half(a);
+  _truth_x       .set_half(a);
+  _truth_y       .set_half(a);
+  _truth_z       .set_half(a);
+  _truth_px      .set_half(a);
+  _truth_py      .set_half(a);
+  _truth_pz      .set_half(a);
+}
+
+void SQHitVector_v2::reserve(const size_t n) {
+  _hit_id        .reserve(n);
+  _detector_id   .reserve(n);
+  _element_id    .reserve(n);
+  _level         .reserve(n);
+  _flag          .reserve(n);
+  _tdc_time      .reserve(n);
+  _drift_distance.reserve(n);
+  _pos           .reserve(n);
+  if (_mc) {
+    _track_id.reserve(n);
+    _g4hit_id.reserve(n);
+    _truth_x .reserve(n);
+    _truth_y .reserve(n);
+    _truth_z .reserve(n);
+    _truth_px.reserve(n);
+    _truth_py.reserve(n);
+    _truth_pz.reserve(n);
+  }
+}
+
+void SQHitVector_v2::SyncProxies() const {
+  SQHitVector_v2* self = const_cast<SQHitVector_v2*>(this);
+  while (_proxies.size() > size()) {
+    _spare.push_back(_proxies.back());
+    _proxies.pop_back();
+  }
+  while (_proxies.size() < size()) {
+    SQHitProxy_v2* proxy;
+    if (_spare.empty()) {
+      proxy = new SQHitProxy_v2(self, _proxies.size());
+    } else {
+      proxy = static_cast<SQHitProxy_v2*>(_spare.back());
+      _spare.pop_back();
+      proxy->SetRow(self, _proxies.size());
+    }
+    _proxies.push_back(proxy);
+  }
+}
+
+void SQHitVector_v2::DeleteProxies() {
+  for (Iter it = _proxies.begin(); it != _proxies.end(); ++it) delete *it;
+  for (Iter it = _spare  .begin(); it != _spare  .end(); ++it) delete *it;
+  _proxies.clear();
+  _spare  .clear();
+}
@@ -0,0 +1,108 @@
+/*
+ * SQHitVector_v2.h
+ */
+
+#ifndef _H_SQHitVector_v2_H_
+#define _H_SQHitVector_v2_H_
+
+#include <phool/PHObject.h>
+#include <vector>
+#include <iostream>
+
+#include "SQHit.h"
+#include "SQHitVector.h"
+#include "SQFloatColumn.h"
+
+class SQHitProxy_v2;
+
+/// An SQHitVector version that holds the hits column-wise.
+/**
+ * Each hit variable is stored in its own contiguous array, which is much smaller in memory and on disk
+ * than one streamed SQHit object per hit.  The MC truth columns are filled only when the vector
+ * is constructed with "mc = true", and the float columns can be stored as half floats via set_half_precision().
+ *
+ * The usual SQHitVector interface is kept:  at() and the iterators return light proxy objects
+ * (one per row, re-used from event to event) whose getters and setters read and write the columns.
+ * A proxy refers to a row number, so after erase() the proxies of the later rows see the next hit,
+ * just as iterators become invalid in SQHitVector_v1.  push_back() copies the values of the given hit,
+ * emplace_back() appends a default row and returns its proxy (the "mc" argument is ignored, the truth
+ * columns exist only if the vector is MC), and Clone() of a proxy returns a stand-alone SQHit_v1 (or SQMCHit_v1).
+ */
+class SQHitVector_v2 : public SQHitVector {
+
+public:
+
+  explicit SQHitVector_v2(const bool mc = false);
+  SQHitVector_v2(const SQHitVector_v2& hitvector);
+  SQHitVector_v2& operator=(const SQHitVector_v2& hitvector);
+  virtual ~SQHitVector_v2();
+
+  void identify(std::ostream& os = std::cout) const;
+  void Reset();
+  int  isValid() const {return 1;}
+  SQHitVector* Clone() const {return new SQHitVector_v2(*this);}
+
+  bool   empty()                   const {return _detector_id.empty();}
+  size_t  size()                   const {return _detector_id.size();}
+  void   clear()                         {Reset();}
+
+  const SQHit* at(const size_t idkey) const;
+  SQHit*       at(const size_t idkey);
+  void         push_back(const SQHit *hit);
+  size_t       erase(const size_t idkey);
+  SQHit*       emplace_back(const bool mc = false);
+
+  ConstIter begin() const {SyncProxies(); return _proxies.begin();}
+  ConstIter   end() const {SyncProxies(); return _proxies.end();}
+
+  Iter begin() {SyncProxies(); return _proxies.begin();}
+  Iter   end() {SyncProxies(); return _proxies.end();}
+
+  SQHitView get_hits      (const short det_id) const {SyncProxies(); return _index.Hits     (_proxies, det_id);}
+  SQHitView get_first_hits(const short det_id) const {SyncProxies(); return _index.FirstHits(_proxies, det_id);}
+
+  bool is_mc() const {return _mc;}
+
+  /// Store the float columns as 16-bit half floats (lossy, relative precision ~5e-4).  Can be changed at any time.
+  void set_half_precision(const bool a);
+  bool get_half_precision() const {return _tdc_time.is_half();}
+
+  /// Reserve the column capacity for "n" hits.
+  void reserve(const size_t n);
+
+private:
+  friend class SQHitProxy_v2;
+
+  /// Make _proxies hold exactly one proxy per row, e.g. after the columns were filled by ROOT I/O
+  void SyncProxies() const;
+  void DeleteProxies();
+
+  bool _mc;
+
+  std::vector<int>            _hit_id;
+  std::vector<short>          _detector_id;
+  std::vector<short>          _element_id;
+  std::vector<short>          _level;
+  std::vector<unsigned short> _flag;
+  SQFloatColumn               _tdc_time;
+  SQFloatColumn               _drift_distance;
+  SQFloatColumn               _pos;
+
+  // MC truth, empty unless _mc
+  std::vector<int>                  _track_id;
+  std::vector<PHG4HitDefs::keytype> _g4hit_id;
+  SQFloatColumn               _truth_x;
+  SQFloatColumn               _truth_y;
+  SQFloatColumn               _truth_z;
+  SQFloatColumn               _truth_px;
+  SQFloatColumn               _truth_py;
+  SQFloatColumn               _truth_pz;
+
+  mutable HitVector  _proxies; //! one proxy per row
+  mutable HitVector  _spare;   //! proxies kept for re-use
+  mutable SQHitIndex _index;   //! per-detector index, rebuilt on demand after any change of the rows and after each read
+
+  ClassDef(SQHitVector_v2, 1);
+};
+
+#endif /* _H_SQHitVector_v2_H_ */
@@ -0,0 +1,8 @@
+#ifdef __CINT__
+
+#pragma link C++ class SQHitVector_v2+;
+
+// The rows are replaced by every read, so the cached index must not survive it
+#pragma read sourceClass="SQHitVector_v2" version="[1-]" targetClass="SQHitVector_v2" source="" target="_index" code="{ _index.Invalidate(); }"
+
+#endif /* __CINT__ */
@@ -0,0 +1,396 @@
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <TGraphErrors.h>
+#include <interface_main/SQParamDeco.h>
+#include <interface_main/SQRun.h>
+#include <interface_main/SQHitVector.h>
+#include <fun4all/Fun4AllReturnCodes.h>
+#include <phool/PHNodeIterator.h>
+#include <phool/PHIODataNode.h>
+#include <phool/getClass.h>
+#include <geom_svc/GeomSvc.h>
+#include <geom_svc/CalibParamXT.h>
+#include <geom_svc/CalibParamInTimeTaiwan.h>
+#include <geom_svc/CalibParamInTimeV1495.h>
+#include "CalibHit.h"
+using namespace std;
+
+////////////////////////////////////////////////////////////////
+// CalibHitInTimeTable
+
+void CalibHitInTimeTable::Build(CalibParamInTimeTaiwan* cal)
+{
+  vector<Entry> list(cal->GetNumItems());
+  for (unsigned int ii = 0; ii < list.size(); ii++) {
+    Entry* ent = &list[ii];
+    cal->GetItem(ii, ent->det, ent->ele, ent->center, ent->width);
+    ent->lvl = 0;
+  }
+  Build(list);
+}
+
+void CalibHitInTimeTable::Build(CalibParamInTimeV1495* cal)
+{
+  vector<Entry> list(cal->GetNumItems());
+  for (unsigned int ii = 0; ii < list.size(); ii++) {
+    Entry* ent = &list[ii];
+    cal->GetItem(ii, ent->det, ent->ele, ent->lvl, ent->center, ent->width);
+  }
+  Build(list);
+}
+
+void CalibHitInTimeTable::Build(const std::vector<Entry>& list)
+{
+  /// Find the table size first
+  int n_det = 0;
+  m_n_lvl = 1;
+  m_det_n_ele.clear();
+  for (vector<Entry>::const_iterator it = list.begin(); it != list.end(); it++) {
+    if (it->det < 0 || it->ele < 0 || it->lvl < 0) {
+      cerr << "  WARNING:  CalibHitInTimeTable ignores the in-time parameter for det=" << it->det << " ele=" << it->ele << " lvl=" << it->lvl << ".\n";
+      continue;
+    }
+    if (it->det >= n_det) {
+      n_det = it->det + 1;
+      m_det_n_ele.resize(n_det, 0);
+    }
+    if (it->ele >= m_det_n_ele[it->det]) m_det_n_ele[it->det] = it->ele + 1;
+    if (it->lvl >= m_n_lvl) m_n_lvl = it->lvl + 1;
+  }
+
+  m_det_off.assign(n_det, 0);
+  int n_item = 0;
+  for (int det = 0; det < n_det; det++) {
+    m_det_off[det] = n_item;
+    n_item += m_n_lvl * m_det_n_ele[det];
+  }
+
+  Item item0;
+  item0.center = item0.width = 0;
+  item0.t0    = 0;
+  item0.valid = false;
+  m_items.assign(n_item, item0);
+
+  /// Fill in the added order, so that the later one overrides as in CalibParamInTime*::Find().
+  for (vector<Entry>::const_iterator it = list.begin(); it != list.end(); it++) {
+    if (it->det < 0 || it->ele < 0 || it->lvl < 0) continue;
+    Item* item = &m_items[m_det_off[it->det] + m_n_lvl * it->ele + it->lvl];
+    item->center = it->center;
+    item->width  = it->width;
+    item->t0     = it->center + it->width / 2;
+    item->valid  = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////
+// CalibHitXTCurve
+
+void CalibHitXTCurve::Build(TGraphErrors* gr)
+{
+  m_gr = gr;
+  m_t.clear();
+  m_x.clear();
+  m_bin_idx.clear();
+
+  int n_pt = gr->GetN();
+  if (n_pt < 2) return;
+  for (int ii = 1; ii < n_pt; ii++) {
+    if (! (gr->GetX()[ii-1] < gr->GetX()[ii])) return; // Not increasing.  Leave it to TGraph::Eval().
+  }
+  m_t.assign(gr->GetX(), gr->GetX() + n_pt);
+  m_x.assign(gr->GetY(), gr->GetY() + n_pt);
+
+  const int n_bin = 4 * (n_pt - 1);
+  m_t_lo     = m_t[0];
+  m_inv_step = n_bin / (m_t[n_pt-1] - m_t[0]);
+  m_bin_idx.resize(n_bin);
+  int idx = 0;
+  for (int ib = 0; ib < n_bin; ib++) {
+    double t_edge = m_t_lo + ib / m_inv_step;
+    while (idx < n_pt && m_t[idx] < t_edge) idx++;
+    m_bin_idx[ib] = idx;
+  }
+}
+
+/// Same linear interpolation and extrapolation as TGraph::Eval() (without spline), so that the result is identical.
+double CalibHitXTCurve::Eval(const double t) const
+{
+  if (m_t.empty()) return m_gr->Eval(t);
+  if (t != t) return m_x[0]; // NaN: TGraph::Eval() returns the first point.
+
+  const int n_pt = m_t.size();
+  int idx; // Index of the first point with m_t[idx] >= t
+  if      (t <= m_t[0]       ) idx = 0;
+  else if (t >  m_t[n_pt - 1]) idx = n_pt;
+  else {
+    int ib = (int)((t - m_t_lo) * m_inv_step);
+    if (ib >= (int)m_bin_idx.size()) ib = m_bin_idx.size() - 1;
+    idx = m_bin_idx[ib];
+    while (idx < n_pt && m_t[idx  ] <  t) idx++;
+    while (idx > 0    && m_t[idx-1] >= t) idx--; // In case of rounding at the bin edge
+  }
+  if (idx < n_pt && m_t[idx] == t) return m_x[idx];
+
+  int low, up;
+  if      (idx == 0   ) { low = 0       ; up = 1       ; }
+  else if (idx == n_pt) { low = n_pt - 2; up = n_pt - 1; }
+  else                  { low = idx - 1 ; up = idx     ; }
+  return m_x[up] + (t - m_t[up]) * (m_x[low] - m_x[up]) / (m_t[low] - m_t[up]);
+}
+
+////////////////////////////////////////////////////////////////
+// CalibHit
+
+CalibHit::CalibHit(const std::string& name)
+  : SubsysReco(name)
+  , m_do_in_time(true)
+  , m_do_xt(true)
+  , m_do_merge_h4(true)
+  , m_and_mode(false)
+  , m_remove_mode(false)
+  , m_cal_taiwan(0)
+  , m_cal_v1495(0)
+  , m_cal_xt(0)
+{
+  ;
+}
+
+CalibHit::~CalibHit()
+{
+  if (m_cal_taiwan) delete m_cal_taiwan;
+  if (m_cal_v1495 ) delete m_cal_v1495;
+  if (m_cal_xt    ) delete m_cal_xt;
+}
+
+int CalibHit::Init(PHCompositeNode* topNode)
+{
+  return Fun4AllReturnCodes::EVENT_OK;
+}
+
+int CalibHit::InitRun(PHCompositeNode* topNode)
+{
+  SQParamDeco* param_deco = findNode::getClass<SQParamDeco>(topNode, "SQParamDeco");
+  SQRun*       run_header = findNode::getClass<SQRun      >(topNode, "SQRun");
+  if (!param_deco || !run_header) return Fun4AllReturnCodes::ABORTEVENT;
+
+  if (m_do_in_time || m_do_xt) { // The in-time window is needed for t0 of the X-T calibration.
+    if (! m_cal_taiwan) m_cal_taiwan = new CalibParamInTimeTaiwan();
+    m_cal_taiwan->SetMapIDbyDB(run_header->get_run_id());
+    m_cal_taiwan->ReadFromDB();
+    param_deco->set_variable(m_cal_taiwan->GetParamID(), m_cal_taiwan->GetMapID());
+    m_tab_taiwan.Build(m_cal_taiwan);
+  }
+
+  if (m_do_in_time) {
+    if (! m_cal_v1495) m_cal_v1495 = new CalibParamInTimeV1495();
+    m_cal_v1495->SetMapIDbyDB(run_header->get_run_id());
+    m_cal_v1495->ReadFromDB();
+    param_deco->set_variable(m_cal_v1495->GetParamID(), m_cal_v1495->GetMapID());
+    m_tab_v1495.Build(m_cal_v1495);
+  }
+
+  m_xt_curve.clear();
+  m_det_xt.clear();
+  if (m_do_xt) {
+    /// A new object is made per run since CalibParamXT::Add() always appends points.
+    if (m_cal_xt) delete m_cal_xt;
+    m_cal_xt = new CalibParamXT();
+    m_cal_xt->SetMapIDbyDB(run_header->get_run_id());
+    m_cal_xt->ReadFromDB();
+    param_deco->set_variable(m_cal_xt->GetParamID(), m_cal_xt->GetMapID());
+
+    vector<short> list_det;
+    m_cal_xt->GetDetIDs(list_det);
+    for (vector<short>::iterator it = list_det.begin(); it != list_det.end(); it++) {
+      short det = *it;
+      if (det < 0) continue; // Never found by the hit loop below.
+      TGraphErrors* gr_t2x;
+      TGraphErrors* gr_t2dx;
+      m_cal_xt->Find(det, gr_t2x, gr_t2dx);
+      if (det >= (int)m_det_xt.size()) m_det_xt.resize(det + 1, -1);
+      m_det_xt[det] = m_xt_curve.size();
+      m_xt_curve.push_back(CalibHitXTCurve());
+      m_xt_curve.back().Build(gr_t2x);
+    }
+  }
+
+  if (m_do_merge_h4) BuildMergedIdTable();
+
+  return Fun4AllReturnCodes::EVENT_OK;
+}
+
+int CalibHit::process_event(PHCompositeNode* topNode)
+{
+  SQHitVector*      hit_vec = findNode::getClass<SQHitVector>(topNode, "SQHitVector");
+  SQHitVector* trig_hit_vec = findNode::getClass<SQHitVector>(topNode, "SQTriggerHitVector");
+  if (!hit_vec || !trig_hit_vec) return Fun4AllReturnCodes::ABORTEVENT;
+
+  CalibHits    (     hit_vec);
+  CalibTrigHits(trig_hit_vec);
+  if (m_do_merge_h4 && m_and_mode) {
+    MergeHitsAnd(     hit_vec);
+    MergeHitsAnd(trig_hit_vec);
+  }
+  return Fun4AllReturnCodes::EVENT_OK;
+}
+
+int CalibHit::End(PHCompositeNode* topNode)
+{
+  return Fun4AllReturnCodes::EVENT_OK;
+}
+
+/// Same as CalibMergeH4::FindMergedId(), evaluated once per det ID.
+void CalibHit::BuildMergedIdTable()
+{
+  GeomSvc* geom = GeomSvc::instance();
+  m_det_merged.assign(1, 0);
+  for (int id = 1; ; id++) {
+    string name = geom->getDetectorName(id);
+    if (name.empty()) break;
+    short id_new = 0;
+    if (name.substr(0, 2) == "H4") {
+      string name2 = (name[2] == 'T' || name[2] == 'B') ? name.substr(0, 3) : name.substr(0, 5);
+      if (name2 != name) id_new = geom->getDetectorID(name2);
+    }
+    m_det_merged.push_back(id_new);
+  }
+}
+
+/// In-time, X-T and (in the "or" mode) H4 merging of the hits in SQHitVector.
+void CalibHit::CalibHits(SQHitVector* vec)
+{
+  const bool merge_or = m_do_merge_h4 && ! m_and_mode;
+  const unsigned int n_hit = vec->size(); // Merged hits appended below are not calibrated again.
+  for (unsigned int ih = 0; ih < n_hit; ih++) {
+    SQHit* hit = vec->at(ih);
+    short det = hit->get_detector_id();
+    short ele = hit->get_element_id();
+    const CalibHitInTimeTable::Item* item = m_tab_taiwan.Find(det, ele);
+
+    if (m_do_in_time && det != 0) { /// det=0 must be warned by the channel mapper instead.
+      if (item) {
+        hit->set_in_time( fabs(hit->get_tdc_time() - item->center) <= item->width / 2 );
+      } else {
+        cerr << "  WARNING:  Cannot find the in-time parameter for det=" << det << " ele=" << ele << ".\n";
+        hit->set_in_time(false);
+      }
+    }
+
+    if (m_do_xt) ApplyXT(hit, det, ele, item);
+
+    if (merge_or) {
+      short det_new = FindMergedId(det);
+      if (det_new == 0) continue;
+      if (m_remove_mode) {
+        hit->set_detector_id(det_new); // Modify ID, which effectively removes the original one.
+      } else {
+        SQHit* hit_new = hit->Clone();
+        hit_new->set_detector_id(det_new);
+        vec->adopt(hit_new);
+      }
+    }
+  }
+}
+
+/// In-time and (in the "or" mode) H4 merging of the hits in SQTriggerHitVector.
+void CalibHit::CalibTrigHits(SQHitVector* vec)
+{
+  const bool merge_or = m_do_merge_h4 && ! m_and_mode;
+  const unsigned int n_hit = vec->size();
+  for (unsigned int ih = 0; ih < n_hit; ih++) {
+    SQHit* hit = vec->at(ih);
+    short det = hit->get_detector_id();
+
+    if (m_do_in_time && det != 0) {
+      short ele = hit->get_element_id();
+      short lvl = hit->get_level();
+      const CalibHitInTimeTable::Item* item = m_tab_v1495.Find(det, ele, lvl);
+      if (item) {
+        hit->set_in_time( fabs(hit->get_tdc_time() - item->center) <= item->width / 2 );
+      } else {
+        cerr << "  WARNING:  Cannot find the in-time parameter for trigger det=" << det << " ele=" << ele << " lvl=" << lvl << ".\n";
+        hit->set_in_time(false);
+      }
+    }
+
+    if (merge_or) {
+      short det_new = FindMergedId(det);
+      if (det_new == 0) continue;
+      if (m_remove_mode) {
+        hit->set_detector_id(det_new);
+      } else {
+        SQHit* hit_new = hit->Clone();
+        hit_new->set_detector_id(det_new);
+        vec->adopt(hit_new);
+      }
+    }
+  }
+}
+
+void CalibHit::ApplyXT(SQHit* hit, const short det, const short ele, const CalibHitInTimeTable::Item* item)
+{
+  if (det < 0 || det >= (int)m_det_xt.size() || m_det_xt[det] < 0) return;
+  if (! item) {
+    cerr << "  WARNING:  Cannot find the in-time parameter for det=" << det << " ele=" << ele << " in CalibHit::ApplyXT().\n";
+    return;
+  }
+  float drift_time = item->t0 - hit->get_tdc_time();
+  hit->set_drift_distance(m_xt_curve[m_det_xt[det]].Eval(drift_time));
+}
+
+/// Same as CalibMergeH4::MergeHitsAnd() except for the merged-ID lookup.
+void CalibHit::MergeHitsAnd(SQHitVector* vec_in)
+{
+  typedef tuple<short, short, short> MergedGroup_t; // <merged det, element, level>
+  typedef map<short, SQHitVector*> MapVec_t; // <det, vector*>
+  typedef map<MergedGroup_t, MapVec_t> MapMapVec_t;
+  MapMapVec_t map_map_vec;
+
+  /// Extract H4 hits (and remove them in vec_in)
+  for (int ih = vec_in->size() - 1; ih >= 0; ih--) {
+    SQHit* hit = vec_in->at(ih);
+    short det_org = hit->get_detector_id();
+    short det_new = FindMergedId(det_org);
+    if (det_new == 0) continue;
+    MapVec_t* map_vec = &map_map_vec[MergedGroup_t(det_new, hit->get_element_id(), hit->get_level())];
+    if (map_vec->find(det_org) == map_vec->end()) {
+      (*map_vec)[det_org] = vec_in->Clone();
+      map_vec->at(det_org)->clear();
+    }
+    map_vec->at(det_org)->push_back(hit);
+    if (m_remove_mode) vec_in->erase(ih);
+  }
+
+  /// Merge hits per element
+  for (MapMapVec_t::iterator it = map_map_vec.begin(); it != map_map_vec.end(); it++) {
+    short det_new = std::get<0>(it->first);
+    MapVec_t* map_vec = &it->second;
+    int n_det = map_vec->size();
+    if (n_det == 2) { // Good in the "and" mode.  Merge all hits.
+      SQHit* hit_push = 0;
+      int    nhit = 0;
+      double time = 0;
+      for (MapVec_t::iterator it2 = map_vec->begin(); it2 != map_vec->end(); it2++) {
+        SQHitVector* vec = it2->second;
+        for (SQHitVector::Iter it3 = vec->begin(); it3 != vec->end(); it3++) {
+          SQHit* hit = *it3;
+          time += hit->get_tdc_time();
+          nhit++;
+          if (! hit_push) hit_push = hit;
+        }
+      }
+      hit_push->set_tdc_time(time/nhit); // average
+      hit_push->set_detector_id(det_new);
+      vec_in->push_back(hit_push);
+    } else if (n_det > 2) {
+      cerr << "CalibHit::MergeHitsAnd():  Unexpectedly found " << map_vec->size() << " detectors per merged detector." << endl;
+    }
+
+    for (MapVec_t::iterator it2 = map_vec->begin(); it2 != map_vec->end(); it2++) {
+      SQHitVector* vec = it2->second;
+      vec->clear();
+      delete vec;
+    }
+  }
+}
@@ -0,0 +1,118 @@
+#ifndef __CALIB_HIT_H__
+#define __CALIB_HIT_H__
+#include <vector>
+#include <fun4all/SubsysReco.h>
+class TGraphErrors;
+class SQHit;
+class SQHitVector;
+class CalibParamXT;
+class CalibParamInTimeTaiwan;
+class CalibParamInTimeV1495;
+
+/// Flat (det, ele, lvl) -> in-time window table, made from CalibParamInTimeTaiwan/V1495 at InitRun.
+class CalibHitInTimeTable {
+ public:
+  struct Item {
+    double center;
+    double width;
+    float  t0; ///< = center + width/2, as used by CalibXT.
+    bool   valid;
+  };
+
+  CalibHitInTimeTable() : m_n_lvl(1) {;}
+  void Build(CalibParamInTimeTaiwan* cal);
+  void Build(CalibParamInTimeV1495 * cal);
+
+  /// Return 0 if no parameter is given for the channel.
+  const Item* Find(const short det, const short ele, const short lvl=0) const {
+    if (det < 0 || det >= (int)m_det_off.size() || ele < 0 || ele >= m_det_n_ele[det] || lvl < 0 || lvl >= m_n_lvl) return 0;
+    const Item* item = &m_items[m_det_off[det] + m_n_lvl * ele + lvl];
+    return item->valid ? item : 0;
+  }
+
+ private:
+  struct Entry {
+    short det;
+    short ele;
+    short lvl;
+    double center;
+    double width;
+  };
+  void Build(const std::vector<Entry>& list);
+
+  int m_n_lvl;
+  std::vector<int>   m_det_off;
+  std::vector<short> m_det_n_ele;
+  std::vector<Item>  m_items;
+};
+
+/// X-T curve of one plane, which gives the same value as TGraph::Eval() on the CalibParamXT graph.
+/// A uniform-bin table is used to find the two points to be interpolated without scanning all points.
+class CalibHitXTCurve {
+ public:
+  CalibHitXTCurve() : m_gr(0), m_t_lo(0), m_inv_step(0) {;}
+  void Build(TGraphErrors* gr);
+  double Eval(const double t) const;
+
+ private:
+  TGraphErrors* m_gr; ///< Used as is when the points are not in increasing order of t.
+  std::vector<double> m_t;
+  std::vector<double> m_x;
+  double m_t_lo;
+  double m_inv_step;
+  std::vector<int> m_bin_idx; ///< Index of the first point with t >= the lower edge of each bin.
+};
+
+/// SubsysReco module that applies CalibInTime, CalibXT and CalibMergeH4 in one pass over the hits.
+/**
+ * All the parameters are converted into flat per-channel tables at InitRun, so that no map lookup
+ * nor string operation is done per hit.  The in-time flag, the drift distance and the merged H4 hits
+ * are identical to what the chain "CalibInTime -> CalibXT -> CalibMergeH4" gives.
+ * Each step can be switched off, e.g. `(new CalibHit())->DoXT(false)`.
+ */
+class CalibHit: public SubsysReco {
+ public:
+  CalibHit(const std::string &name = "CalibHit");
+  virtual ~CalibHit();
+  int Init(PHCompositeNode *topNode);
+  int InitRun(PHCompositeNode *topNode);
+  int process_event(PHCompositeNode *topNode);
+  int End(PHCompositeNode *topNode);
+
+  CalibHit* DoInTime (const bool val=true) { m_do_in_time  = val; return this; }
+  CalibHit* DoXT     (const bool val=true) { m_do_xt       = val; return this; }
+  CalibHit* DoMergeH4(const bool val=true) { m_do_merge_h4 = val; return this; }
+
+  /// Same as CalibMergeH4::SetAndMode() and SetRemoveMode().
+  CalibHit* SetAndMode   (const bool mode=true) { m_and_mode    = mode; return this; }
+  CalibHit* SetRemoveMode(const bool mode=true) { m_remove_mode = mode; return this; }
+
+ private:
+  bool m_do_in_time;
+  bool m_do_xt;
+  bool m_do_merge_h4;
+  bool m_and_mode;
+  bool m_remove_mode;
+
+  CalibParamInTimeTaiwan* m_cal_taiwan;
+  CalibParamInTimeV1495 * m_cal_v1495;
+  CalibParamXT*           m_cal_xt;
+
+  CalibHitInTimeTable m_tab_taiwan;
+  CalibHitInTimeTable m_tab_v1495;
+  std::vector<CalibHitXTCurve> m_xt_curve;
+  std::vector<int>   m_det_xt;     ///< Index in m_xt_curve per det ID, or -1.
+  std::vector<short> m_det_merged; ///< Merged det ID per det ID (0 if not merged).
+
+  void BuildMergedIdTable();
+  short FindMergedId(const short id) const {
+    return (id > 0 && id < (int)m_det_merged.size()) ? m_det_merged[id] : 0;
+  }
+
+  void CalibHits    (SQHitVector* vec);
+  void CalibTrigHits(SQHitVector* vec);
+  void ApplyXT(SQHit* hit, const short det, const short ele, const CalibHitInTimeTable::Item* item);
+  void MergeHitsAnd (SQHitVector* vec);
+};
+
+#endif /* __CALIB_HIT_H__ */
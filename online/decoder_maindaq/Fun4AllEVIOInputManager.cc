@@ -37,6 +37,18 @@
 
 using namespace std;
 
+namespace {
+  /// Copy one decoded hit into a new hit of SQHitVector, see SQHitVector::fill()
+  void FillHit(const HitData& hd, SQHit* hit)
+  {
+    hit->set_hit_id     (hd.id  );
+    hit->set_detector_id(hd.det );
+    hit->set_element_id (hd.ele );
+    hit->set_level      (hd.lvl );
+    hit->set_tdc_time   (hd.time);
+  }
+}
+
 Fun4AllEVIOInputManager::Fun4AllEVIOInputManager(const string &name, const string &topnodename) :
  Fun4AllInputManager(name, ""),
  segment(-999),
@@ -338,29 +350,8 @@ int Fun4AllEVIOInputManager::run(const int nevents)
   event_header->set_n_board_trig_bit  (ed->n_trig_b);
   event_header->set_n_board_trig_count(ed->n_trig_c);
 
-  for (HitDataList::iterator it = ed->list_hit.begin(); it != ed->list_hit.end(); it++) {
-    HitData* hd = &*it;
-    SQHit* hit = new SQHit_v1();
-    hit->set_hit_id     (hd->id  );
-    hit->set_detector_id(hd->det );
-    hit->set_element_id (hd->ele );
-    hit->set_level      (hd->lvl );
-    hit->set_tdc_time   (hd->time);
-    hit_vec->push_back(hit);
-    delete hit;
-  }
-
-  for (HitDataList::iterator it = ed->list_hit_trig.begin(); it != ed->list_hit_trig.end(); it++) {
-    HitData* hd = &*it;
-    SQHit* hit = new SQHit_v1();
-    hit->set_hit_id     (hd->id  );
-    hit->set_detector_id(hd->det );
-    hit->set_element_id (hd->ele );
-    hit->set_level      (hd->lvl );
-    hit->set_tdc_time   (hd->time);
-    trig_hit_vec->push_back(hit);
-    delete hit;
-  }
+  hit_vec     ->fill(ed->list_hit     .data(), ed->list_hit     .size(), FillHit);
+  trig_hit_vec->fill(ed->list_hit_trig.data(), ed->list_hit_trig.size(), FillHit);
 
   // check if the local SubsysReco discards this event
   if (RejectEvent() != Fun4AllReturnCodes::EVENT_OK)
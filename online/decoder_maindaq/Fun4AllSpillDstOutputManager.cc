@@ -1,24 +1,157 @@
 #include <sstream>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <RVersion.h>
+#include <TROOT.h>
 #include <TSystem.h>
 #include <interface_main/SQEvent.h>
 #include <phool/getClass.h>
+#include <phool/PHCompositeNode.h>
+#include <phool/PHNodeIterator.h>
+#include <phool/PHIODataNode.h>
+#include <phool/PHNodeIOManager.h>
+#include <phool/PHPointerListIterator.h>
 #include <fun4all/Fun4AllServer.h>
+#include <fun4all/Fun4AllEventIndex.h>
 #include "Fun4AllSpillDstOutputManager.h"
 using namespace std;
 
+namespace {
+  /// Deep copy of the persistent nodes under `node`, so that it can be written by another thread.
+  PHCompositeNode* CloneNode(PHCompositeNode* node)
+  {
+    PHCompositeNode* node_new = new PHCompositeNode(node->getName());
+    PHNodeIterator nodeiter(node);
+    PHPointerListIterator<PHNode> iter(nodeiter.ls());
+    PHNode* sub;
+    while ((sub = iter())) {
+      if (sub->getType() == "PHCompositeNode") {
+        node_new->addNode(CloneNode(static_cast<PHCompositeNode*>(sub)));
+      } else if (sub->getType() == "PHIODataNode" && sub->isPersistent()) {
+        PHIODataNode<TObject>* dn = static_cast<PHIODataNode<TObject>*>(sub);
+        dn->materialize();
+        TObject* obj = dn->getData();
+        if (obj) node_new->addNode(new PHIODataNode<TObject>(obj->Clone(), dn->getName(), dn->getObjectType()));
+      }
+    }
+    return node_new;
+  }
+}
+
+/// Background thread that finishes the DST files handed over at the spill-group boundaries.
+class Fun4AllSpillDstOutputManager::Closer {
+ public:
+  struct Job {
+    PHNodeIOManager*   io;    ///< Manager of the event tree.  Deleting it flushes and closes the file.
+    PHCompositeNode*   run;   ///< Copy of the RUN node, written to the run tree.
+    Fun4AllEventIndex* index; ///< Event index of the file, or 0.
+    std::string        file_name;
+  };
+
+  Closer() : m_n_job(0), m_stop(false) {;}
+  ~Closer();
+
+  void Add(const Job& job, const int n_max);
+  void WaitAll();
+  static void Finish(Job& job);
+
+ private:
+  std::deque<Job> m_jobs;
+  int  m_n_job; ///< Number of jobs queued or in progress.
+  bool m_stop;
+  std::thread m_thread;
+  std::mutex m_mtx;
+  std::condition_variable m_cv_job;
+  std::condition_variable m_cv_done;
+
+  void Loop();
+};
+
+Fun4AllSpillDstOutputManager::Closer::~Closer()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_stop = true;
+  }
+  m_cv_job.notify_all();
+  if (m_thread.joinable()) m_thread.join(); // Loop() returns after all the queued jobs are done.
+}
+
+/// Queue a job, after waiting until less than `n_max` jobs are pending.
+void Fun4AllSpillDstOutputManager::Closer::Add(const Job& job, const int n_max)
+{
+  std::unique_lock<std::mutex> lock(m_mtx);
+  m_cv_done.wait(lock, [this, n_max] { return m_n_job < n_max; });
+  if (! m_thread.joinable()) m_thread = std::thread(&Closer::Loop, this);
+  m_jobs.push_back(job);
+  m_n_job++;
+  lock.unlock();
+  m_cv_job.notify_one();
+}
+
+void Fun4AllSpillDstOutputManager::Closer::WaitAll()
+{
+  std::unique_lock<std::mutex> lock(m_mtx);
+  m_cv_done.wait(lock, [this] { return m_n_job == 0; });
+}
+
+void Fun4AllSpillDstOutputManager::Closer::Loop()
+{
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(m_mtx);
+      m_cv_job.wait(lock, [this] { return m_stop || ! m_jobs.empty(); });
+      if (m_jobs.empty()) return;
+      job = m_jobs.front();
+      m_jobs.pop_front();
+    }
+    Finish(job);
+    {
+      std::lock_guard<std::mutex> lock(m_mtx);
+      m_n_job--;
+    }
+    m_cv_done.notify_all();
+  }
+}
+
+/// Same steps as Fun4AllDstOutputManager::WriteNode(), on the objects owned by the job.
+void Fun4AllSpillDstOutputManager::Closer::Finish(Job& job)
+{
+  delete job.io;
+  PHNodeIOManager* io_run = new PHNodeIOManager(job.file_name, PHUpdate, PHRunTree);
+  io_run->write(job.run);
+  delete io_run;
+  if (job.index) {
+    job.index->Write(job.file_name);
+    delete job.index;
+  }
+  delete job.run;
+}
+
 Fun4AllSpillDstOutputManager::Fun4AllSpillDstOutputManager(const string &dir_base, const string &myname)
   : Fun4AllDstOutputManager(myname, "")
   , m_dir_base(dir_base)
   , m_sp_step(10)
   , m_run_id(0)
   , m_sp_id(0)
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,00,0)
+  , m_n_close_max(2)
+#else
+  , m_n_close_max(0) // ROOT 5 has no thread-safe I/O.
+#endif
+  , m_closer(0)
 {
-  ;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,00,0)
+  ROOT::EnableThreadSafety(); // Needed to write two files in parallel.
+#endif
 }
 
 Fun4AllSpillDstOutputManager::~Fun4AllSpillDstOutputManager()
 {
-  ;
+  if (m_closer) delete m_closer;
 }
 
 int Fun4AllSpillDstOutputManager::Write(PHCompositeNode *startNode)
@@ -41,7 +174,7 @@ int Fun4AllSpillDstOutputManager::Write(PHCompositeNode *startNode)
         cout << PHWHERE << "RUN not found.  Abort." << endl;
         exit(1);
       }
-      WriteNode(run); // dstOut is deleted at the beginning of this function.
+      CloseFile(run); // dstOut is handed over or deleted in this function.
     }
 
     /// Open a new DST file.
@@ -61,3 +194,33 @@ int Fun4AllSpillDstOutputManager::Write(PHCompositeNode *startNode)
   }
   return Fun4AllDstOutputManager::Write(startNode);
 }
+
+/// Called by Fun4AllServer::End() for the last file, after the previous files are finished.
+int Fun4AllSpillDstOutputManager::WriteNode(PHCompositeNode *thisNode)
+{
+  if (m_closer) m_closer->WaitAll();
+  return Fun4AllDstOutputManager::WriteNode(thisNode);
+}
+
+/// Hand the current file over to the background thread, or finish it here if m_n_close_max = 0.
+void Fun4AllSpillDstOutputManager::CloseFile(PHCompositeNode *run)
+{
+  if (m_n_close_max <= 0) {
+    Fun4AllDstOutputManager::WriteNode(run);
+    return;
+  }
+  Closer::Job job;
+  job.io        = dstOut;
+  job.run       = CloneNode(run); // The RUN node itself can be modified while the job is pending.
+  job.index     = 0;
+  job.file_name = outfilename;
+  if (evtIndex && evtIndex->Size() > 0) {
+    job.index = new Fun4AllEventIndex(evtIndex->GetNodeName());
+    for (unsigned int ii = 0; ii < evtIndex->Size(); ii++) job.index->Add(evtIndex->At(ii).key, evtIndex->At(ii).entry);
+    evtIndex->Clear();
+  }
+  dstOut = 0;
+
+  if (! m_closer) m_closer = new Closer();
+  m_closer->Add(job, m_n_close_max);
+}
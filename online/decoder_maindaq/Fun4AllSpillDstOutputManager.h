@@ -10,19 +10,34 @@
  * Fun4AllSpillDstOutputManager* out_sp = new Fun4AllSpillDstOutputManager(UtilOnline::GetDstFileDir() + "/spill");
  * //out_sp->SetSpillStep(50);
  * se->registerOutputManager(out_sp);
+ *
+ * At the spill-group boundary, the previous file is finished (i.e. the RUN node is written
+ * and the remaining baskets are flushed) by a background thread while the new file already
+ * accepts events.  At most `SetMaxClosingFiles()` files (2 by default) are finished at once;
+ * Write() waits when more are pending.  A value of 0 finishes the file in Write() as before.
+ * All pending files are finished before the last file is closed in End().
  */
 class Fun4AllSpillDstOutputManager: public Fun4AllDstOutputManager {
+  class Closer;
+
   std::string m_dir_base;
   int m_sp_step;
   int m_run_id;
   int m_sp_id;
+  int m_n_close_max;
+  Closer* m_closer;
 
  public:
   Fun4AllSpillDstOutputManager(const std::string &dir_base, const std::string &myname = "SPILLDSTOUT");
   virtual ~Fun4AllSpillDstOutputManager();
 
   void SetSpillStep(const int step) { m_sp_step = step; }
+  void SetMaxClosingFiles(const int n) { m_n_close_max = n; }
   int Write(PHCompositeNode *startNode);
+  int WriteNode(PHCompositeNode *thisNode);
+
+ private:
+  void CloseFile(PHCompositeNode *run);
 };
 
 #endif /* __FUN4ALL_SPILL_DST_OUTPUT_MANAGER_H__ */
@@ -17,11 +17,13 @@
 #include "OnlMonServer.h"
 #include "OnlMonCanvas.h"
 #include "OnlMonComm.h"
+#include "OnlMonSpillHist.h"
 #include "OnlMonClient.h"
 using namespace std;
 
 std::vector<OnlMonClient*> OnlMonClient::m_list_us;
 bool OnlMonClient::m_bl_clear_us = true;
+std::string OnlMonClient::m_sp_hist_dir = "";
 
 OnlMonClient::OnlMonClient()
   : SubsysReco("OnlMonClient")
@@ -30,7 +32,9 @@ OnlMonClient::OnlMonClient()
   , m_n_can(1)
   , m_h1_basic_id(0)
   , m_h1_basic_cnt(0)
+  , m_sp_hist(new OnlMonSpillHist())
   , m_spill_id_pre(-1)
+  , m_spill_id_live(0)
   , m_make_sp_hist(true)
 {
   memset(m_list_can, 0, sizeof(m_list_can));
@@ -40,7 +44,7 @@ OnlMonClient::OnlMonClient()
 OnlMonClient::~OnlMonClient()
 {
   if (! m_hm) delete m_hm;
-  ClearSpillHist();
+  delete m_sp_hist;
   ClearHistList(m_list_h1);
   ClearCanvasList();
   m_list_us.erase( find(m_list_us.begin(), m_list_us.end(), this) );
@@ -82,6 +86,13 @@ int OnlMonClient::InitRun(PHCompositeNode* topNode)
   if (!run_header) return Fun4AllReturnCodes::ABORTEVENT;
   m_h1_basic_id->SetBinContent(BIN_RUN, run_header->get_run_id());
 
+  if (m_make_sp_hist && m_sp_hist_dir != "") {
+    gSystem->mkdir(m_sp_hist_dir.c_str(), true);
+    ostringstream oss;
+    oss << m_sp_hist_dir << "/run_" << setfill('0') << setw(6) << run_header->get_run_id() << "_" << Name() << "_spill.dat";
+    m_sp_hist->OpenFile(oss.str());
+  }
+
   return InitRunOnlMon(topNode);
 }
 
@@ -105,6 +116,8 @@ int OnlMonClient::process_event(PHCompositeNode* topNode)
         MakeSpillHist(m_spill_id_pre);
         DisableSpillHist();
       }
+    } else if (m_make_sp_hist) { // First spill
+      m_spill_id_live = sp_id;
     }
     m_spill_id_pre = sp_id;
     OnlMonComm::instance()->AddSpill(sp_id);
@@ -310,35 +323,23 @@ int OnlMonClient::SendHist(TSocket* sock, int sp_min, int sp_max)
 
 void OnlMonClient::ClearSpillHist()
 {
-  for (Name2SpillHistMap_t::iterator it1 = m_map_hist_sp.begin(); it1 != m_map_hist_sp.end(); it1++) {
-    SpillHistMap_t* map_hist = &it1->second;
-    for (SpillHistMap_t::iterator it2 = map_hist->begin(); it2 != map_hist->end(); it2++) {
-      delete it2->second;
-    }
-  }
-  m_map_hist_sp.clear();
+  m_sp_hist->Clear();
+  m_spill_id_live = 0;
 }
 
 /**
- * This function makes a set of histograms for the given spill ID, "spill_id".
- * The set is copied from the histograms managed by "m_hm" into "m_map_hist_sp".
- * When "spill_id_new" is given, a new entry for that spill is added to "m_map_hist_sp",
- * which is just a set of pointers (not cloned objects) to the histograms managed by "m_hm".
+ * This function stores the contents of the histograms managed by "m_hm" into "m_sp_hist"
+ * as those of the given spill ID, "spill_id", and then resets the histograms.
+ * When "spill_id_new" is given, the histograms hold the contents of that spill from now on.
  */
 void OnlMonClient::MakeSpillHist(const int spill_id, const int spill_id_new)
 {
-  bool add_dir = TH1::AddDirectoryStatus();
-  TH1::AddDirectory(false); // Significantly speeds up deleting hists in dtor.
   for (unsigned int ih = 0; ih < m_hm->nHistos(); ih++) {
     TH1* h1 = (TH1*)m_hm->getHisto(ih);
-    string name = h1->GetName();
-    ostringstream oss;
-    oss << name << "_sp" << spill_id;
-    m_map_hist_sp[name][spill_id] = (TH1*)h1->Clone(oss.str().c_str());
+    m_sp_hist->Add(spill_id, ih, h1);
     h1->Reset("M");
-    if (spill_id_new > 0) m_map_hist_sp[name][spill_id_new] = h1;
   }
-  TH1::AddDirectory(add_dir);
+  m_spill_id_live = spill_id_new;
 }
 
 /**
@@ -348,7 +349,7 @@ void OnlMonClient::MakeSpillHist(const int spill_id, const int spill_id_new)
 void OnlMonClient::DisableSpillHist()
 {
   if (! m_make_sp_hist) return;
-  if (m_map_hist_sp.size() > 0) { // Merge existing spill hists
+  if (m_sp_hist->GetNumSpills() > 0) { // Merge existing spill hists
     HistList_t list_h1;
     MakeMergedHist(list_h1);
     for (unsigned int ih = 0; ih < m_hm->nHistos(); ih++) {
@@ -357,46 +358,66 @@ void OnlMonClient::DisableSpillHist()
       h1->Add(list_h1.at(ih));
     }
     ClearHistList(list_h1);
-    ClearSpillHist();
   }
+  ClearSpillHist();
   m_make_sp_hist = false;
   OnlMonComm::instance()->SetSpillSelectability(false);
 }
 
+/**
+ * The contents of the spills in [sp_min, sp_max] are taken from "m_sp_hist",
+ * and those of the current spill ("m_spill_id_live") from "m_hm".
+ */
 void OnlMonClient::MakeMergedHist(HistList_t& list_h1, const int sp_min, const int sp_max)
 {
   bool add_dir = TH1::AddDirectoryStatus();
   TH1::AddDirectory(false);
   ClearHistList(list_h1);
+
+  vector<int> list_sp;
+  m_sp_hist->GetSpillList(list_sp, sp_min, sp_max);
+  bool use_live = m_spill_id_live > 0 && (sp_min <= 0 || m_spill_id_live >= sp_min) && (sp_max <= 0 || m_spill_id_live <= sp_max);
+  if (use_live) list_sp.erase(remove(list_sp.begin(), list_sp.end(), m_spill_id_live), list_sp.end());
+
   for (unsigned int ih = 0; ih < m_hm->nHistos(); ih++) {
     TH1* h1_org = (TH1*)m_hm->getHisto(ih);
     string name = h1_org->GetName();
     TH1* h1 = (TH1*)h1_org->Clone(name.c_str());
     h1->Reset("M");
-    SpillHistMap_t* map_hist = &m_map_hist_sp[name];
-    for (SpillHistMap_t::iterator it = map_hist->begin(); it != map_hist->end(); it++) {
-      int sp_id = it->first;
-      if (sp_min > 0 && sp_id < sp_min) continue;
-      if (sp_max > 0 && sp_id > sp_max) continue;
-      if (name == "h1_basic_id") {
-        h1->SetBinContent(BIN_RUN  , TMath::Max(h1->GetBinContent(BIN_RUN  ), it->second->GetBinContent(BIN_RUN  )));
-        h1->SetBinContent(BIN_SPILL, TMath::Max(h1->GetBinContent(BIN_SPILL), it->second->GetBinContent(BIN_SPILL)));
-        h1->SetBinContent(BIN_EVENT, TMath::Max(h1->GetBinContent(BIN_EVENT), it->second->GetBinContent(BIN_EVENT)));
-        int sp_curr = h1->GetBinContent(BIN_SPILL_MIN);
-        if (sp_curr <= 0 || sp_curr > sp_id) h1->SetBinContent(BIN_SPILL_MIN, sp_id);
-        sp_curr = h1->GetBinContent(BIN_SPILL_MAX);
-        if (sp_curr < sp_id) h1->SetBinContent(BIN_SPILL_MAX, sp_id);
-      } else if (m_hist_mode[name] == MODE_UPDATE) {
-        if (it == --map_hist->end()) h1->Add(it->second); // Take the last one
-      } else { // MODE_ADD
-        h1->Add(it->second);
+    if (name == "h1_basic_id") {
+      TH1* h1_sp = (TH1*)h1_org->Clone((name + "_sp").c_str());
+      for (vector<int>::iterator it = list_sp.begin(); it != list_sp.end(); it++) {
+        h1_sp->Reset("M");
+        m_sp_hist->Fill(h1_sp, *it, ih);
+        MergeBasicID(h1, h1_sp, *it);
       }
+      delete h1_sp;
+      if (use_live) MergeBasicID(h1, h1_org, m_spill_id_live);
+    } else if (m_hist_mode[name] == MODE_UPDATE) { // Take the last one
+      if (use_live && (list_sp.size() == 0 || m_spill_id_live > list_sp.back())) h1->Add(h1_org);
+      else if (list_sp.size() > 0) m_sp_hist->Fill(h1, list_sp.back(), ih);
+    } else { // MODE_ADD
+      for (vector<int>::iterator it = list_sp.begin(); it != list_sp.end(); it++) {
+        m_sp_hist->Fill(h1, *it, ih);
+      }
+      if (use_live) h1->Add(h1_org);
     }
     list_h1.push_back(h1);
   }
   TH1::AddDirectory(add_dir);
 }
 
+void OnlMonClient::MergeBasicID(TH1* h1, const TH1* h1_sp, const int sp_id)
+{
+  h1->SetBinContent(BIN_RUN  , TMath::Max(h1->GetBinContent(BIN_RUN  ), h1_sp->GetBinContent(BIN_RUN  )));
+  h1->SetBinContent(BIN_SPILL, TMath::Max(h1->GetBinContent(BIN_SPILL), h1_sp->GetBinContent(BIN_SPILL)));
+  h1->SetBinContent(BIN_EVENT, TMath::Max(h1->GetBinContent(BIN_EVENT), h1_sp->GetBinContent(BIN_EVENT)));
+  int sp_curr = h1->GetBinContent(BIN_SPILL_MIN);
+  if (sp_curr <= 0 || sp_curr > sp_id) h1->SetBinContent(BIN_SPILL_MIN, sp_id);
+  sp_curr = h1->GetBinContent(BIN_SPILL_MAX);
+  if (sp_curr < sp_id) h1->SetBinContent(BIN_SPILL_MAX, sp_id);
+}
+
 int OnlMonClient::ReceiveHist()
 {
   TSocket* sock = OnlMonComm::instance()->ConnectServer();
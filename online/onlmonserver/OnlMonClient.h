@@ -3,6 +3,7 @@
 #include <fun4all/SubsysReco.h>
 #include "OnlMonCanvas.h"
 class Fun4AllHistoManager;
+class OnlMonSpillHist;
 class TSocket;
 class TH1;
 class TH2;
@@ -15,8 +16,11 @@ class TH3;
  *  - Being filled in process_event() and
  *  - Being saved into ROOT file in SendHist().
  *
- * Spill-by-spill histograms are by default created and held by "m_map_hist_sp".
+ * Spill-by-spill histograms are by default created and held by "m_sp_hist".
  * A set per spill is created when a new spill is found in process_event().
+ * Only its non-empty bins are stored in a compact form (see OnlMonSpillHist),
+ * in memory or in a file under the directory given by SetSpillHistDir().
+ * The contents of the current spill are held by "m_hm" until the next spill is found.
  * The creation is disabled when
  *  - Fun4MainDaq.C starts in the offline mode (via OnlMonServer::GetOnline()) or
  *  - The number of spills processed exceeds "m_n_sp_max_hist".
@@ -53,11 +57,11 @@ class OnlMonClient: public SubsysReco {
   typedef std::vector<TH1*> HistList_t;
   HistList_t m_list_h1;
 
-  typedef std::map<int, TH1*> SpillHistMap_t; // [spill] -> TH1*
-  typedef std::map<std::string, SpillHistMap_t> Name2SpillHistMap_t; // [hist name] 
-  Name2SpillHistMap_t m_map_hist_sp;
+  OnlMonSpillHist* m_sp_hist;
   int m_spill_id_pre;
+  int m_spill_id_live; //< Spill whose contents are held by "m_hm" but not yet by "m_sp_hist".  0 if none.
   bool m_make_sp_hist; //< True if spill-by-spill hists are active.
+  static std::string m_sp_hist_dir; //< Directory of the spill-hist files.  Empty to keep them in memory.
 
   /// List of OnlMonClient objects created.  Used to clear all canvases opened by all objects.
   typedef std::vector<OnlMonClient*> SelfList_t;
@@ -92,6 +96,9 @@ class OnlMonClient: public SubsysReco {
   static void SetClearUsFlag(const bool val) { m_bl_clear_us = val; }
   static bool GetClearUsFlag() { return m_bl_clear_us; }
 
+  static void SetSpillHistDir(const std::string dir) { m_sp_hist_dir = dir; }
+  static std::string GetSpillHistDir() { return m_sp_hist_dir; }
+
   int SendHist(TSocket* sock, int sp_min, int sp_max);
 
  protected:  
@@ -106,6 +113,7 @@ class OnlMonClient: public SubsysReco {
   void MakeSpillHist(const int spill_id, const int spill_id_new=0);
   void DisableSpillHist();
   void MakeMergedHist(HistList_t& list_h1, const int sp_min=0, const int sp_max=0);
+  void MergeBasicID(TH1* h1, const TH1* h1_sp, const int sp_id);
   int  ReceiveHist();
   void ClearHistList(HistList_t& list_h1);
   void ClearCanvasList();
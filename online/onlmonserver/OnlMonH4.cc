@@ -130,19 +130,18 @@ int OnlMonH4::ProcessEventOnlMon(PHCompositeNode* topNode)
   SQHitVector*      hit_vec = findNode::getClass<SQHitVector>(topNode, "SQHitVector");
   if (!event_header || !hit_vec) return Fun4AllReturnCodes::ABORTEVENT;
 
-  SQHitVector* hv[N_PL];
+  SQHitView hv[N_PL];
   for (int i_pl = 0; i_pl < N_PL; i_pl++) {
-    hv[i_pl] = UtilSQHit::FindHits(hit_vec, m_list_det[i_pl]);
-    for (SQHitVector::ConstIter it = hv[i_pl]->begin(); it != hv[i_pl]->end(); it++) {
+    hv[i_pl] = UtilSQHit::GetHits(hit_vec, m_list_det[i_pl]);
+    for (SQHitView::ConstIter it = hv[i_pl].begin(); it != hv[i_pl].end(); it++) {
       h1_ele [i_pl]->Fill((*it)->get_element_id());
       h1_time[i_pl]->Fill((*it)->get_tdc_time  ());
     }
   }
-  if (hv[0]->size() == 1 && hv[1]->size() == 1) {
-    h2_ele ->Fill( hv[0]->at(0)->get_element_id(), hv[1]->at(0)->get_element_id() );
-    h2_time->Fill( hv[0]->at(0)->get_tdc_time  (), hv[1]->at(0)->get_tdc_time  () );
+  if (hv[0].size() == 1 && hv[1].size() == 1) {
+    h2_ele ->Fill( hv[0].at(0)->get_element_id(), hv[1].at(0)->get_element_id() );
+    h2_time->Fill( hv[0].at(0)->get_tdc_time  (), hv[1].at(0)->get_tdc_time  () );
   }
-  for (int i_pl = 0; i_pl < N_PL; i_pl++) delete hv[i_pl];
   
   return Fun4AllReturnCodes::EVENT_OK;
 }
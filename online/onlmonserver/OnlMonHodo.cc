@@ -128,10 +128,9 @@ int OnlMonHodo::ProcessEventOnlMon(PHCompositeNode* topNode)
   SQHitVector*      hit_vec = findNode::getClass<SQHitVector>(topNode, "SQHitVector");
   if (!event_header || !hit_vec) return Fun4AllReturnCodes::ABORTEVENT;
 
-  for (SQHitVector::ConstIter it = hit_vec->begin(); it != hit_vec->end(); it++) {
-    int det_id = (*it)->get_detector_id();
-    for (int i_det = 0; i_det < N_DET; i_det++) {
-      if (list_det_id[i_det] != det_id) continue;
+  for (int i_det = 0; i_det < N_DET; i_det++) {
+    SQHitView hv = hit_vec->get_hits(list_det_id[i_det]);
+    for (SQHitView::ConstIter it = hv.begin(); it != hv.end(); it++) {
       int    ele  = (*it)->get_element_id();
       double time = (*it)->get_tdc_time  ();
       h1_ele     [i_det]->Fill(ele );
@@ -80,11 +80,12 @@ int OnlMonProp::ProcessEventOnlMon(PHCompositeNode* topNode)
   SQHitVector*      hit_vec = findNode::getClass<SQHitVector>(topNode, "SQHitVector");
   if (!event_header || !hit_vec) return Fun4AllReturnCodes::ABORTEVENT;
 
-  for (SQHitVector::ConstIter it = hit_vec->begin(); it != hit_vec->end(); it++) {
-    int pl = (*it)->get_detector_id() - m_pl0;
-    if (pl < 0 || pl >= N_PL) continue;
-    h1_ele [pl]->Fill((*it)->get_element_id());
-    h1_time[pl]->Fill((*it)->get_tdc_time  ());
+  for (int pl = 0; pl < N_PL; pl++) {
+    SQHitView hv = hit_vec->get_hits(m_pl0 + pl);
+    for (SQHitView::ConstIter it = hv.begin(); it != hv.end(); it++) {
+      h1_ele [pl]->Fill((*it)->get_element_id());
+      h1_time[pl]->Fill((*it)->get_tdc_time  ());
+    }
   }
   
   return Fun4AllReturnCodes::EVENT_OK;
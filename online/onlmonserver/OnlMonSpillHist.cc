@@ -0,0 +1,229 @@
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <TH1.h>
+#include "OnlMonSpillHist.h"
+using namespace std;
+
+namespace {
+  enum { FLAG_INT = 0x1, FLAG_SUMW2 = 0x2 };
+
+  void PutVarint(string& buf, unsigned long long val)
+  {
+    while (val >= 0x80) {
+      buf += (char)((val & 0x7f) | 0x80);
+      val >>= 7;
+    }
+    buf += (char)val;
+  }
+
+  unsigned long long GetVarint(const string& buf, size_t& pos)
+  {
+    unsigned long long val = 0;
+    for (int shift = 0; pos < buf.size(); shift += 7) {
+      unsigned char byte = buf[pos++];
+      val |= (unsigned long long)(byte & 0x7f) << shift;
+      if (! (byte & 0x80)) break;
+    }
+    return val;
+  }
+
+  /// Zigzag encoding so that small negative values are also short.
+  void PutInt(string& buf, const long long val)
+  {
+    PutVarint(buf, ((unsigned long long)val << 1) ^ (unsigned long long)(val >> 63));
+  }
+
+  long long GetInt(const string& buf, size_t& pos)
+  {
+    unsigned long long val = GetVarint(buf, pos);
+    return (long long)(val >> 1) ^ -(long long)(val & 1);
+  }
+
+  void PutDouble(string& buf, const double val)
+  {
+    char bytes[sizeof(double)];
+    memcpy(bytes, &val, sizeof(double));
+    buf.append(bytes, sizeof(double));
+  }
+
+  double GetDouble(const string& buf, size_t& pos)
+  {
+    double val = 0;
+    if (pos + sizeof(double) <= buf.size()) memcpy(&val, buf.data() + pos, sizeof(double));
+    pos += sizeof(double);
+    return val;
+  }
+
+  int GetNumCells(const TH1* h1)
+  {
+    int n_cell = h1->GetNbinsX() + 2;
+    if (h1->GetDimension() > 1) n_cell *= h1->GetNbinsY() + 2;
+    if (h1->GetDimension() > 2) n_cell *= h1->GetNbinsZ() + 2;
+    return n_cell;
+  }
+}
+
+OnlMonSpillHist::OnlMonSpillHist()
+  : m_file_name("")
+  , m_file_size(0)
+{
+  ;
+}
+
+OnlMonSpillHist::~OnlMonSpillHist()
+{
+  Clear();
+}
+
+/// Store the records into "file_name" from now on.  Return 0 if OK.
+int OnlMonSpillHist::OpenFile(const std::string file_name)
+{
+  Clear();
+  m_file.open(file_name.c_str(), ios::in | ios::out | ios::trunc | ios::binary);
+  if (! m_file.is_open()) {
+    cerr << "WARNING:  OnlMonSpillHist::OpenFile():  Cannot open '" << file_name << "'.  Keep spill hists in memory." << endl;
+    return 1;
+  }
+  m_file_name = file_name;
+  m_file_size = 0;
+  return 0;
+}
+
+void OnlMonSpillHist::Clear()
+{
+  m_map.clear();
+  if (m_file.is_open()) {
+    m_file.close();
+    remove(m_file_name.c_str());
+  }
+  m_file_name = "";
+  m_file_size = 0;
+}
+
+/// Store the contents of "h1" as the "idx"-th histogram of spill "spill_id".
+void OnlMonSpillHist::Add(const int spill_id, const unsigned int idx, const TH1* h1)
+{
+  const int n_cell = GetNumCells(h1);
+  const TArrayD* sumw2 = h1->GetSumw2N() > 0 ? const_cast<TH1*>(h1)->GetSumw2() : 0;
+  vector<int> list_bin;
+  bool is_int = true;
+  for (int bin = 0; bin < n_cell; bin++) {
+    double cont = h1->GetBinContent(bin);
+    if (cont == 0 && (! sumw2 || sumw2->At(bin) == 0)) continue;
+    list_bin.push_back(bin);
+    if (is_int && (cont != floor(cont) || fabs(cont) > 1e15)) is_int = false;
+  }
+
+  string buf;
+  PutVarint(buf, list_bin.size());
+  PutVarint(buf, (is_int ? FLAG_INT : 0) | (sumw2 ? FLAG_SUMW2 : 0));
+  int bin_pre = -1;
+  for (vector<int>::iterator it = list_bin.begin(); it != list_bin.end(); it++) {
+    PutVarint(buf, *it - bin_pre);
+    bin_pre = *it;
+    double cont = h1->GetBinContent(*it);
+    if (is_int) PutInt(buf, (long long)cont);
+    else        PutDouble(buf, cont);
+    if (sumw2) PutDouble(buf, sumw2->At(*it));
+  }
+
+  double stats[TH1::kNstat];
+  memset(stats, 0, sizeof(stats));
+  h1->GetStats(stats);
+  int n_stat = TH1::kNstat;
+  while (n_stat > 0 && stats[n_stat-1] == 0) n_stat--;
+  PutVarint(buf, n_stat);
+  for (int ii = 0; ii < n_stat; ii++) PutDouble(buf, stats[ii]);
+  PutDouble(buf, h1->GetEntries());
+
+  RecordList_t* list_rec = &m_map[spill_id];
+  if (list_rec->size() <= idx) list_rec->resize(idx + 1);
+  Record* rec = &list_rec->at(idx);
+  rec->pos = 0;
+  rec->len = buf.size();
+  if (m_file.is_open()) {
+    m_file.seekp(m_file_size);
+    m_file.write(buf.data(), buf.size());
+    rec->pos = m_file_size;
+    m_file_size += buf.size();
+    rec->buf = "";
+  } else {
+    rec->buf.swap(buf);
+  }
+}
+
+/// Add the "idx"-th histogram of spill "spill_id" to "h1", as TH1::Add() does.  Return false if not found.
+bool OnlMonSpillHist::Fill(TH1* h1, const int spill_id, const unsigned int idx)
+{
+  SpillMap_t::iterator it = m_map.find(spill_id);
+  if (it == m_map.end() || idx >= it->second.size()) return false;
+  const string* ptr = ReadRecord(it->second[idx]);
+  if (! ptr) return false;
+  const string& buf = *ptr;
+
+  double stats[TH1::kNstat];
+  memset(stats, 0, sizeof(stats));
+  h1->GetStats(stats); // Before the bin contents are changed.
+  double entries = h1->GetEntries();
+
+  size_t pos = 0;
+  unsigned int n_bin = GetVarint(buf, pos);
+  int flag = GetVarint(buf, pos);
+  if ((flag & FLAG_SUMW2) && h1->GetSumw2N() == 0) h1->Sumw2();
+  TArrayD* sumw2 = h1->GetSumw2N() > 0 ? h1->GetSumw2() : 0;
+  int bin = -1;
+  for (unsigned int ii = 0; ii < n_bin; ii++) {
+    bin += GetVarint(buf, pos);
+    double cont = (flag & FLAG_INT) ? (double)GetInt(buf, pos) : GetDouble(buf, pos);
+    double err2 = (flag & FLAG_SUMW2) ? GetDouble(buf, pos) : cont;
+    h1->AddBinContent(bin, cont);
+    if (sumw2) sumw2->AddAt(sumw2->At(bin) + err2, bin);
+  }
+
+  int n_stat = GetVarint(buf, pos);
+  for (int ii = 0; ii < n_stat && ii < TH1::kNstat; ii++) stats[ii] += GetDouble(buf, pos);
+  entries += GetDouble(buf, pos);
+  h1->PutStats(stats);
+  h1->SetEntries(fabs(entries));
+  return true;
+}
+
+/// Make a list of spills in [sp_min, sp_max] in increasing order, where 0 means no limit.
+void OnlMonSpillHist::GetSpillList(std::vector<int>& list, const int sp_min, const int sp_max) const
+{
+  list.clear();
+  for (SpillMap_t::const_iterator it = m_map.begin(); it != m_map.end(); it++) {
+    if (sp_min > 0 && it->first < sp_min) continue;
+    if (sp_max > 0 && it->first > sp_max) continue;
+    list.push_back(it->first);
+  }
+}
+
+unsigned long OnlMonSpillHist::GetMemorySize() const
+{
+  unsigned long size = 0;
+  for (SpillMap_t::const_iterator it1 = m_map.begin(); it1 != m_map.end(); it1++) {
+    for (RecordList_t::const_iterator it2 = it1->second.begin(); it2 != it1->second.end(); it2++) {
+      size += sizeof(Record) + it2->buf.size();
+    }
+  }
+  return size;
+}
+
+/// Return the encoded contents of "rec", or 0 if not available.
+const std::string* OnlMonSpillHist::ReadRecord(const Record& rec)
+{
+  if (rec.len == 0) return 0; // Not stored.
+  if (! rec.buf.empty()) return &rec.buf;
+  m_buf_read.resize(rec.len);
+  m_file.seekg(rec.pos);
+  m_file.read(&m_buf_read[0], rec.len);
+  if (! m_file) {
+    cerr << "WARNING:  OnlMonSpillHist::ReadRecord():  Failed to read '" << m_file_name << "'." << endl;
+    m_file.clear();
+    return 0;
+  }
+  return &m_buf_read;
+}
@@ -0,0 +1,55 @@
+#ifndef _ONL_MON_SPILL_HIST__H_
+#define _ONL_MON_SPILL_HIST__H_
+#include <map>
+#include <vector>
+#include <string>
+#include <fstream>
+class TH1;
+
+/// Archive of the spill-by-spill contents of the histograms of one OnlMon client.
+/**
+ * The contents of one histogram in one spill are stored as a compact record, which holds
+ *  - Only non-empty bins, where the bin index is encoded as a variable-length difference from the previous bin,
+ *  - The bin content as a variable-length integer when it is integral (i.e. normal counts) or a double otherwise,
+ *  - The bin error squared when the histogram has Sumw2, and
+ *  - The statistics (TH1::GetStats) and the number of entries.
+ * The records are kept in memory by default.
+ * When OpenFile() is called, they are written into the file and only their positions are kept in memory.
+ * The file is removed when the archive is cleared.
+ *
+ * Only TH1/TH2/TH3 are supported, not TProfile.
+ */
+class OnlMonSpillHist {
+  struct Record {
+    std::string buf; ///< Encoded contents.  Empty when stored in the file.
+    std::streamoff pos;
+    unsigned int len;
+  };
+  typedef std::vector<Record> RecordList_t; // [hist index]
+  typedef std::map<int, RecordList_t> SpillMap_t; // [spill]
+  SpillMap_t m_map;
+
+  std::string m_file_name;
+  std::fstream m_file;
+  std::streamoff m_file_size;
+  std::string m_buf_read; ///< Buffer of the record read from the file.
+
+ public:
+  OnlMonSpillHist();
+  virtual ~OnlMonSpillHist();
+
+  int  OpenFile(const std::string file_name);
+  void Clear();
+
+  void Add(const int spill_id, const unsigned int idx, const TH1* h1);
+  bool Fill(TH1* h1, const int spill_id, const unsigned int idx);
+
+  int  GetNumSpills() const { return m_map.size(); }
+  void GetSpillList(std::vector<int>& list, const int sp_min=0, const int sp_max=0) const;
+  unsigned long GetMemorySize() const;
+
+ private:
+  const std::string* ReadRecord(const Record& rec);
+};
+
+#endif /* _ONL_MON_SPILL_HIST__H_ */
@@ -9,6 +9,42 @@
 
 #include <vector>
 
+//! \brief one cell of a field grid, inside which the field is the trilinear interpolation of the 8 corners
+//! All lengths and field values are in Geant4/CLHEP units
+struct PHFieldCell
+{
+  double lo[3];            //!< lower corner of the cell
+  double step[3];          //!< cell size
+  double vlo[3];           //!< the cell is valid for vlo < x < vhi
+  double vhi[3];
+  double B[2][2][2][3];    //!< corner values, [x][y][z][component]
+
+  bool Contains(const double point[3]) const
+  {
+    return point[0] > vlo[0] && point[0] < vhi[0] &&
+           point[1] > vlo[1] && point[1] < vhi[1] &&
+           point[2] > vlo[2] && point[2] < vhi[2];
+  }
+
+  //! trilinear interpolation, interpolating z first then y then x
+  void Interpolate(const double point[3], double *Bfield) const
+  {
+    const double xp = (point[0] - lo[0])/step[0];
+    const double yp = (point[1] - lo[1])/step[1];
+    const double zp = (point[2] - lo[2])/step[2];
+    for (int i = 0; i < 3; ++i)
+    {
+      const double i1 = B[0][0][0][i]*(1. - zp) + B[0][0][1][i]*zp;
+      const double i2 = B[0][1][0][i]*(1. - zp) + B[0][1][1][i]*zp;
+      const double j1 = B[1][0][0][i]*(1. - zp) + B[1][0][1][i]*zp;
+      const double j2 = B[1][1][0][i]*(1. - zp) + B[1][1][1][i]*zp;
+      const double w1 = i1*(1. - yp) + i2*yp;
+      const double w2 = j1*(1. - yp) + j2*yp;
+      Bfield[i] = w1*(1. - xp) + w2*xp;
+    }
+  }
+};
+
 //! \brief transient DST object for field storage and access
 class PHField : public PHObject
 {
@@ -27,6 +63,11 @@ class PHField : public PHObject
       const double Point[4],
       double *Bfield) const = 0;
 
+  //! fill the grid cell containing Point, so that callers can interpolate
+  //! nearby points without calling GetFieldValue again.
+  //! @return false if the field is not a single trilinear grid around Point
+  virtual bool GetFieldCell(const double Point[4], PHFieldCell &cell) const { return false; }
+
   virtual void identify(std::ostream& os = std::cout) const {std::cout << "I am a PHField object!" << std::endl;}
 
   void Verbosity(const int i) { verb_ = i; }
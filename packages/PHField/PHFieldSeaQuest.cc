@@ -6,6 +6,7 @@
 #include <boost/tuple/tuple.hpp>
 #include <boost/tuple/tuple_comparison.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <fstream>
@@ -89,6 +90,29 @@ void PHFieldSeaQuest::GetFieldValue(const double point[4], double *Bfield) const
   */
 }
 
+bool PHFieldSeaQuest::GetFieldCell(const double point[4], PHFieldCell& cell) const
+{
+  if(point[2] > zValues[0] && point[2] < zValues[1])
+  {
+    if(!fmag.GetFieldCell(point, cell)) return false;
+    cell.vlo[2] = std::max(cell.vlo[2], double(zValues[0]));
+    cell.vhi[2] = std::min(cell.vhi[2], double(zValues[1]));
+    return true;
+  }
+  else if(point[2] > zValues[2] && point[2] < zValues[3])
+  {
+    double kmag_point[4] = {point[0], point[1], point[2]-kmagZOffset, point[3]};
+    if(!kmag.GetFieldCell(kmag_point, cell)) return false;
+    cell.lo[2]  += kmagZOffset;
+    cell.vlo[2] = std::max(cell.vlo[2] + kmagZOffset, double(zValues[2]));
+    cell.vhi[2] = std::min(cell.vhi[2] + kmagZOffset, double(zValues[3]));
+    return true;
+  }
+
+  //target field or the FMAG-KMAG overlap
+  return false;
+}
+
 void PHFieldSeaQuest::identify(std::ostream& os) const {
 	os << "PHFieldSeaQuest::identify: " << "-------" << endl;
   double point[4] =   {0, 0, 0, 0};
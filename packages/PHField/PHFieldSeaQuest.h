@@ -26,6 +26,9 @@ class PHFieldSeaQuest : public PHField
   //! @param[out] Bfield  field value. In the case of magnetic field, the order is Bx, By, Bz in in Geant4/CLHEP units
   void GetFieldValue(const double Point[4], double *Bfield) const;
 
+  //! cells are provided where only one of FMAG and KMAG contributes
+  bool GetFieldCell(const double Point[4], PHFieldCell &cell) const;
+
   void identify(std::ostream& os = std::cout) const;
 
  protected:
@@ -142,8 +142,18 @@ int SQField3DCartesian::GetGlobalIndex(int xIdx, int yIdx, int zIdx) const
 void SQField3DCartesian::GetFieldValue(const double point[4], double* Bfield) const
 {
   //This 3D intepolation algorithm is based on the wiki link http://en.wikipedia.org/wiki/Trilinear_interpolation
+  PHFieldCell cell;
+  if(!GetFieldCell(point, cell))
+  {
+    //Out-of-boundary coordinates: zero bfield
+    for(int i = 0; i < 3; ++i) Bfield[i] = 0.;
+    return;
+  }
+  cell.Interpolate(point, Bfield);
+}
 
-  for(int i = 0; i < 3; ++i) Bfield[i] = 0.;
+bool SQField3DCartesian::GetFieldCell(const double point[4], PHFieldCell& cell) const
+{
   double x = point[0];
   double y = point[1];
   double z = point[2];
@@ -158,45 +168,34 @@ void SQField3DCartesian::GetFieldValue(const double point[4], double* Bfield) co
   if(ubx < 0 || uby < 0 || ubz < 0 ||
      obx >= xsteps || oby >= ysteps || obz >= zsteps)
   {
-    /*
-    static int ifirst = 0;
-    if(ifirst < 10)
+    return false;
+  }
+
+  const FieldPoint& p000 = fpoints[GetGlobalIndex(ubx, uby, ubz)];
+  cell.lo[0] = p000.x;
+  cell.lo[1] = p000.y;
+  cell.lo[2] = p000.z;
+  cell.step[0] = xstepsize;
+  cell.step[1] = ystepsize;
+  cell.step[2] = zstepsize;
+  for(int i = 0; i < 3; ++i)
+  {
+    cell.vlo[i] = cell.lo[i];
+    cell.vhi[i] = cell.lo[i] + cell.step[i];
+  }
+
+  for(int ix = 0; ix < 2; ++ix)
+  {
+    for(int iy = 0; iy < 2; ++iy)
     {
-      ++ifirst;
-      std::cout << "SQField3DCartesian::GetFieldValue: WARNING " << filename << " "
-                << "Out-of-boundary coordinates: "
-                << "x: " << x/cm
-                << ", y: " << y/cm
-                << ", z: " << z/cm
-                << " bailing out returning zero bfield" << std::endl;
+      for(int iz = 0; iz < 2; ++iz)
+      {
+        const TVector3& B = fpoints[GetGlobalIndex(ubx + ix, uby + iy, ubz + iz)].B;
+        cell.B[ix][iy][iz][0] = B.X();
+        cell.B[ix][iy][iz][1] = B.Y();
+        cell.B[ix][iy][iz][2] = B.Z();
+      }
     }
-    */
-    return;
   }
-
-  int idx000 = GetGlobalIndex(ubx, uby, ubz);
-  int idx001 = GetGlobalIndex(ubx, uby, obz);
-  int idx010 = GetGlobalIndex(ubx, oby, ubz);
-  int idx011 = GetGlobalIndex(ubx, oby, obz);
-  int idx100 = GetGlobalIndex(obx, uby, ubz);
-  int idx101 = GetGlobalIndex(obx, uby, obz);
-  int idx110 = GetGlobalIndex(obx, oby, ubz);
-  int idx111 = GetGlobalIndex(obx, oby, obz);
-
-  double xp = (x - fpoints[idx000].x)/xstepsize;
-  double yp = (y - fpoints[idx000].y)/ystepsize;
-  double zp = (z - fpoints[idx000].z)/zstepsize;
-
-  TVector3 i1 = fpoints[idx000].B*(1. - zp) + fpoints[idx001].B*zp;
-  TVector3 i2 = fpoints[idx010].B*(1. - zp) + fpoints[idx011].B*zp;
-  TVector3 j1 = fpoints[idx100].B*(1. - zp) + fpoints[idx101].B*zp;
-  TVector3 j2 = fpoints[idx110].B*(1. - zp) + fpoints[idx111].B*zp;
-
-  TVector3 w1 = i1*(1. - yp) + i2*yp;
-  TVector3 w2 = j1*(1. - yp) + j2*yp;
-
-  TVector3 res = w1*(1. - xp) + w2*xp;
-  Bfield[0] = res.X();
-  Bfield[1] = res.Y();
-  Bfield[2] = res.Z();
+  return true;
 }
@@ -20,6 +20,7 @@ public:
   //! @param[in]  Point   space time coordinate. x, y, z, t in Geant4/CLHEP units
   //! @param[out] Bfield  field value. In the case of magnetic field, the order is Bx, By, Bz in in Geant4/CLHEP units
   void GetFieldValue(const double Point[4], double *Bfield) const;
+  bool GetFieldCell(const double Point[4], PHFieldCell &cell) const;
 
   //! return the min and max in z
   double GetZMin() const { return zmin; }
@@ -20,15 +20,14 @@ SQHitVector* UtilSQHit::FindHits(const SQHitVector* vec_in, const std::string de
 
 /**
  * See the other FindHits() function to find how to handle the returned object.
+ * Consider GetHits() when a copy of the hits is not needed.
  */
 SQHitVector* UtilSQHit::FindHits(const SQHitVector* vec_in, const int det_id)
 {
   SQHitVector* vec = vec_in->Clone();
   vec->clear();
-  for (SQHitVector::ConstIter it = vec_in->begin(); it != vec_in->end(); it++) {
-    SQHit* hit = *it;
-    if (hit->get_detector_id() == det_id) vec->push_back(hit);
-  }
+  SQHitView hv = vec_in->get_hits(det_id);
+  for (SQHitView::ConstIter it = hv.begin(); it != hv.end(); it++) vec->push_back(*it);
   return vec;
 }
 
@@ -43,26 +42,45 @@ SQHitVector* UtilSQHit::FindFirstHits(const SQHitVector* vec_in, const std::stri
 
 /**
  * See FindHits() to find how to handle the returned object.
+ * Consider GetFirstHits() when a copy of the hits is not needed.
  */
 SQHitVector* UtilSQHit::FindFirstHits(const SQHitVector* vec_in, const int det_id)
 {
-  map<int, double> id2time; // [element ID] = first (max) tdcTime;
-  map<int, int   > id2idx ; // [element ID] = index of vec_in
-  for (unsigned int idx = 0; idx < vec_in->size(); idx++) {
-    const SQHit* hit = vec_in->at(idx);
-    if (hit->get_detector_id() != det_id) continue;
-    short  ele_id = hit->get_element_id();
-    double time   = hit->get_tdc_time();
-    if (id2time.find(ele_id) == id2time.end() || time > id2time[ele_id]) {
-      id2time[ele_id] = time;
-      id2idx [ele_id] = idx;
-    }
-  }
-
   SQHitVector* vec = vec_in->Clone();
   vec->clear();
-  for (map<int, int>::iterator it = id2idx.begin(); it != id2idx.end(); it++) {
-    vec->push_back(vec_in->at(it->second));
-  }
+  SQHitView hv = vec_in->get_first_hits(det_id);
+  for (SQHitView::ConstIter it = hv.begin(); it != hv.end(); it++) vec->push_back(*it);
   return vec;
 }
+
+/**
+ * The returned view points into "vec_in" and is valid until "vec_in" is modified.
+ * @code
+ *   SQHitView hv_h1t = UtilSQHit::GetHits(hit_vec, "H1T");
+ *   cout << "N = " << hv_h1t.size() << endl;
+ * @endcode
+ */
+SQHitView UtilSQHit::GetHits(const SQHitVector* vec_in, const std::string det_name)
+{
+  GeomSvc* geom = GeomSvc::instance();
+  return vec_in->get_hits(geom->getDetectorID(det_name));
+}
+
+SQHitView UtilSQHit::GetHits(const SQHitVector* vec_in, const int det_id)
+{
+  return vec_in->get_hits(det_id);
+}
+
+/**
+ * See GetHits() to find how to handle the returned view.
+ */
+SQHitView UtilSQHit::GetFirstHits(const SQHitVector* vec_in, const std::string det_name)
+{
+  GeomSvc* geom = GeomSvc::instance();
+  return vec_in->get_first_hits(geom->getDetectorID(det_name));
+}
+
+SQHitView UtilSQHit::GetFirstHits(const SQHitVector* vec_in, const int det_id)
+{
+  return vec_in->get_first_hits(det_id);
+}
@@ -1,6 +1,8 @@
 #ifndef _UTIL_SQHIT__H_
 #define _UTIL_SQHIT__H_
+#include <string>
 class SQHitVector;
+class SQHitView;
 
 /// A set of utility functions about SQHit.
 namespace UtilSQHit {
@@ -11,6 +13,14 @@ namespace UtilSQHit {
   /// Extract a set of first hits that are of the given detector (det_name), where "first" means the earliest (i.e. largest TDC time) hit per element.
   SQHitVector* FindFirstHits(const SQHitVector* vec_in, const std::string det_name);
   SQHitVector* FindFirstHits(const SQHitVector* vec_in, const int         det_id  );
+
+  /// Same as FindHits() but return a view into "vec_in" instead of a new SQHitVector.  No hit is copied.
+  SQHitView GetHits(const SQHitVector* vec_in, const std::string det_name);
+  SQHitView GetHits(const SQHitVector* vec_in, const int         det_id  );
+
+  /// Same as FindFirstHits() but return a view into "vec_in" instead of a new SQHitVector.  No hit is copied.
+  SQHitView GetFirstHits(const SQHitVector* vec_in, const std::string det_name);
+  SQHitView GetFirstHits(const SQHitVector* vec_in, const int         det_id  );
 };
 
 #endif /* _UTIL_SQHIT__H_ */
@@ -122,10 +122,9 @@ int RndmEmbed::process_event(PHCompositeNode* topNode) {
   		{
 				double drift = plane.spacing * gsl_ran_flat(RandomGenerator, -1, 1);
 
-				auto up_digiHit = std::unique_ptr<SQMCHit_v1> (new SQMCHit_v1());
-				auto digiHit = up_digiHit.get();
+				SQHit* digiHit = _hit_vector->emplace_back(true);
 
-				digiHit->set_hit_id(_hit_vector->size());
+				digiHit->set_hit_id(_hit_vector->size() - 1);
 
 				digiHit->set_detector_id(detector_id);
 				digiHit->set_element_id(element_id);
@@ -143,17 +142,14 @@ int RndmEmbed::process_event(PHCompositeNode* topNode) {
 				digiHit->set_truth_x(std::numeric_limits<float>::max());
 				digiHit->set_truth_y(std::numeric_limits<float>::max());
 				digiHit->set_truth_z(std::numeric_limits<float>::max());
-
-				_hit_vector->push_back(digiHit);
   		}
 
   		{
 				double drift = plane.spacing * gsl_ran_flat(RandomGenerator, -1, 1);
 
-				auto up_digiHit = std::unique_ptr<SQMCHit_v1> (new SQMCHit_v1());
-				auto digiHit = up_digiHit.get();
+				SQHit* digiHit = _hit_vector->emplace_back(true);
 
-				digiHit->set_hit_id(_hit_vector->size());
+				digiHit->set_hit_id(_hit_vector->size() - 1);
 
 				digiHit->set_detector_id(detector_id+1);
 				digiHit->set_element_id(element_id);
@@ -171,8 +167,6 @@ int RndmEmbed::process_event(PHCompositeNode* topNode) {
 				digiHit->set_truth_x(std::numeric_limits<float>::max());
 				digiHit->set_truth_y(std::numeric_limits<float>::max());
 				digiHit->set_truth_z(std::numeric_limits<float>::max());
-
-				_hit_vector->push_back(digiHit);
   		}
 
   	}
@@ -130,6 +130,17 @@ bool CalibParamInTimeTaiwan::Find(const short det, const short ele, double& cent
   return false;
 }
 
+/// Access to the parameters in the added order, for users that build their own lookup table.
+/// The later item overrides the earlier one when two items have the same (det, ele), as in Find().
+void CalibParamInTimeTaiwan::GetItem(const int idx, short& det, short& ele, double& center, double& width) const
+{
+  const ParamItem* item = &m_list.at(idx);
+  det    = item->det;
+  ele    = item->ele;
+  center = item->center;
+  width  = item->width;
+}
+
 void CalibParamInTimeTaiwan::Print(std::ostream& os)
 {
   int n_ent = 0;
@@ -140,6 +140,18 @@ bool CalibParamInTimeV1495::Find(const short det, const short ele, const short l
   return false;
 }
 
+/// Access to the parameters in the added order, for users that build their own lookup table.
+/// The later item overrides the earlier one when two items have the same (det, ele, lvl), as in Find().
+void CalibParamInTimeV1495::GetItem(const int idx, short& det, short& ele, short& lvl, double& center, double& width) const
+{
+  const ParamItem* item = &m_list.at(idx);
+  det    = item->det;
+  ele    = item->ele;
+  lvl    = item->lvl;
+  center = item->center;
+  width  = item->width;
+}
+
 void CalibParamInTimeV1495::Print(std::ostream& os)
 {
   int n_ent = 0;
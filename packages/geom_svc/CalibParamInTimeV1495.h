@@ -27,6 +27,8 @@ class CalibParamInTimeV1495 : public CalibParamBase {
   void Add(const std::string det_name, const short det_id, const short ele, const short lvl, const double center, const double width);
 
   bool Find(const short det, const short ele, const short lvl, double& center, double& width);
+  int  GetNumItems() const { return m_list.size(); }
+  void GetItem(const int idx, short& det, short& ele, short& lvl, double& center, double& width) const;
   void Print(std::ostream& os);
 
  protected:
@@ -156,6 +156,13 @@ bool CalibParamXT::Find(const short det, TGraphErrors*& gr_t2x, TGraphErrors*& g
   return false;
 }
 
+/// Return the IDs of all planes that have an X-T curve.
+void CalibParamXT::GetDetIDs(std::vector<short>& list) const
+{
+  list.clear();
+  for (Map_t::const_iterator it = m_map_t2x.begin(); it != m_map_t2x.end(); it++) list.push_back(it->first);
+}
+
 void CalibParamXT::Print(std::ostream& os)
 {
   //int n_ent = 0;
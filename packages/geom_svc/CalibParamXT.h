@@ -26,6 +26,7 @@ class CalibParamXT : public CalibParamBase {
   void Add(const std::string det_name, const short det_id, const double t, const double x, const double dx);
 
   bool Find(const short det, TGraphErrors*& gr_t2x, TGraphErrors*& gr_t2dx);
+  void GetDetIDs(std::vector<short>& list) const;
   void Print(std::ostream& os);
 
  protected:
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <cstdlib>
 #include <fstream>
+#include <algorithm>
 #include <TSQLServer.h>
 #include <TSQLStatement.h>
 #include <db_svc/DbSvc.h>
@@ -38,6 +39,16 @@ std::string ParamRunRange::Find(const int run, const bool exit_on_error)
   return "";
 }
 
+/// Collect the map IDs of all ranges that overlap with [run_b, run_e], without duplication.
+void ParamRunRange::FindAll(const int run_b, const int run_e, std::vector<std::string>& list_map_id)
+{
+  list_map_id.clear();
+  for (RangeList::iterator it = m_list.begin(); it != m_list.end(); it++) {
+    if (it->run_e < run_b || run_e < it->run_b) continue;
+    if (find(list_map_id.begin(), list_map_id.end(), it->map_id) == list_map_id.end()) list_map_id.push_back(it->map_id);
+  }
+}
+
 void ParamRunRange::ReadFromFile(const std::string fn_tsv)
 {
   cout << "  ParamRunRange::ReadFromFile(): " << fn_tsv << "...\n";
@@ -46,11 +57,18 @@ void ParamRunRange::ReadFromFile(const std::string fn_tsv)
     cerr << "\n!!ERROR!!  Cannot open the map file '" << fn_tsv << "'." << endl;
     exit(1);
   } 
+  ReadFromStream(ifs);
+  ifs.close();
+}
+
+/// Read the range list in the format of run_range.tsv.
+void ParamRunRange::ReadFromStream(std::istream& is)
+{
   m_list.clear();
 
   string buffer;
   istringstream iss;
-  while ( getline(ifs, buffer) ) {
+  while ( getline(is, buffer) ) {
     if (buffer[0] == '#') continue;
     iss.clear(); // clear any error flags
     iss.str(buffer);
@@ -61,7 +79,15 @@ void ParamRunRange::ReadFromFile(const std::string fn_tsv)
     cout << "    " << run_b << " " << run_e << " " << map_id << endl;
     Add(run_b, run_e, map_id);
   }
-  ifs.close();
+}
+
+/// Write the range list in the format of run_range.tsv.
+void ParamRunRange::WriteToStream(std::ostream& os)
+{
+  os << "#run_b\trun_e\tmap_id\n";
+  for (RangeList::iterator it = m_list.begin(); it != m_list.end(); it++) {
+    os << it->run_b << "\t" << it->run_e << "\t" << it->map_id << "\n";
+  }
 }
 
 void ParamRunRange::ReadFromDB(const std::string schema)
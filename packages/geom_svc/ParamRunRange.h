@@ -19,6 +19,10 @@ class ParamRunRange {
   void Add(const int run_b, const int run_e, const std::string map_id);
   bool Find(const std::string map_id);
   std::string Find(const int run, const bool exit_on_error=true);
+  void FindAll(const int run_b, const int run_e, std::vector<std::string>& list_map_id);
+
+  void ReadFromStream(std::istream& is);
+  void WriteToStream (std::ostream& os);
 
   void ReadFromFile(const std::string fn_tsv);
   void ReadFromDB  (const std::string schema);
@@ -4,10 +4,41 @@
 #include <cstdlib>
 #include <fstream>
 #include <TSystem.h>
+#include <TFile.h>
+#include <TObjString.h>
 #include <db_svc/DbSvc.h>
 #include "RunParamBase.h"
 using namespace std;
 
+namespace {
+  /// Parameter bundle shared by all objects.  E1039_PARAM_BUNDLE is checked on the first use.
+  bool   bundle_checked = false;
+  string bundle_name;
+  TFile* bundle_file = 0;
+
+  TFile* GetBundleFile()
+  {
+    if (! bundle_checked) {
+      bundle_checked = true;
+      string fn = gSystem->Getenv("E1039_PARAM_BUNDLE");
+      if (fn.length() > 0) RunParamBase::UseBundle(fn);
+    }
+    return bundle_file;
+  }
+
+  /// Get the text stored as "dir/name" in the bundle.  Return false if not found.
+  bool GetBundleText(const string dir, const string name, string& text)
+  {
+    TFile* file = GetBundleFile();
+    if (! file) return false;
+    TObjString* obj = dynamic_cast<TObjString*>(file->Get((dir + "/" + name).c_str()));
+    if (! obj) return false;
+    text = obj->GetString().Data();
+    delete obj;
+    return true;
+  }
+}
+
 RunParamBase::RunParamBase(const std::string type, const std::string label, const std::string header) :
   m_type(type), m_label(label), m_header(header), m_map_id("")
 {
@@ -30,7 +61,7 @@ void RunParamBase::SetMapIDbyFile(const std::string map_id)
 
 void RunParamBase::SetMapIDbyDB(const std::string map_id)
 {
-  m_range.ReadFromDB(RangeFileName().c_str());
+  if (! ReadRangeFromBundle()) m_range.ReadFromDB(SchemaName());
   if (! m_range.Find(map_id)) {
     cout << "  !WARNING!  SetMapIDbyDB():  This map ID '" << map_id
          << "' is not included in the run-range table.  OK?" << endl;
@@ -46,7 +77,7 @@ void RunParamBase::SetMapIDbyFile(const int run)
 
 void RunParamBase::SetMapIDbyDB(const int run)
 {
-  m_range.ReadFromDB(SchemaName());
+  if (! ReadRangeFromBundle()) m_range.ReadFromDB(SchemaName());
   m_map_id = m_range.Find(run);
 }
 
@@ -100,6 +131,7 @@ void RunParamBase::ReadFromDB()
     cerr << "  ERROR:  The map ID is not set.  Abort." << endl;
     exit(1);
   }
+  if (ReadFromBundle()) return;
   string name_schema =   SchemaName();
   string name_table  = MapTableName();
   cout << "Read channel map from "
@@ -137,6 +169,100 @@ void RunParamBase::WriteRangeToDB()
   m_range.WriteToDB(SchemaName());
 }
 
+void RunParamBase::UseBundle(const std::string fn_bundle)
+{
+  bundle_checked = true;
+  if (bundle_file) {
+    bundle_file->Close();
+    delete bundle_file;
+    bundle_file = 0;
+  }
+  bundle_name = fn_bundle;
+  if (fn_bundle.length() == 0) return;
+
+  TDirectory::TContext context; // Keep gDirectory unchanged.
+  bundle_file = TFile::Open(fn_bundle.c_str(), "READ");
+  if (! bundle_file || bundle_file->IsZombie()) {
+    cerr << "\n!!ERROR!!  Cannot open the parameter bundle '" << fn_bundle << "'." << endl;
+    exit(1);
+  }
+  cout << "RunParamBase:  Use the parameter bundle '" << fn_bundle << "'." << endl;
+}
+
+std::string RunParamBase::GetBundle()
+{
+  GetBundleFile();
+  return bundle_name;
+}
+
+/// Add the run range and the current parameter table to the bundle file, which is created if not exist.
+/**
+ * The table is stored in the format of the TSV file, with enough digits to reproduce all values.
+ */
+void RunParamBase::WriteToBundle(const std::string fn_bundle)
+{
+  if (m_map_id.length() == 0) {
+    cerr << "  ERROR:  The map ID is not set.  Abort." << endl;
+    exit(1);
+  }
+  TDirectory::TContext context;
+  TFile* file = TFile::Open(fn_bundle.c_str(), "UPDATE");
+  if (! file || file->IsZombie()) {
+    cerr << "\n!!ERROR!!  Cannot open the parameter bundle '" << fn_bundle << "'." << endl;
+    exit(1);
+  }
+  string name_dir = SchemaName();
+  TDirectory* dir = file->GetDirectory(name_dir.c_str());
+  if (! dir) dir = file->mkdir(name_dir.c_str());
+  dir->cd();
+
+  ostringstream oss;
+  m_range.WriteToStream(oss);
+  TObjString(oss.str().c_str()).Write("run_range", TObject::kOverwrite);
+
+  oss.str("");
+  oss << setprecision(17) << "#" << m_header << "\n";
+  int nn = WriteFileCont(oss);
+  TObjString(oss.str().c_str()).Write(m_map_id.c_str(), TObject::kOverwrite);
+
+  file->Close();
+  delete file;
+  cout << "  RunParamBase::WriteToBundle(): " << name_dir << "/" << m_map_id << " with " << nn << " entries." << endl;
+}
+
+/// Return the map IDs used in the run range [run_b, run_e] according to the DB.
+void RunParamBase::GetMapIDsByDB(const int run_b, const int run_e, std::vector<std::string>& list_map_id)
+{
+  m_range.ReadFromDB(SchemaName());
+  m_range.FindAll(run_b, run_e, list_map_id);
+}
+
+bool RunParamBase::ReadRangeFromBundle()
+{
+  string text;
+  if (! GetBundleText(SchemaName(), "run_range", text)) return false;
+  istringstream iss(text);
+  m_range.ReadFromStream(iss);
+  return true;
+}
+
+bool RunParamBase::ReadFromBundle()
+{
+  string text;
+  if (! GetBundleText(SchemaName(), m_map_id, text)) return false;
+  cout << "Read channel map from the bundle, " << SchemaName() << "/" << m_map_id << "...";
+  istringstream iss(text);
+  LineList lines;
+  string buffer;
+  while ( getline(iss, buffer) ) {
+    if (buffer[0] == '#') continue;
+    lines.push_back(buffer);
+  }
+  int nn = ReadFileCont(lines);
+  cout << " read " << nn << " entries." << endl;
+  return true;
+}
+
 void RunParamBase::Print(std::ostream& os)
 {
   cout << "  virtual function called." << endl;
@@ -40,6 +40,18 @@ class RunParamBase {
   void WriteToDB ();
   void WriteRangeToDB();
 
+  /// Local snapshot ("bundle") of the run ranges and the parameter tables.
+  /**
+   * When a bundle file is given, SetMapIDbyDB() and ReadFromDB() take the run range and
+   * the parameter table from the bundle if they are found there, and fall back to the DB otherwise.
+   * The bundle can also be given by the E1039_PARAM_BUNDLE environment variable.
+   * It is made with WriteToBundle(), typically via macros/MakeParamBundle.C.
+   */
+  static void UseBundle(const std::string fn_bundle);
+  static std::string GetBundle();
+  void WriteToBundle(const std::string fn_bundle);
+  void GetMapIDsByDB(const int run_b, const int run_e, std::vector<std::string>& list_map_id);
+
   virtual void Print(std::ostream& os);
 
  protected:
@@ -48,6 +60,9 @@ class RunParamBase {
   std::string SchemaName();
   std::string MapTableName();
 
+  bool ReadRangeFromBundle();
+  bool ReadFromBundle();
+
   typedef std::vector<std::string> LineList;
   virtual int  ReadFileCont(LineList& lines);
   virtual int WriteFileCont(std::ostream& os);
@@ -4,12 +4,28 @@
 
 #include <CLHEP/Units/SystemOfUnits.h>
 
+namespace
+{
+  //Per-thread field cache, tagged by the GFField that filled it
+  struct GFFieldContext
+  {
+    const SQGenFit::GFField* owner;
+    bool valid;
+    PHFieldCell cell;
+    unsigned long nHits;
+    unsigned long nMisses;
+  };
+
+  thread_local GFFieldContext gfContext = {nullptr, false, PHFieldCell(), 0, 0};
+}
+
 namespace SQGenFit
 {
 GFField::GFField(const PHField* field): _field(field)
 {
   _scale = 1.;
   _disable = false;
+  _useCache = true;
 }
 
 TVector3 GFField::get(const TVector3& pos) const
@@ -36,15 +52,62 @@ void GFField::get(const double& x, const double& y, const double& z, double& Bx,
 
   const double Point[] = {x*CLHEP::cm, y*CLHEP::cm, z*CLHEP::cm, 0.};
   double Bfield[6];
-  for(int i = 0; i < 6; ++i)
+
+  GFFieldContext& ctx = gfContext;
+  if(ctx.owner != this)
   {
-    Bfield[i] = 0.;
+    ctx.owner = this;
+    ctx.valid = false;
+  }
+
+  if(_useCache && ctx.valid && ctx.cell.Contains(Point))
+  {
+    ++ctx.nHits;
+    ctx.cell.Interpolate(Point, Bfield);
+  }
+  else
+  {
+    ++ctx.nMisses;
+    ctx.valid = _useCache && _field->GetFieldCell(Point, ctx.cell) && ctx.cell.Contains(Point);
+    if(ctx.valid)
+    {
+      ctx.cell.Interpolate(Point, Bfield);
+    }
+    else
+    {
+      for(int i = 0; i < 6; ++i)
+      {
+        Bfield[i] = 0.;
+      }
+      _field->GetFieldValue(Point, Bfield);
+    }
   }
 
-  _field->GetFieldValue(Point, Bfield);
   Bx = _scale*Bfield[0]/CLHEP::kilogauss;
   By = _scale*Bfield[1]/CLHEP::kilogauss;
   Bz = _scale*Bfield[2]/CLHEP::kilogauss;
 }
 
-}
\ No newline at end of file
+void GFField::get(const unsigned int n, const double* posX, const double* posY, const double* posZ, double* Bx, double* By, double* Bz) const
+{
+  for(unsigned int i = 0; i < n; ++i)
+  {
+    get(posX[i], posY[i], posZ[i], Bx[i], By[i], Bz[i]);
+  }
+}
+
+void GFField::resetCache() const
+{
+  if(gfContext.owner == this) gfContext.valid = false;
+}
+
+void GFField::printCacheStats(std::ostream& os) const
+{
+  const GFFieldContext& ctx = gfContext;
+  unsigned long nTot = ctx.nHits + ctx.nMisses;
+  os << "GFField cache of this thread: " << nTot << " queries, " << ctx.nHits << " served from the cached cell";
+  if(nTot > 0) os << " (" << 100.*ctx.nHits/nTot << "%)";
+  os << std::endl;
+}
+
+}
@@ -8,6 +8,15 @@
 
 namespace SQGenFit
 {
+/*
+ * GenFit field interface on top of PHField.
+ *
+ * The last grid cell returned by PHField::GetFieldCell is remembered, so the
+ * many nearby queries of one RK step (and of the following steps) are
+ * interpolated locally instead of going through the virtual PHField lookup.
+ * The cache lives in a thread-local context, thus one GFField/PHField can be
+ * shared by fitters running in several threads.
+ */
 class GFField: public genfit::AbsBField
 {
 public:
@@ -17,15 +26,26 @@ public:
   TVector3 get(const TVector3& pos) const;
   void get(const double& posX, const double& posY, const double& posZ, double& Bx, double& By, double& Bz) const;
 
+  //! batch interface, positions in cm and fields in kGauss as in get()
+  void get(const unsigned int n, const double* posX, const double* posY, const double* posZ, double* Bx, double* By, double* Bz) const;
+
   void setScale(double scale) { _scale = scale; }
   void disable() { _disable = true; }
 
+  //! use the cell cache (default), or call PHField for every query
+  void enableCache(bool flag = true) { _useCache = flag; }
+
+  //! forget the cached cell of the calling thread, e.g. at the start of a track
+  void resetCache() const;
+  void printCacheStats(std::ostream& os = std::cout) const;
+
 private:
   const PHField* _field;
   double _scale;
   bool   _disable;
+  bool   _useCache;
 
 };
 }
 
-#endif
\ No newline at end of file
+#endif
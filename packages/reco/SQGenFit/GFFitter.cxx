@@ -9,9 +9,11 @@
 #include <GenFit/MaterialEffects.h>
 #include <GenFit/TGeoMaterialInterface.h>
 
+#include "GFLayeredMaterial.h"
+
 namespace SQGenFit
 {
-GFFitter::GFFitter(): _verbosity(0), _kmfitter(nullptr), _display(nullptr)
+GFFitter::GFFitter(): _verbosity(0), _layeredMaterial(false), _kmfitter(nullptr), _field(nullptr), _display(nullptr)
 {}
 
 GFFitter::~GFFitter()
@@ -28,8 +30,22 @@ void GFFitter::setVerbosity(unsigned int v)
 
 void GFFitter::init(GFField* field, const TString& fitter_choice)
 {
+  _field = field;
   genfit::FieldManager::getInstance()->init(field);
-  genfit::MaterialEffects::getInstance()->init(new genfit::TGeoMaterialInterface());
+  if(_layeredMaterial)
+  {
+    GFLayeredMaterial* material = new GFLayeredMaterial();
+    if(_verbosity > 0)
+    {
+      material->print();
+      material->validate();
+    }
+    genfit::MaterialEffects::getInstance()->init(material);
+  }
+  else
+  {
+    genfit::MaterialEffects::getInstance()->init(new genfit::TGeoMaterialInterface());
+  }
 
   _fitterTy = fitter_choice;
   if(fitter_choice == "KalmanFitterRefTrack")
@@ -60,7 +76,8 @@ int GFFitter::processTrack(GFTrack& track, bool display)
     return -1;
   }
 
-  //Do the fit
+  //Do the fit, starting with a fresh field cell cache for this track
+  if(_field != nullptr) _field->resetCache();
   genfit::Track* gftrack = track.getGenFitTrack();
   try
   {
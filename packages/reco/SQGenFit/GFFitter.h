@@ -20,6 +20,9 @@ public:
 
   void setVerbosity(unsigned int v);
 
+  //Use GFLayeredMaterial instead of the TGeo navigation for material effects, must be set before init
+  void setLayeredMaterial(bool flag = true) { _layeredMaterial = flag; }
+
   void init(GFField* field, const TString& fitter_choice = "KalmanFitterRefTrack");
   int processTrack(GFTrack& track, bool display = false);
 
@@ -31,7 +34,9 @@ public:
 private:
   TString _fitterTy;
   genfit::AbsKalmanFitter* _kmfitter;
+  GFField* _field;
   unsigned int _verbosity;
+  bool _layeredMaterial;
 
   genfit::EventDisplay* _display;
 };
@@ -0,0 +1,417 @@
+#include "GFLayeredMaterial.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <TGeoManager.h>
+#include <TGeoMaterial.h>
+#include <TGeoMatrix.h>
+#include <TGeoNode.h>
+#include <TGeoBBox.h>
+#include <TGeoVolume.h>
+#include <TRandom.h>
+
+#include <GenFit/Exception.h>
+#include <GenFit/MaterialProperties.h>
+#include <GenFit/MeanExcEnergy.h>
+#include <GenFit/RKTrackRep.h>
+
+namespace
+{
+  //tolerance used to decide on which side of a boundary a point is, in cm
+  const double tiny = 1.E-6;
+
+  //relative tolerance used when comparing material parameters with TGeo
+  bool differs(double a, double b) { return fabs(a - b) > 1.E-3*fabs(b); }
+
+  //Orders the regions of a slice deepest volume first
+  struct DeeperFirst
+  {
+    const std::vector<SQGenFit::GFLayeredMaterial::Region>* regions;
+    bool operator()(int a, int b) const { return (*regions)[a].depth > (*regions)[b].depth; }
+  };
+}
+
+namespace SQGenFit
+{
+GFLayeredMaterial::GFLayeredMaterial(TGeoManager* geoManager):
+  _worldMatID(-1),
+  _geoManager(geoManager == nullptr ? gGeoManager : geoManager),
+  _currentRegion(-1),
+  _currentMatID(-1)
+{
+  for(int i = 0; i < 3; ++i)
+  {
+    _pos[i] = 0.;
+    _dir[i] = 0.;
+  }
+
+  if(_geoManager == nullptr)
+  {
+    std::cerr << "GFLayeredMaterial: no TGeoManager available, the model is empty." << std::endl;
+    return;
+  }
+  build(_geoManager);
+}
+
+void GFLayeredMaterial::build(TGeoManager* geoManager)
+{
+  _materials.clear();
+  _matIDs.clear();
+  _regions.clear();
+  _zEdges.clear();
+  _sliceRegions.clear();
+
+  TGeoNode* top = geoManager->GetTopNode();
+  _worldMatID = addMaterial(top->GetVolume()->GetMaterial());
+
+  TGeoHMatrix identity;
+  for(int i = 0; i < top->GetNdaughters(); ++i) addNode(top->GetDaughter(i), identity, 1);
+
+  //Slice edges are the union of all region z boundaries
+  for(auto it = _regions.begin(); it != _regions.end(); ++it)
+  {
+    _zEdges.push_back(it->zmin);
+    _zEdges.push_back(it->zmax);
+  }
+  std::sort(_zEdges.begin(), _zEdges.end());
+  _zEdges.erase(std::unique(_zEdges.begin(), _zEdges.end(), [](double a, double b) { return fabs(a - b) < tiny; }), _zEdges.end());
+
+  DeeperFirst order;
+  order.regions = &_regions;
+  unsigned int nSlices = getNSlices();
+  _sliceRegions.resize(nSlices);
+  for(unsigned int i = 0; i < nSlices; ++i)
+  {
+    double zlo = _zEdges[i] + tiny;
+    double zhi = _zEdges[i+1] - tiny;
+    for(unsigned int j = 0; j < _regions.size(); ++j)
+    {
+      if(_regions[j].zmin <= zlo && _regions[j].zmax >= zhi) _sliceRegions[i].push_back(j);
+    }
+    std::stable_sort(_sliceRegions[i].begin(), _sliceRegions[i].end(), order);
+  }
+}
+
+void GFLayeredMaterial::addNode(TGeoNode* node, const TGeoHMatrix& parentMatrix, int depth)
+{
+  TGeoHMatrix matrix(parentMatrix);
+  matrix.Multiply(node->GetMatrix());
+
+  TGeoVolume* vol = node->GetVolume();
+  if(!vol->IsAssembly())
+  {
+    TGeoBBox* box = static_cast<TGeoBBox*>(vol->GetShape());
+    const double* origin = box->GetOrigin();
+    double half[3] = {box->GetDX(), box->GetDY(), box->GetDZ()};
+
+    Region reg;
+    reg.xmin = reg.ymin = reg.zmin =  std::numeric_limits<double>::max();
+    reg.xmax = reg.ymax = reg.zmax = -std::numeric_limits<double>::max();
+    for(int i = 0; i < 8; ++i)
+    {
+      double local[3], master[3];
+      for(int j = 0; j < 3; ++j) local[j] = origin[j] + ((i >> j) & 1 ? half[j] : -half[j]);
+      matrix.LocalToMaster(local, master);
+
+      reg.xmin = std::min(reg.xmin, master[0]); reg.xmax = std::max(reg.xmax, master[0]);
+      reg.ymin = std::min(reg.ymin, master[1]); reg.ymax = std::max(reg.ymax, master[1]);
+      reg.zmin = std::min(reg.zmin, master[2]); reg.zmax = std::max(reg.zmax, master[2]);
+    }
+    reg.depth = depth;
+    reg.matID = addMaterial(vol->GetMaterial());
+    reg.approx = vol->GetShape()->IsA() != TGeoBBox::Class() || matrix.IsRotation();
+    _regions.push_back(reg);
+  }
+
+  for(int i = 0; i < node->GetNdaughters(); ++i) addNode(node->GetDaughter(i), matrix, depth + 1);
+}
+
+int GFLayeredMaterial::addMaterial(TGeoMaterial* mat)
+{
+  auto known = _matIDs.find(mat);
+  if(known != _matIDs.end()) return known->second;
+
+  MatParams par;
+  par.density = mat->GetDensity();
+  par.Z       = mat->GetZ();
+  par.A       = mat->GetA();
+  par.radLen  = mat->GetRadLen();
+  par.mEE     = genfit::MeanExcEnergy_get(mat); //same as TGeoMaterialInterface
+
+  for(unsigned int i = 0; i < _materials.size(); ++i)
+  {
+    const MatParams& p = _materials[i];
+    if(p.density == par.density && p.Z == par.Z && p.A == par.A && p.radLen == par.radLen) return _matIDs[mat] = i;
+  }
+  _materials.push_back(par);
+  return _matIDs[mat] = _materials.size() - 1;
+}
+
+int GFLayeredMaterial::findSlice(double z) const
+{
+  if(_zEdges.size() < 2 || z < _zEdges.front() || z >= _zEdges.back()) return -1;
+  return std::upper_bound(_zEdges.begin(), _zEdges.end(), z) - _zEdges.begin() - 1;
+}
+
+int GFLayeredMaterial::findRegion(double x, double y, double z) const
+{
+  int slice = findSlice(z);
+  if(slice < 0) return -1;
+
+  const std::vector<int>& regs = _sliceRegions[slice];
+  for(auto it = regs.begin(); it != regs.end(); ++it)
+  {
+    if(_regions[*it].contains(x, y)) return *it;
+  }
+  return -1;
+}
+
+int GFLayeredMaterial::findMaterial(int region, double x, double y, double z)
+{
+  if(region < 0) return _worldMatID;
+  if(!_regions[region].approx) return _regions[region].matID;
+
+  //the bounding box is only an approximation of this volume (e.g. the magnet yokes with a gap or a hole), ask TGeo
+  TGeoNode* node = _geoManager->FindNode(x, y, z);
+  return node == nullptr ? _worldMatID : addMaterial(node->GetVolume()->GetMaterial());
+}
+
+bool GFLayeredMaterial::sameVolume(const double* a, const double* b)
+{
+  int regionA = findRegion(a[0], a[1], a[2]);
+  int regionB = findRegion(b[0], b[1], b[2]);
+  if(regionA != regionB) return false;
+  if(regionA < 0 || !_regions[regionA].approx) return true;
+  return findMaterial(regionA, a[0], a[1], a[2]) == findMaterial(regionB, b[0], b[1], b[2]);
+}
+
+bool GFLayeredMaterial::initTrack(double posX, double posY, double posZ, double dirX, double dirY, double dirZ)
+{
+  _pos[0] = posX; _pos[1] = posY; _pos[2] = posZ;
+  _dir[0] = dirX; _dir[1] = dirY; _dir[2] = dirZ;
+
+  int region = findRegion(posX, posY, posZ);
+  int matID = findMaterial(region, posX, posY, posZ);
+  bool changed = region != _currentRegion || matID != _currentMatID;
+  _currentRegion = region;
+  _currentMatID = matID;
+  return changed;
+}
+
+void GFLayeredMaterial::getMaterialParameters(double& density, double& Z, double& A, double& radiationLength, double& mEE)
+{
+  const MatParams& par = _materials[_currentMatID < 0 ? _worldMatID : _currentMatID];
+  density = par.density;
+  Z = par.Z;
+  A = par.A;
+  radiationLength = par.radLen;
+  mEE = par.mEE;
+}
+
+void GFLayeredMaterial::getMaterialParameters(genfit::MaterialProperties& parameters)
+{
+  double density, Z, A, radLen, mEE;
+  getMaterialParameters(density, Z, A, radLen, mEE);
+  parameters.setMaterialProperties(density, Z, A, radLen, mEE);
+}
+
+double GFLayeredMaterial::distanceToBoundary(const double* pos, const double* dir, double maxDist) const
+{
+  //inside an approximated volume the boundaries are those of the real shapes, as in TGeoMaterialInterface
+  int region = findRegion(pos[0], pos[1], pos[2]);
+  if(region >= 0 && _regions[region].approx)
+  {
+    _geoManager->InitTrack(pos, dir);
+    _geoManager->FindNextBoundary(maxDist);
+    return std::min(maxDist, _geoManager->GetStep());
+  }
+
+  double dist = maxDist;
+
+  //z planes of the slices
+  if(dir[2] > 0.)
+  {
+    auto it = std::upper_bound(_zEdges.begin(), _zEdges.end(), pos[2] + tiny);
+    if(it != _zEdges.end()) dist = std::min(dist, (*it - pos[2])/dir[2]);
+  }
+  else if(dir[2] < 0.)
+  {
+    auto it = std::lower_bound(_zEdges.begin(), _zEdges.end(), pos[2] - tiny);
+    if(it != _zEdges.begin()) dist = std::min(dist, (pos[2] - *(it - 1))/(-dir[2]));
+  }
+
+  //transverse faces of the boxes in the current slice
+  int slice = findSlice(pos[2]);
+  if(slice < 0) return dist;
+
+  const std::vector<int>& regs = _sliceRegions[slice];
+  for(auto it = regs.begin(); it != regs.end(); ++it)
+  {
+    const Region& reg = _regions[*it];
+    const double lo[2] = {reg.xmin, reg.ymin};
+    const double hi[2] = {reg.xmax, reg.ymax};
+
+    double tnear = 0.;
+    double tfar  = std::numeric_limits<double>::max();
+    bool miss = false;
+    for(int j = 0; j < 2; ++j)
+    {
+      if(fabs(dir[j]) < tiny)
+      {
+        if(pos[j] < lo[j] || pos[j] >= hi[j]) miss = true; //parallel and outside
+        continue;
+      }
+      double t1 = (lo[j] - pos[j])/dir[j];
+      double t2 = (hi[j] - pos[j])/dir[j];
+      if(t1 > t2) std::swap(t1, t2);
+      tnear = std::max(tnear, t1);
+      tfar  = std::min(tfar, t2);
+    }
+    if(miss || tnear > tfar) continue;
+
+    //inside the box the next boundary is the exit, otherwise the entry
+    double t = reg.contains(pos[0], pos[1]) ? tfar : tnear;
+    if(t > tiny) dist = std::min(dist, t);
+  }
+
+  return dist;
+}
+
+//Same stepping strategy as genfit::TGeoMaterialInterface::findNextBoundary: straight-line
+//distances to the boundary, with RK steps that are halved while the arc deviates too much
+double GFLayeredMaterial::findNextBoundary(const genfit::RKTrackRep* rep, const genfit::M1x7& stateOrig, double sMax, bool varField)
+{
+  const double delta(1.E-2);    // cm, distance limit beneath which straight-line steps are taken
+  const double epsilon(1.E-1);  // cm, allowed upper bound on arch deviation from straight line
+  const unsigned int maxIt = 300;
+
+  int stepSign = sMax < 0 ? -1 : 1;
+  genfit::M1x3 SA;
+  genfit::M1x7 state7 = stateOrig;
+  genfit::M1x7 oldState7;
+
+  double s = 0.;
+  for(unsigned int it = 0; it < maxIt; ++it)
+  {
+    double pos[3] = {state7[0], state7[1], state7[2]};
+    double dir[3] = {stepSign*state7[3], stepSign*state7[4], stepSign*state7[5]};
+
+    double slDist = distanceToBoundary(pos, dir, fabs(sMax) - s);
+    if(slDist < delta) return stepSign*(s + slDist);
+    if(s + slDist >= fabs(sMax))
+    {
+      //check whether the curved track stays inside the current region until sMax
+      oldState7 = state7;
+      rep->RKPropagate(state7, nullptr, SA, stepSign*slDist, varField);
+      double posEnd[3] = {state7[0], state7[1], state7[2]};
+      if(sameVolume(posEnd, pos)) return sMax;
+      state7 = oldState7;
+    }
+
+    double step = slDist;
+    while(true)
+    {
+      oldState7 = state7;
+      rep->RKPropagate(state7, nullptr, SA, stepSign*step, varField);
+
+      double dev2 = 0.;
+      for(int j = 0; j < 3; ++j)
+      {
+        double d = state7[j] - (pos[j] + step*dir[j]);
+        dev2 += d*d;
+      }
+      if(dev2 < epsilon*epsilon || step < delta) break;
+
+      state7 = oldState7;
+      step *= 0.5;
+    }
+    s += step;
+  }
+
+  throw genfit::Exception("GFLayeredMaterial::findNextBoundary: maximum number of iterations reached", __LINE__, __FILE__);
+  return stepSign*s;
+}
+
+bool GFLayeredMaterial::sameAsTGeo(double x, double y, double z)
+{
+  TGeoNode* node = _geoManager->FindNode(x, y, z);
+  if(node == nullptr) return true;
+  TGeoMaterial* mat = node->GetVolume()->GetMaterial();
+
+  initTrack(x, y, z, 0., 0., 1.);
+  double density, Z, A, radLen, mEE;
+  getMaterialParameters(density, Z, A, radLen, mEE);
+
+  return !(differs(density, mat->GetDensity()) || differs(Z, mat->GetZ()) ||
+           differs(radLen, mat->GetRadLen()) || differs(mEE, genfit::MeanExcEnergy_get(mat)));
+}
+
+double GFLayeredMaterial::validate(unsigned int nTracks, unsigned int nPointsPerTrack, double zmin, double zmax, unsigned int nPointsPerRegion)
+{
+  if(_geoManager == nullptr) return 1.;
+
+  //straight tracks from the target area
+  unsigned int nTrackPoints = 0;
+  unsigned int nTrackDiff = 0;
+  for(unsigned int i = 0; i < nTracks; ++i)
+  {
+    double x0 = gRandom->Uniform(-5., 5.);
+    double y0 = gRandom->Uniform(-5., 5.);
+    double tx = gRandom->Uniform(-0.15, 0.15);
+    double ty = gRandom->Uniform(-0.15, 0.15);
+    for(unsigned int j = 0; j < nPointsPerTrack; ++j)
+    {
+      double z = zmin + (zmax - zmin)*gRandom->Rndm();
+      ++nTrackPoints;
+      if(!sameAsTGeo(x0 + tx*(z - zmin), y0 + ty*(z - zmin), z)) ++nTrackDiff;
+    }
+  }
+
+  //uniform points in the bounding boxes of the non-box or rotated volumes, where the approximation is made
+  unsigned int nApprox = 0;
+  unsigned int nRegionPoints = 0;
+  unsigned int nRegionDiff = 0;
+  for(auto it = _regions.begin(); it != _regions.end(); ++it)
+  {
+    if(!it->approx) continue;
+    ++nApprox;
+    for(unsigned int j = 0; j < nPointsPerRegion; ++j)
+    {
+      double x = gRandom->Uniform(it->xmin, it->xmax);
+      double y = gRandom->Uniform(it->ymin, it->ymax);
+      double z = gRandom->Uniform(it->zmin, it->zmax);
+      ++nRegionPoints;
+      if(!sameAsTGeo(x, y, z)) ++nRegionDiff;
+    }
+  }
+  _currentRegion = -1;
+  _currentMatID = -1;
+
+  unsigned int nPoints = nTrackPoints + nRegionPoints;
+  unsigned int nDiff = nTrackDiff + nRegionDiff;
+  double fraction = nPoints == 0 ? 0. : double(nDiff)/nPoints;
+  std::cout << "GFLayeredMaterial::validate: " << nTrackDiff << " out of " << nTrackPoints
+            << " points on tracks and " << nRegionDiff << " out of " << nRegionPoints << " points in "
+            << nApprox << " approximated volumes differ from TGeo (" << 100.*fraction << "%)" << std::endl;
+  return fraction;
+}
+
+void GFLayeredMaterial::print() const
+{
+  unsigned int nApprox = 0;
+  for(auto it = _regions.begin(); it != _regions.end(); ++it) if(it->approx) ++nApprox;
+
+  std::cout << "GFLayeredMaterial: " << _regions.size() << " regions (" << nApprox << " navigated with TGeo), " << _materials.size()
+            << " materials, " << getNSlices() << " z slices" << std::endl;
+  for(unsigned int i = 0; i < getNSlices(); ++i)
+  {
+    std::cout << std::setw(10) << _zEdges[i] << " -- " << std::setw(10) << _zEdges[i+1]
+              << ": " << _sliceRegions[i].size() << " regions" << std::endl;
+  }
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef _GFLAYEREDMATERIAL_H
+#define _GFLAYEREDMATERIAL_H
+
+#include <map>
+#include <vector>
+
+#include <GenFit/AbsMaterialInterface.h>
+#include <GenFit/RKTools.h>
+
+class TGeoManager;
+class TGeoMaterial;
+class TGeoNode;
+class TGeoHMatrix;
+
+namespace SQGenFit
+{
+/*
+ * Material interface for GenFit built once from the TGeo geometry.
+ *
+ * Every volume is approximated by its axis-aligned bounding box in the global
+ * frame, and the boxes are sorted into z slices (target, FMAG, stations, KMAG,
+ * absorber are all z-ordered). Finding the slice of a point is a binary search,
+ * and only the few boxes of that slice are checked, deepest volume first, in
+ * place of the full TGeo navigation of TGeoMaterialInterface.
+ * Inside the bounding box of a non-box or rotated volume (e.g. the FMAG hole or
+ * the KMAG gap) the material and the boundaries are taken from TGeo instead.
+ * validate() compares the result with TGeo on a sample of straight tracks and
+ * inside the volumes where the bounding box is only an approximation.
+ */
+class GFLayeredMaterial: public genfit::AbsMaterialInterface
+{
+public:
+  struct MatParams
+  {
+    double density;
+    double Z;
+    double A;
+    double radLen;
+    double mEE;
+  };
+
+  struct Region
+  {
+    double xmin, xmax, ymin, ymax, zmin, zmax;
+    int depth;
+    int matID;
+    bool approx;  //!< true if the bounding box differs from the volume (non-box shape or rotated)
+    bool contains(double x, double y) const { return x >= xmin && x < xmax && y >= ymin && y < ymax; }
+  };
+
+  GFLayeredMaterial(TGeoManager* geoManager = nullptr);
+  virtual ~GFLayeredMaterial() {}
+
+  bool initTrack(double posX, double posY, double posZ, double dirX, double dirY, double dirZ);
+  void getMaterialParameters(double& density, double& Z, double& A, double& radiationLength, double& mEE);
+  void getMaterialParameters(genfit::MaterialProperties& parameters);
+  double findNextBoundary(const genfit::RKTrackRep* rep, const genfit::M1x7& state7, double sMax, bool varField = true);
+
+  //! Fraction of sampled points where density, Z, radLen or mEE differ from TGeo.
+  //! Points are sampled along straight tracks and inside the bounding box of each approximated volume.
+  double validate(unsigned int nTracks = 1000, unsigned int nPointsPerTrack = 200, double zmin = -500., double zmax = 2000., unsigned int nPointsPerRegion = 100);
+
+  unsigned int getNSlices() const { return _zEdges.size() < 2 ? 0 : _zEdges.size() - 1; }
+  unsigned int getNRegions() const { return _regions.size(); }
+  void print() const;
+
+private:
+  void build(TGeoManager* geoManager);
+  void addNode(TGeoNode* node, const TGeoHMatrix& parentMatrix, int depth);
+  int  addMaterial(TGeoMaterial* mat);
+  bool sameAsTGeo(double x, double y, double z);
+
+  int findSlice(double z) const;
+  int findRegion(double x, double y, double z) const;
+  int findMaterial(int region, double x, double y, double z);
+  bool sameVolume(const double* a, const double* b);
+  double distanceToBoundary(const double* pos, const double* dir, double maxDist) const;
+
+  std::vector<MatParams> _materials;
+  std::map<TGeoMaterial*, int> _matIDs;
+  std::vector<Region> _regions;
+
+  //! slice i spans [_zEdges[i], _zEdges[i+1]) and holds the regions _sliceRegions[i], sorted by depth
+  std::vector<double> _zEdges;
+  std::vector<std::vector<int> > _sliceRegions;
+
+  int _worldMatID;
+  TGeoManager* _geoManager;
+
+  double _pos[3];
+  double _dir[3];
+  int _currentRegion;
+  int _currentMatID;
+};
+}
+
+#endif
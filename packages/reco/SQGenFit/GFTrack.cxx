@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <numeric>
 
 #include <TVectorD.h>
 #include <TMatrixDSym.h>
@@ -90,6 +91,12 @@ GFTrack::GFTrack(SRecTrack& recTrack):  _track(nullptr), _trkrep(nullptr), _prop
 
   _fitstates.clear();
   int nHits = recTrack.getNHits();
+  if(recTrack.getNGFStates() < nHits)
+  {
+    //e.g. SRecTrack read from a version <= 11 file, whose GenFit info is not converted
+    std::cerr << __FILE__ << " " << __LINE__ << ": no GenFit state in SRecTrack, cannot be extrapolated." << std::endl;
+    return;
+  }
   for(int i = 0; i < nHits; ++i)
   {
     genfit::SharedPlanePtr detPlane(new genfit::DetPlane(recTrack.getGFPlaneO(i), recTrack.getGFPlaneU(i), recTrack.getGFPlaneV(i)));
@@ -283,6 +290,7 @@ bool GFTrack::setInitialStateForExtrap(const int startPtID)
   }
   else
   {
+    if(startPtID < 0 || startPtID >= (int)_fitstates.size()) return false;
     _propState.reset(new genfit::MeasuredStateOnPlane(_fitstates[startPtID]));
   }
 
@@ -332,6 +340,73 @@ double GFTrack::swimToVertex(double z, TVector3* pos, TVector3* mom, TMatrixDSym
   return chi2;
 }
 
+void GFTrack::swimToVertices(const std::vector<double>& z, std::vector<double>& chi2)
+{
+  chi2.assign(z.size(), -1.);
+  if(z.empty()) return;
+
+  //Visit the planes from downstream to upstream, so that each stop starts from the previous one
+  std::vector<unsigned int> order(z.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&z](unsigned int a, unsigned int b) { return z[a] > z[b]; });
+
+  TVector3 pU(1., 0., 0.);
+  TVector3 pV(0., 1., 0.);
+  
+  TVectorD beamCenter(2);
+  beamCenter[0] = X_BEAM; beamCenter[1] = Y_BEAM;
+  TMatrixDSym beamCov(2);
+  beamCov.Zero();
+  beamCov(0, 0) = SIGX_BEAM*SIGX_BEAM; beamCov(1, 1) = SIGY_BEAM*SIGY_BEAM;
+
+  TVectorD hitcoord(2);    //beam line at (0, 0), as in extrapolateToPlane
+  TMatrixDSym tempcov(2);
+  tempcov.UnitMatrix();
+
+  if(!setInitialStateForExtrap()) return;
+  genfit::AbsTrackRep* rep = _track->getCardinalRep();
+  genfit::MeasuredStateOnPlane state(*_propState);
+
+  //Total length from the first measurement, same limit as swimToVertex
+  double len = 0.;
+  unsigned int iStop = 0;
+  for(; iStop < order.size(); ++iStop)
+  {
+    double zStop = z[order[iStop]];
+    try
+    {
+      genfit::SharedPlanePtr destPlane(new genfit::DetPlane(TVector3(0., 0., zStop), pU, pV));
+      len += rep->extrapolateToPlane(state, destPlane);
+      if(fabs(len) > 6000.) throw len;
+
+      //the beam constraint is applied on a copy, the swim continues from the unconstrained state
+      _propState.reset(new genfit::MeasuredStateOnPlane(state));
+
+      genfit::PlanarMeasurement* pMeas = new genfit::PlanarMeasurement(hitcoord, tempcov, 998, 998, nullptr);
+      pMeas->setPlane(destPlane);
+      _virtMeas.reset(pMeas);
+
+      chi2[order[iStop]] = updatePropState(beamCenter, beamCov);
+    }
+    catch(genfit::Exception& e)
+    {
+      std::cerr << __FILE__ << " " << __LINE__ << ": hypo test failed vertex @Z=" << zStop << ": " << e.what() << std::endl;
+      break;
+    }
+    catch(double l)
+    {
+      std::cerr << __FILE__ << " " << __LINE__ << ": hypo test failed vertex @Z=" << zStop << ": " << l << std::endl;
+      break;
+    }
+  }
+
+  //The stops behind a failed one cannot be reached by the single pass anymore, try them one by one
+  for(++iStop; iStop < order.size(); ++iStop)
+  {
+    chi2[order[iStop]] = swimToVertex(z[order[iStop]]);
+  }
+}
+
 void GFTrack::setTracklet(Tracklet& tracklet, double z_reference, bool wildseedcov)
 {
   _trkcand = &tracklet;
@@ -421,24 +496,20 @@ SRecTrack GFTrack::getSRecTrack()
   //Swim to various places and save info
   strack.swimToVertex(nullptr, nullptr, false);
 
-  //Hypothesis test should be implemented here
-  TVector3 pO(0., 0., Z_UPSTREAM);
-  TVector3 pU(1., 0., 0.);
-  TVector3 pV(0., 1., 0.);
-  TVectorD beamCenter(2);
-  beamCenter[0] = X_BEAM; beamCenter[1] = Y_BEAM; 
-  TMatrixDSym beamCov(2);
-  beamCov.Zero();
-  beamCov(0, 0) = SIGX_BEAM*SIGX_BEAM; beamCov(1, 1) = SIGY_BEAM*SIGY_BEAM;
-
-  //test Z_UPSTREAM
-  strack.setChisqUpstream(swimToVertex(Z_UPSTREAM));
+  //Hypothesis tests at Z_UPSTREAM, Z_TARGET, Z_DUMP and the vertex found above, in one GenFit swim
+  std::vector<double> zTests(4);
+  zTests[0] = Z_UPSTREAM;
+  zTests[1] = Z_TARGET;
+  zTests[2] = Z_DUMP;
+  zTests[3] = strack.getVertexPos().Z();
 
-  //test Z_TARGET
-  strack.setChisqTarget(swimToVertex(Z_TARGET));
+  std::vector<double> chi2Tests;
+  swimToVertices(zTests, chi2Tests);
 
-  //test Z_DUMP
-  strack.setChisqDump(swimToVertex(Z_DUMP));
+  strack.setChisqUpstream(chi2Tests[0]);
+  strack.setChisqTarget(chi2Tests[1]);
+  strack.setChisqDump(chi2Tests[2]);
+  strack.setChisqVertex(chi2Tests[3]);
 
   /*
   //Find POCA to beamline -- it seems to be funky and mostly found some place way upstream or downstream
@@ -460,9 +531,6 @@ SRecTrack GFTrack::getSRecTrack()
   }
   */
 
-  //test Z_VERTEX
-  strack.setChisqVertex(swimToVertex(strack.getVertexPos().Z()));
-
   strack.setKalmanStatus(1);
   return strack;
 }
@@ -47,6 +47,10 @@ public:
 
   double swimToVertex(double z, TVector3* pos = nullptr, TVector3* mom = nullptr, TMatrixDSym* cov = nullptr);
 
+  //Same beam-spot hypothesis test as swimToVertex for several z at once, the planes are visited in one 
+  // upstream pass from the first measurement, chi2[i] is -1 if the test at z[i] failed
+  void swimToVertices(const std::vector<double>& z, std::vector<double>& chi2);
+
   void checkConsistency()  { _track->checkConsistency(); }
 
   void postFitUpdate(bool updateMeasurements = true);
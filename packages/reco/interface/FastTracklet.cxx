@@ -17,6 +17,7 @@ Created: 05-28-2013
 #include <TMatrixD.h>
 
 #include "FastTracklet.h"
+#include "TrackletFunc.h"
 #include "TriggerRoad.h"
 
 ClassImp(SignedHit)
@@ -24,44 +25,32 @@ ClassImp(PropSegment)
 ClassImp(Tracklet)
 ClassImp(TrackletVector)
 
-namespace 
+namespace TrackletGlobals
 {
     //static flag to indicate the initialized has been done
     static bool inited = false;
 
-	//static pointer to geomtry service
-	static GeomSvc* p_geomSvc = nullptr;
-
-	//static flag of kmag on/off
-	static bool KMAG_ON;
-
-    //corase geometry
-    static bool COARSE_MODE;
-
-	//static flag of kmag strength
-	static double FMAGSTR;
-	static double KMAGSTR;
-
-	static double PT_KICK_FMAG;
-	static double PT_KICK_KMAG;
-
-    //Track quality cuts
-    static double TX_MAX;
-    static double TY_MAX;
-    static double X0_MAX;
-    static double Y0_MAX;
-    static double INVP_MAX;
-    static double INVP_MIN;
-    static double PROB_LOOSE;
-    static double PROB_TIGHT;
-
-    //Geometric positions
-    static double Z_KMAG_BEND;
-    static double Z_ABSORBER;
-    static double Z_FMAG_BEND;
-    static double Z_KFMAG_BEND;
-    static double ELOSS_KFMAG;
-    static double ELOSS_ABSORBER;
+    GeomSvc* p_geomSvc = nullptr;
+    bool KMAG_ON;
+    bool COARSE_MODE;
+    double FMAGSTR;
+    double KMAGSTR;
+    double PT_KICK_FMAG;
+    double PT_KICK_KMAG;
+    double TX_MAX;
+    double TY_MAX;
+    double X0_MAX;
+    double Y0_MAX;
+    double INVP_MAX;
+    double INVP_MIN;
+    double PROB_LOOSE;
+    double PROB_TIGHT;
+    double Z_KMAG_BEND;
+    double Z_ABSORBER;
+    double Z_FMAG_BEND;
+    double Z_KFMAG_BEND;
+    double ELOSS_KFMAG;
+    double ELOSS_ABSORBER;
 
     //initialize global variables
     void initGlobalVariables()
@@ -99,6 +88,8 @@ namespace
     }
 }
 
+using namespace TrackletGlobals;
+
 //Signed hit definition
 SignedHit::SignedHit() : sign(0)
 {
@@ -505,81 +496,17 @@ Tracklet::Tracklet() : stationID(-1), nXHits(0), nUHits(0), nVHits(0), chisq(999
 
 int Tracklet::isValid() const
 {
-    if(stationID < 1 || stationID > nStations) return 0;
-    if(fabs(tx) > TX_MAX || fabs(x0) > X0_MAX) return 0;
-    if(fabs(ty) > TY_MAX || fabs(y0) > Y0_MAX) return 0;
-    if(err_tx < 0 || err_ty < 0 || err_x0 < 0 || err_y0 < 0) return 0;
-
-    double prob = getProb();
-    if(stationID != nStations && prob < PROB_LOOSE) return 0;
-    
-    //Tracklets in each station
-    int nHits = nXHits + nUHits + nVHits;
-    if(stationID < nStations-1)
-    {
-        if(nXHits < 1 || nUHits < 1 || nVHits < 1) return 0;
-        if(nHits < 4) return 0;
-        if(chisq > 40.) return 0;
-    }
-    else
-    {
-        //Number of hits cuts, second index is X, U, V, first index is station-1, 2, 3
-        int nRealHits[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-        nXHits = 0; nUHits = 0; nVHits = 0;
+    return TrackletFunc::isValid(*this, [this](int nRealHits[3][3]) {
         for(std::list<SignedHit>::const_iterator iter = hits.begin(); iter != hits.end(); ++iter)
         {
-            if(iter->hit.index < 0) continue;
-
-            int idx1 = iter->hit.detectorID <= 12 ? 0 : (iter->hit.detectorID <= 18 ? 1 : 2);
-            int idx2 = p_geomSvc->getPlaneType(iter->hit.detectorID) - 1;
-
-            ++nRealHits[idx1][idx2];
-            if(idx2 == 0)
-                ++nXHits;
-            else if(idx2 == 1)
-                ++nUHits;
-            else
-                ++nVHits;
+            if(iter->hit.index >= 0) TrackletFunc::countRealHit(*this, iter->hit.detectorID, nRealHits);
         }
-
-        //Number of hits cut after removing bad hits
-        for(int i = 1; i < 3; ++i)
-        {
-            if(nRealHits[i][0] < 1 || nRealHits[i][1] < 1 || nRealHits[i][2] < 1) return 0;
-            if(nRealHits[i][0] + nRealHits[i][1] + nRealHits[i][2] < 4) return 0;
-        }
-
-        //for global tracks only -- TODO: may need to set a new station-1 cut
-        if(stationID == nStations)
-        {
-            if(nRealHits[0][0] < 1 || nRealHits[0][1] < 1 || nRealHits[0][2] < 1) return 0;
-            if(nRealHits[0][0] + nRealHits[0][1] + nRealHits[0][2] < 4) return 0;
-
-            if(prob < PROB_TIGHT) return 0;
-            if(KMAG_ON)
-            {
-                if(invP < INVP_MIN || invP > INVP_MAX) return 0;
-            }
-        }
-    }
-
-    return 1;
+    });
 }
 
 double Tracklet::getProb() const
 {
-    int ndf;
-    if(stationID == nStations && KMAG_ON)
-    {
-        ndf = getNHits() - 5;
-    }
-    else
-    {
-        ndf = getNHits() - 4;
-    }
-
-    return TMath::Prob(chisq, ndf);
-    //return -chisq/ndf;
+    return TrackletFunc::getProb(*this);
 }
 
 double Tracklet::getMomProb() const
@@ -597,37 +524,12 @@ TVector3 Tracklet::getExpMomentum(double z) const
 
 double Tracklet::getExpPositionX(double z) const
 {
-    if(KMAG_ON && stationID >= nStations-1 && z < Z_KMAG_BEND - 1.)
-    {
-        double tx_st1 = tx + PT_KICK_KMAG*invP*getCharge();
-        double x0_st1 = tx*Z_KMAG_BEND + x0 - tx_st1*Z_KMAG_BEND;
-
-        return x0_st1 + tx_st1*z;
-    }
-    else
-    {
-        return x0 + tx*z;
-    }
+    return TrackletFunc::getExpPositionX(*this, z);
 }
 
 double Tracklet::getExpPosErrorX(double z) const
 {
-    double err_x;
-    if(KMAG_ON && stationID >= nStations-1 && z < Z_KMAG_BEND - 1.)
-    {
-        double err_kick = fabs(err_invP*PT_KICK_KMAG);
-        double err_tx_st1 = err_tx + err_kick;
-        double err_x0_st1 = err_x0 + err_kick*Z_KMAG_BEND;
-
-        err_x = err_x0_st1 + fabs(err_tx_st1*z);
-    }
-    else
-    {
-        err_x = fabs(err_tx*z) + err_x0;
-    }
-
-    if(z > Z_ABSORBER) err_x += 1.;
-    return err_x;
+    return TrackletFunc::getExpPosErrorX(*this, z);
 }
 
 double Tracklet::getExpPositionY(double z) const
@@ -637,10 +539,7 @@ double Tracklet::getExpPositionY(double z) const
 
 double Tracklet::getExpPosErrorY(double z) const
 {
-    double err_y = fabs(err_ty*z) + err_y0;
-    if(z > Z_ABSORBER) err_y += 1.;
-
-    return err_y;
+    return TrackletFunc::getExpPosErrorY(*this, z);
 }
 
 double Tracklet::getExpPositionW(int detectorID) const
@@ -661,15 +560,7 @@ int Tracklet::getExpElementID(int detectorID) const
 
 bool Tracklet::operator<(const Tracklet& elem) const
 {
-    //return nXHits + nUHits + nVHits - 0.4*chisq > elem.nXHits + elem.nUHits + elem.nVHits - 0.4*elem.chisq;
-    if(getNHits() == elem.getNHits())
-    {
-        return chisq < elem.chisq;
-    }
-    else
-    {
-        return getProb() > elem.getProb();
-    }
+    return TrackletFunc::lessThan(*this, elem);
 }
 
 bool Tracklet::similarity(const Tracklet& elem) const
@@ -696,74 +587,27 @@ bool Tracklet::similarity(const Tracklet& elem) const
         }
     }
 
-    if(nCommonHits/double(elem.getNHits()) > 0.33333) return true;
-    return false;
+    return TrackletFunc::isSimilar(elem, nCommonHits);
 }
 
 double Tracklet::getMomentum() const
 {
-    //Ref. SEAQUEST-doc-453-v3 by Don. Geesaman
-    //if(KMAG_ON == 0) return 1E8;
-
-    double p = 50.;
-    double charge = getCharge();
-
-    double c1 = Z_FMAG_BEND*PT_KICK_FMAG*charge;
-    double c2 = Z_KMAG_BEND*PT_KICK_KMAG*charge;
-    double c3 = -x0;
-    double c4 = ELOSS_KFMAG/2.;
-    double c5 = ELOSS_KFMAG;
-
-    double b = c1/c3 + c2/c3 - c4 - c5;
-    double c = c4*c5 - c1*c5/c3 - c2*c4/c3;
-
-    double disc = b*b - 4*c;
-    if(disc > 0.)
-    {
-        p = (-b + sqrt(disc))/2. - ELOSS_KFMAG;
-    }
-
-    if(p < 10. || p > 120. || disc < 0)
-    {
-        double k = fabs(getExpPositionX(Z_KFMAG_BEND)/Z_KFMAG_BEND - tx);
-        p = 1./(0.00832161 + 0.184186*k - 0.104132*k*k) + ELOSS_ABSORBER;
-    }
-
-    return p;
+    return TrackletFunc::getMomentum(*this);
 }
 
 int Tracklet::getCharge() const
 {
-	return x0*KMAGSTR > tx ? 1 : -1;
+    return TrackletFunc::getCharge(*this);
 }
 
 void Tracklet::getXZInfoInSt1(double& tx_st1, double& x0_st1) const
 {
-    if(KMAG_ON)
-    {
-        tx_st1 = tx + PT_KICK_KMAG*invP*getCharge();
-        x0_st1 = tx*Z_KMAG_BEND + x0 - tx_st1*Z_KMAG_BEND;
-    }
-    else
-    {
-        tx_st1 = tx;
-        x0_st1 = x0;
-    }
+    TrackletFunc::getXZInfoInSt1(*this, tx_st1, x0_st1);
 }
 
 void Tracklet::getXZErrorInSt1(double& err_tx_st1, double& err_x0_st1) const
 {
-    if(KMAG_ON)
-    {
-        double err_kick = fabs(err_invP*PT_KICK_KMAG);
-        err_tx_st1 = err_tx + err_kick;
-        err_x0_st1 = err_x0 + err_kick*Z_KMAG_BEND;
-    }
-    else
-    {
-        err_tx_st1 = err_tx;
-        err_x0_st1 = err_x0;
-    }
+    TrackletFunc::getXZErrorInSt1(*this, err_tx_st1, err_x0_st1);
 }
 
 Tracklet Tracklet::operator+(const Tracklet& elem) const
@@ -785,18 +629,7 @@ Tracklet Tracklet::operator+(const Tracklet& elem) const
         tracklet.hits.insert(tracklet.hits.begin(), elem.hits.begin(), elem.hits.end());
     }
 
-    tracklet.err_tx = 1./sqrt(1./err_tx/err_tx + 1./elem.err_tx/elem.err_tx);
-    tracklet.err_ty = 1./sqrt(1./err_ty/err_ty + 1./elem.err_ty/elem.err_ty);
-    tracklet.err_x0 = 1./sqrt(1./err_x0/err_x0 + 1./elem.err_x0/elem.err_x0);
-    tracklet.err_y0 = 1./sqrt(1./err_y0/err_y0 + 1./elem.err_y0/elem.err_y0);
-
-    tracklet.tx = (tx/err_tx/err_tx + elem.tx/elem.err_tx/elem.err_tx)*tracklet.err_tx*tracklet.err_tx;
-    tracklet.ty = (ty/err_ty/err_ty + elem.ty/elem.err_ty/elem.err_ty)*tracklet.err_ty*tracklet.err_ty;
-    tracklet.x0 = (x0/err_x0/err_x0 + elem.x0/elem.err_x0/elem.err_x0)*tracklet.err_x0*tracklet.err_x0;
-    tracklet.y0 = (y0/err_y0/err_y0 + elem.y0/elem.err_y0/elem.err_y0)*tracklet.err_y0*tracklet.err_y0;
-
-    tracklet.invP = 1./tracklet.getMomentum();
-    tracklet.err_invP = 0.25*tracklet.invP;
+    TrackletFunc::setBackPartialParameters(*this, elem, tracklet);
 
     tracklet.calcChisq();
     return tracklet;
@@ -821,34 +654,7 @@ Tracklet Tracklet::operator*(const Tracklet& elem) const
         tracklet.hits.insert(tracklet.hits.begin(), elem.hits.begin(), elem.hits.end());
     }
 
-    if(elem.stationID == nStations - 1)
-    {
-        tracklet.tx = elem.tx;
-        tracklet.ty = elem.ty;
-        tracklet.x0 = elem.x0;
-        tracklet.y0 = elem.y0;
-        tracklet.invP = 1./elem.getMomentum();
-
-        tracklet.err_tx = elem.err_tx;
-        tracklet.err_ty = elem.err_ty;
-        tracklet.err_x0 = elem.err_x0;
-        tracklet.err_y0 = elem.err_y0;
-        tracklet.err_invP = 0.25*tracklet.invP;
-    }
-    else
-    {
-        tracklet.tx = tx;
-        tracklet.ty = ty;
-        tracklet.x0 = x0;
-        tracklet.y0 = y0;
-        tracklet.invP = 1./getMomentum();
-
-        tracklet.err_tx = err_tx;
-        tracklet.err_ty = err_ty;
-        tracklet.err_x0 = err_x0;
-        tracklet.err_y0 = err_y0;
-        tracklet.err_invP = 0.25*tracklet.invP;
-    }
+    TrackletFunc::setParametersFrom(elem.stationID == nStations - 1 ? elem : *this, tracklet);
 
     tracklet.calcChisq();
     return tracklet;
@@ -858,18 +664,7 @@ Tracklet Tracklet::merge(Tracklet& elem)
 {
     Tracklet tracklet;
     tracklet.stationID = stationID;
-
-    tracklet.tx = tx;
-    tracklet.ty = ty;
-    tracklet.x0 = x0;
-    tracklet.y0 = y0;
-    tracklet.invP = 1./getMomentum();
-
-    tracklet.err_tx = err_tx;
-    tracklet.err_ty = err_ty;
-    tracklet.err_x0 = err_x0;
-    tracklet.err_y0 = err_y0;
-    tracklet.err_invP = 0.25*tracklet.invP;
+    TrackletFunc::setParametersFrom(*this, tracklet);
 
     tracklet.chisq_vtx = chisq_vtx < 999 ? chisq_vtx : elem.chisq_vtx;
 
@@ -918,42 +713,16 @@ double Tracklet::calcChisq()
     chisq = 0.;
 
     double tx_st1, x0_st1;
-    if(stationID == nStations && KMAG_ON)
-    {
-        getXZInfoInSt1(tx_st1, x0_st1);
-    }
+    TrackletFunc::getChisqParameters(*this, tx_st1, x0_st1);
 
     for(std::list<SignedHit>::const_iterator iter = hits.begin(); iter != hits.end(); ++iter)
     {
         if(iter->hit.index < 0) continue;
 
-        int detectorID = iter->hit.detectorID;
-        int index = detectorID - 1;
-
-        double sigma;
-        if(iter->sign == 0 || COARSE_MODE) 
-            sigma = p_geomSvc->getPlaneSpacing(detectorID)/sqrt(12.);
-            //sigma = fabs(iter->hit.driftDistance)/sqrt(12.);
-        else
-            sigma = p_geomSvc->getPlaneResolution(detectorID);
-
-        //double p = iter->hit.pos + iter->sign*fabs(iter->hit.driftDistance);
-        if(KMAG_ON && stationID == nStations && detectorID <= 12)
-        {
-            //residual[index] = p - p_geomSvc->getInterception(detectorID, tx_st1, ty, x0_st1, y0);
-            residual[index] = iter->sign*fabs(iter->hit.driftDistance) - p_geomSvc->getDCA(detectorID, iter->hit.elementID, tx_st1, ty, x0_st1, y0);
-        }
-        else
-        {
-            //residual[index] = p - p_geomSvc->getInterception(detectorID, tx, ty, x0, y0);
-            residual[index] = iter->sign*fabs(iter->hit.driftDistance) - p_geomSvc->getDCA(detectorID, iter->hit.elementID, tx, ty, x0, y0);
-        }
-
-        chisq += (residual[index]*residual[index]/sigma/sigma);
-        //std::cout << iter->hit.detectorID << "  " << iter->hit.elementID << "  " << iter->sign << "  " << iter->hit.pos << "  " << iter->hit.driftDistance << "  " << residual[index] << "  " <<  sigma << "  " << chisq << std::endl;
+        int index = iter->hit.detectorID - 1;
+        chisq += TrackletFunc::hitChisq(*this, tx_st1, x0_st1, iter->hit.detectorID, iter->hit.elementID, iter->hit.driftDistance, iter->sign, residual[index]);
     }
 
-    //std::cout << chisq << std::endl;
     return chisq;
 }
 
@@ -69,6 +69,9 @@ namespace
     static double STEP_SHIELDING;
     static double STEP_FMAG;
 
+    //Storage of the node covariances: 0 - half float, 1 - float, 2 - double
+    static int SRECTRACK_DETAIL;
+
     //initialize global variables
     void initGlobalVariables()
     {
@@ -110,35 +113,66 @@ namespace
             STEP_TARGET = fabs(Z_UPSTREAM)/NSTEPS_TARGET;
             STEP_SHIELDING = 0.;
             STEP_FMAG = FMAG_LENGTH/NSTEPS_FMAG/2.;
+
+            SRECTRACK_DETAIL = rc->get_IntFlag("SRECTRACK_DETAIL");
         }
     }
 }
 
 SRecTrack::SRecTrack()
 {
+    initGlobalVariables();
+
     fChisq = -99.;
 
     fHitIndex.clear();
-    fState.clear();
-    fCovar.clear();
+    fNodeState.clear();
+    fNodeCovar.clear();
+    fNodeSigma.clear();
+    fNodeCovarFull.clear();
     fZ.clear();
     fChisqAtNode.clear();
+    fNodeCovar.set_half(SRECTRACK_DETAIL == 0);
 
-    for(Int_t i = 0; i < 3; ++i) fGFDetPlaneVec[i].clear();
-    fGFAuxInfo.clear();
-    fGFStateVec.clear();
+    fGFPlane.clear();
+    fGFState.clear();
     fGFCov.clear();
+    fGFSigma.clear();
+    fGFCovFull.clear();
+    fGFAuxSize = 0;
+    fGFAuxInfo.clear();
+    fGFCov.set_half(SRECTRACK_DETAIL == 0);
+
+    for(Int_t i = 0; i < 3; ++i)
+    {
+        fDumpFacePos[i] = 0.;
+        fDumpPos[i] = 0.;
+        fTargetPos[i] = 0.;
+        fXVertexPos[i] = 0.;
+        fYVertexPos[i] = 0.;
+        fDumpFaceMom[i] = 0.;
+        fDumpMom[i] = 0.;
+        fTargetMom[i] = 0.;
+        fXVertexMom[i] = 0.;
+        fYVertexMom[i] = 0.;
+        fVertexMom[i] = 0.;
+        fVertexPos[i] = 999.;
+    }
 
     fChisqVertex = -99.;
-    fVertexPos.SetXYZ(999., 999., 999.);
-    fStateVertex.ResizeTo(5, 1);
-    fCovarVertex.ResizeTo(5, 5);
+    for(Int_t i = 0; i < 5; ++i) fStateVertex[i] = 0.;
+    for(Int_t i = 0; i < 15; ++i) fCovarVertex[i] = 0.;
+
+    fKalmanStatus = 0;
+    fTriggerID = 0;
+    fNPropHitsX = 0;
+    fNPropHitsY = 0;
+    fPropSlopeX = 0.;
+    fPropSlopeY = 0.;
 
     fChisqTarget = -99.;
     fChisqDump = -99.;
     fChisqUpstream = -99.;
-
-    initGlobalVariables();
 }
 
 bool SRecTrack::operator<(const SRecTrack& elem) const
@@ -191,8 +225,8 @@ void SRecTrack::setZVertex(Double_t z, bool update)
     _node_vertex.getProjector() = proj;
 
     TrkPar _trkpar_curr;
-    _trkpar_curr._state_kf = fState[0];
-    _trkpar_curr._covar_kf = fCovar[0];
+    _trkpar_curr._state_kf = getStateVector(0);
+    _trkpar_curr._covar_kf = getCovariance(0);
     _trkpar_curr._z = fZ[0];
 
     KalmanFilter* kmfit = KalmanFilter::instance();
@@ -203,11 +237,11 @@ void SRecTrack::setZVertex(Double_t z, bool update)
     fChisqVertex = _node_vertex.getChisq();
     if(!update) return;
 
-    fVertexPos.SetXYZ(_node_vertex.getFiltered().get_x(), _node_vertex.getFiltered().get_y(), z);
-    fVertexMom = _node_vertex.getFiltered().get_mom_vec();
+    setVec(fVertexPos, TVector3(_node_vertex.getFiltered().get_x(), _node_vertex.getFiltered().get_y(), z));
+    setVec(fVertexMom, _node_vertex.getFiltered().get_mom_vec());
 
-    fStateVertex = _node_vertex.getFiltered()._state_kf;
-    fCovarVertex = _node_vertex.getFiltered()._covar_kf;
+    for(Int_t i = 0; i < 5; ++i) fStateVertex[i] = _node_vertex.getFiltered()._state_kf[i][0];
+    packCovariance(_node_vertex.getFiltered()._covar_kf, fCovarVertex);
 }
 
 void SRecTrack::updateVtxHypothesis()
@@ -226,22 +260,25 @@ void SRecTrack::updateVtxHypothesis()
 
 void SRecTrack::setVertexFast(TVector3 mom, TVector3 pos)
 {
-    fVertexPos = pos;
-    fVertexMom = mom;
+    setVec(fVertexPos, pos);
+    setVec(fVertexMom, mom);
 
-    fStateVertex[0][0] = getCharge()/mom.Mag();
-    fStateVertex[1][0] = mom[0]/mom[2];
-    fStateVertex[2][0] = mom[1]/mom[2];
-    fStateVertex[3][0] = pos[0];
-    fStateVertex[4][0] = pos[1];
+    fStateVertex[0] = getCharge()/mom.Mag();
+    fStateVertex[1] = mom[0]/mom[2];
+    fStateVertex[2] = mom[1]/mom[2];
+    fStateVertex[3] = pos[0];
+    fStateVertex[4] = pos[1];
 
-    fCovarVertex.UnitMatrix();
+    for(Int_t i = 0; i < 5; ++i)
+    {
+        for(Int_t j = i; j < 5; ++j) fCovarVertex[covIndex(i, j)] = i == j ? 1. : 0.;
+    }
 }
 
 bool SRecTrack::isVertexValid() const
 {
     if(fChisqVertex > 50.) return false;
-    if(fVertexPos.Z() < Z_UPSTREAM || fVertexPos.Z() > Z_DOWNSTREAM) return false;
+    if(fVertexPos[2] < Z_UPSTREAM || fVertexPos[2] > Z_DOWNSTREAM) return false;
 
     return true;
 }
@@ -271,15 +308,13 @@ void SRecTrack::getExpPositionFast(Double_t z, Double_t& x, Double_t& y, Int_t i
         iNode = getNearestNode(z);
     }
 
-    TrkPar _trkpar;
-    _trkpar._state_kf = fState[iNode];
-    _trkpar._covar_kf = fCovar[iNode];
+    const Float_t* state = &fNodeState[5*iNode];
 
     Double_t z_ref = fZ[iNode];
-    Double_t x_ref = _trkpar.get_x();
-    Double_t y_ref = _trkpar.get_y();
-    Double_t axz = _trkpar.get_dxdz();
-    Double_t ayz = _trkpar.get_dydz();
+    Double_t x_ref = state[3];
+    Double_t y_ref = state[4];
+    Double_t axz = state[1];
+    Double_t ayz = state[2];
 
     x = x_ref + axz*(z - z_ref);
     y = y_ref + ayz*(z - z_ref);
@@ -293,10 +328,10 @@ void SRecTrack::getExpPosErrorFast(Double_t z, Double_t& dx, Double_t& dy, Int_t
     }
 
     Double_t z_ref = fZ[iNode];
-    Double_t dx_ref = sqrt((fCovar[iNode])[3][3]);
-    Double_t dy_ref = sqrt((fCovar[iNode])[4][4]);
-    Double_t daxz = sqrt((fCovar[iNode])[1][1]);
-    Double_t dayz = sqrt((fCovar[iNode])[2][2]);
+    Double_t dx_ref = sqrt(getNodeCovariance(iNode, 3, 3));
+    Double_t dy_ref = sqrt(getNodeCovariance(iNode, 4, 4));
+    Double_t daxz = sqrt(getNodeCovariance(iNode, 1, 1));
+    Double_t dayz = sqrt(getNodeCovariance(iNode, 2, 2));
 
     dx = 2.*(dx_ref + fabs(daxz*(z - z_ref)));
     dy = 2.*(dy_ref + fabs(dayz*(z - z_ref)));
@@ -315,8 +350,7 @@ Double_t SRecTrack::getExpMomentumFast(Double_t z, Double_t& px, Double_t& py, D
         iNode = getNearestNode(z);
     }
 
-    return getMomentum(fState[iNode], px, py, pz);
-
+    return getNodeMomentum(iNode, px, py, pz);
 }
 
 Double_t SRecTrack::getMomentum(const TMatrixD& state, Double_t& px, Double_t& py, Double_t& pz) const
@@ -337,6 +371,137 @@ Double_t SRecTrack::getPosition(const TMatrixD& state, Double_t& x, Double_t& y)
     return sqrt(x*x + y*y);
 }
 
+Double_t SRecTrack::getMomentum(const Float_t* state, Double_t& px, Double_t& py, Double_t& pz) const
+{
+    Double_t p = 1./fabs(state[0]);
+    pz = p/sqrt(1. + state[1]*state[1] + state[2]*state[2]);
+    px = pz*state[1];
+    py = pz*state[2];
+
+    return p;
+}
+
+Double_t SRecTrack::getNodeMomentum(Int_t i, Double_t& px, Double_t& py, Double_t& pz) const
+{
+    return getMomentum(&fNodeState[5*i], px, py, pz);
+}
+
+Double_t SRecTrack::getNodePosition(Int_t i, Double_t& x, Double_t& y) const
+{
+    x = fNodeState[5*i+3];
+    y = fNodeState[5*i+4];
+
+    return sqrt(x*x + y*y);
+}
+
+Double_t SRecTrack::getNodeCovariance(Int_t iNode, Int_t i, Int_t j) const
+{
+    if(!fNodeCovarFull.empty()) return fNodeCovarFull[15*iNode + covIndex(i, j)];
+    return getPackedCovariance(fNodeCovar, fNodeSigma, iNode, i, j);
+}
+
+TMatrixD SRecTrack::getStateVector(Int_t i) const
+{
+    TMatrixD state(5, 1);
+    for(Int_t j = 0; j < 5; ++j) state[j][0] = fNodeState[5*i+j];
+
+    return state;
+}
+
+TMatrixD SRecTrack::getCovariance(Int_t i) const
+{
+    TMatrixD cov(5, 5);
+    for(Int_t j = 0; j < 5; ++j)
+    {
+        for(Int_t k = j; k < 5; ++k)
+        {
+            cov[j][k] = getNodeCovariance(i, j, k);
+            cov[k][j] = cov[j][k];
+        }
+    }
+
+    return cov;
+}
+
+void SRecTrack::insertCovariance(const TMatrixD& covar)
+{
+    if(SRECTRACK_DETAIL >= 2)
+        packCovariance(covar, fNodeCovarFull);
+    else
+        packCovariance(covar, fNodeCovar, fNodeSigma);
+}
+
+void SRecTrack::packState(const TMatrixD& state, std::vector<Float_t>& packed)
+{
+    for(Int_t i = 0; i < 5; ++i) packed.push_back(state[i][0]);
+}
+
+void SRecTrack::packCovariance(const TMatrixD& cov, SQFloatColumn& packed, std::vector<Float_t>& sigma)
+{
+    packCovariance(cov.GetMatrixArray(), packed, sigma);
+}
+
+void SRecTrack::packCovariance(const Double_t* cov, SQFloatColumn& packed, std::vector<Float_t>& sigma)
+{
+    if(!packed.is_half())
+    {
+        for(Int_t i = 0; i < 5; ++i)
+        {
+            for(Int_t j = i; j < 5; ++j) packed.push_back(cov[5*i + j]);
+        }
+        return;
+    }
+
+    //Half floats cannot hold elements like cov(q/p, q/p) ~ 1e-7, so only the correlations are stored as half
+    //atanh(rho) keeps the precision of the correlations close to +-1
+    const Double_t rhoMax = 1. - 1.e-6;
+    Double_t sig[5];
+    for(Int_t i = 0; i < 5; ++i)
+    {
+        sig[i] = sqrt(fabs(cov[6*i]));
+        sigma.push_back(sig[i]);
+    }
+    for(Int_t i = 0; i < 5; ++i)
+    {
+        for(Int_t j = i+1; j < 5; ++j)
+        {
+            Double_t rho = (sig[i] > 0. && sig[j] > 0.) ? cov[5*i + j]/sig[i]/sig[j] : 0.;
+            if(rho > rhoMax) rho = rhoMax;
+            if(rho < -rhoMax) rho = -rhoMax;
+            packed.push_back(atanh(rho));
+        }
+    }
+}
+
+Double_t SRecTrack::getPackedCovariance(const SQFloatColumn& packed, const std::vector<Float_t>& sigma, Int_t iNode, Int_t i, Int_t j)
+{
+    if(!packed.is_half()) return packed.get(15*iNode + covIndex(i, j));
+
+    Double_t sig_i = sigma[5*iNode + i];
+    Double_t sig_j = sigma[5*iNode + j];
+    if(i == j) return sig_i*sig_i;
+
+    //index among the 10 off-diagonal elements of the upper triangle
+    Int_t iCorr = i < j ? covIndex(i, j) - i - 1 : covIndex(j, i) - j - 1;
+    return tanh(packed.get(10*iNode + iCorr))*sig_i*sig_j;
+}
+
+void SRecTrack::packCovariance(const TMatrixD& cov, std::vector<Double_t>& packed)
+{
+    for(Int_t i = 0; i < 5; ++i)
+    {
+        for(Int_t j = i; j < 5; ++j) packed.push_back(cov[i][j]);
+    }
+}
+
+void SRecTrack::packCovariance(const TMatrixD& cov, Float_t* packed)
+{
+    for(Int_t i = 0; i < 5; ++i)
+    {
+        for(Int_t j = i; j < 5; ++j) packed[covIndex(i, j)] = cov[i][j];
+    }
+}
+
 TLorentzVector SRecTrack::getMomentumVertex()
 {
     Double_t mmu = 0.10566;
@@ -350,21 +515,78 @@ TLorentzVector SRecTrack::getMomentumVertex()
 
 void SRecTrack::insertGFState(const genfit::MeasuredStateOnPlane& msop)
 {
-    fGFStateVec.push_back(msop.getState());
-    fGFCov.push_back(msop.getCov());
-    fGFAuxInfo.push_back(msop.getAuxInfo());
+    const TVectorD& state = msop.getState();
+    for(Int_t i = 0; i < 5; ++i) fGFState.push_back(state[i]);
+
+    //GenFit covariance is a TMatrixDSym, the packing only needs the upper triangle
+    const TMatrixDSym& cov = msop.getCov();
+    if(SRECTRACK_DETAIL >= 2)
+    {
+        for(Int_t i = 0; i < 5; ++i)
+        {
+            for(Int_t j = i; j < 5; ++j) fGFCovFull.push_back(cov[i][j]);
+        }
+    }
+    else
+    {
+        packCovariance(cov.GetMatrixArray(), fGFCov, fGFSigma);
+    }
+
+    const TVectorD& auxInfo = msop.getAuxInfo();
+    fGFAuxSize = auxInfo.GetNrows();
+    for(Int_t i = 0; i < fGFAuxSize; ++i) fGFAuxInfo.push_back(auxInfo[i]);
 
     const genfit::SharedPlanePtr& plane = msop.getPlane();
-    fGFDetPlaneVec[0].push_back(plane->getO());
-    fGFDetPlaneVec[1].push_back(plane->getU());
-    fGFDetPlaneVec[2].push_back(plane->getV());
+    const TVector3* vecs[3] = {&plane->getO(), &plane->getU(), &plane->getV()};
+    for(Int_t i = 0; i < 3; ++i)
+    {
+        for(Int_t j = 0; j < 3; ++j) fGFPlane.push_back((*vecs[i])[j]);
+    }
+}
+
+TVectorD SRecTrack::getGFAuxInfo(Int_t i) const
+{
+    if(fGFAuxSize > 0) checkGFIndex(i, fGFAuxInfo.size()/fGFAuxSize, __PRETTY_FUNCTION__);
+
+    TVectorD auxInfo(fGFAuxSize);
+    for(Int_t j = 0; j < fGFAuxSize; ++j) auxInfo[j] = fGFAuxInfo[fGFAuxSize*i + j];
+
+    return auxInfo;
+}
+
+TVectorD SRecTrack::getGFState(Int_t i) const
+{
+    checkGFIndex(i, fGFState.size()/5, __PRETTY_FUNCTION__);
+
+    TVectorD state(5);
+    for(Int_t j = 0; j < 5; ++j) state[j] = fGFState[5*i + j];
+
+    return state;
+}
+
+TMatrixDSym SRecTrack::getGFCov(Int_t i) const
+{
+    size_t nCov = !fGFCovFull.empty() ? fGFCovFull.size()/15 : (fGFCov.is_half() ? fGFSigma.size()/5 : fGFCov.size()/15);
+    checkGFIndex(i, nCov, __PRETTY_FUNCTION__);
+
+    TMatrixDSym cov(5);
+    for(Int_t j = 0; j < 5; ++j)
+    {
+        for(Int_t k = j; k < 5; ++k)
+        {
+            cov[j][k] = fGFCovFull.empty() ? getPackedCovariance(fGFCov, fGFSigma, i, j, k) : fGFCovFull[15*i + covIndex(j, k)];
+            cov[k][j] = cov[j][k];
+        }
+    }
+
+    return cov;
 }
 
 void SRecTrack::adjustKMag(double kmagStr)
 {
-    for(std::vector<TMatrixD>::iterator iter = fState.begin(); iter != fState.end(); ++iter)
+    for(unsigned int i = 0; i < fNodeState.size(); i += 5)
     {
-        (*iter)[0][0] = (*iter)[0][0]/kmagStr;
+        fNodeState[i] = fNodeState[i]/kmagStr;
     }
 }
 
@@ -391,12 +613,12 @@ int SRecTrack::isValid() const
 
 bool SRecTrack::isTarget()
 {
-    return (fVertexPos.Z() > -300 && fVertexPos.Z() < 0. && fChisqDump - fChisqTarget > 10.);
+    return (fVertexPos[2] > -300 && fVertexPos[2] < 0. && fChisqDump - fChisqTarget > 10.);
 }
 
 bool SRecTrack::isDump()
 {
-    return (fVertexPos.Z() > 0. && fVertexPos.Z() < 150. && fChisqTarget - fChisqDump > 10.);
+    return (fVertexPos[2] > 0. && fVertexPos[2] < 150. && fChisqTarget - fChisqDump > 10.);
 }
 
 void SRecTrack::swimToVertex(TVector3* pos, TVector3* mom, bool hyptest)
@@ -416,10 +638,10 @@ void SRecTrack::swimToVertex(TVector3* pos, TVector3* mom, bool hyptest)
     }
 
     //track slope/location in upstream
-    double tx = fState.front()[1][0];
-    double ty = fState.front()[2][0];
-    double x0 = fState.front()[3][0];
-    double y0 = fState.front()[4][0];
+    double tx = fNodeState[1];
+    double ty = fNodeState[2];
+    double x0 = fNodeState[3];
+    double y0 = fNodeState[4];
     double z0 = fZ.front();
 
     //Initial position should be on the downstream face of beam dump
@@ -550,7 +772,7 @@ void SRecTrack::swimToVertex(TVector3* pos, TVector3* mom, bool hyptest)
     setVertexFast(mom[iStep], pos[iStep]);
     setDumpFacePos(pos[NSTEPS_FMAG]);
     setDumpFaceMom(mom[NSTEPS_FMAG]);
-    setTargetPos(fDumpFacePos + TVector3(fDumpFaceMom.Px()/fDumpFaceMom.Pz()*Z_TARGET, fDumpFaceMom.Py()/fDumpFaceMom.Pz()*Z_TARGET, Z_TARGET));
+    setTargetPos(getVec(fDumpFacePos) + TVector3(fDumpFaceMom[0]/fDumpFaceMom[2]*Z_TARGET, fDumpFaceMom[1]/fDumpFaceMom[2]*Z_TARGET, Z_TARGET));
     setTargetMom(mom[NSTEPS_FMAG]);
 
     double dz_x = -pos[iStep_x].X()/mom[iStep_x].Px()*mom[iStep_x].Pz();
@@ -579,14 +801,14 @@ void SRecTrack::print(std::ostream& os) const
 {
   os << "=============== Reconstructed track ==================" << std::endl;
   os << "This candidate has " << fHitIndex.size() << " hits!" << std::endl;
-  os << "Most upstream momentum is: " << 1./fabs((fState[0])[0][0]) << std::endl;
+  os << "Most upstream momentum is: " << 1./fabs(fNodeState[0]) << std::endl;
   os << "Chi square of the track is: " << fChisq << std::endl;
 
   os << "Current vertex position: " << std::endl;
   for(Int_t i = 0; i < 3; i++) os << fVertexPos[i] << "  ";
   os << std::endl;
 
-  os << "Momentum at vertex: " << 1./fabs(fStateVertex[0][0]) << std::endl;
+  os << "Momentum at vertex: " << 1./fabs(fStateVertex[0]) << std::endl;
   os << "Chi square at vertex: " << fChisqVertex << std::endl;
 }
 
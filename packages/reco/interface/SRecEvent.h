@@ -19,6 +19,7 @@ Created: 01-21-2013
 #include <phool/PHObject.h>
 #include <interface_main/SQTrack.h>
 #include <interface_main/SQDimuon.h>
+#include <interface_main/SQFloatColumn.h>
 
 #include <iostream>
 #include <vector>
@@ -39,6 +40,17 @@ Created: 01-21-2013
 
 #include "SRawEvent.h"
 
+/*
+Since version 13 the per-node track parameters are packed in fixed-size float arrays: 5 state parameters
+and the 15 elements of the upper triangle of the covariance per node, the GenFit states are packed the same
+way together with the 9 components of the O, U, V vectors of their planes. The node covariances are kept as
+float, as half floats or in full double precision depending on the recoConsts flag SRECTRACK_DETAIL (0, 1
+or 2, default 1). In the half-float mode the covariance elements are too small to be stored as they are, so
+the 5 sigmas are kept as float and the 10 correlation coefficients as atanh(rho) in half floats.
+The TMatrixD/TVector3 getters rebuild the objects on demand. The per-node states of files written with older
+versions are converted when read, and so are their GenFit states, covariances and aux info, but not the GenFit
+planes, so getNGFStates() is 0 for these tracks.
+*/
 class SRecTrack: public SQTrack
 {
 public:
@@ -63,8 +75,8 @@ public:
     virtual int  get_num_hits() const      { return getNHits(); }
     virtual void set_num_hits(const int a) { throw std::logic_error(__PRETTY_FUNCTION__); }
 
-    virtual TVector3 get_pos_vtx() const           { return fVertexPos; }
-    virtual void     set_pos_vtx(const TVector3 a) { fVertexPos = a;    } 
+    virtual TVector3 get_pos_vtx() const           { return getVec(fVertexPos); }
+    virtual void     set_pos_vtx(const TVector3 a) { setVec(fVertexPos, a); } 
 
     virtual TVector3 get_pos_st1() const           { return getPositionVecSt1(); }
     virtual void     set_pos_st1(const TVector3 a) { throw std::logic_error(__PRETTY_FUNCTION__); }
@@ -72,8 +84,8 @@ public:
     virtual TVector3 get_pos_st3() const           { return getPositionVecSt3(); }
     virtual void     set_pos_st3(const TVector3 a) { throw std::logic_error(__PRETTY_FUNCTION__); }
 
-    virtual TLorentzVector get_mom_vtx() const                 { return getlvec(fVertexMom); }
-    virtual void           set_mom_vtx(const TLorentzVector a) { fVertexMom = a.Vect(); }
+    virtual TLorentzVector get_mom_vtx() const                 { return getlvec(getVec(fVertexMom)); }
+    virtual void           set_mom_vtx(const TLorentzVector a) { setVec(fVertexMom, a.Vect()); }
 
     virtual TLorentzVector get_mom_st1() const                 { return getlvec(getMomentumVecSt1()); }
     virtual void           set_mom_st1(const TLorentzVector a) { throw std::logic_error(__PRETTY_FUNCTION__); }
@@ -86,18 +98,18 @@ public:
     virtual double get_chisq_dump() const     { return fChisqDump; } 
     virtual double get_chsiq_upstream() const { return fChisqUpstream; } 
 
-    virtual TVector3 get_pos_target() const   { return fTargetPos; }
-    virtual TVector3 get_pos_dump() const     { return fDumpPos; }
+    virtual TVector3 get_pos_target() const   { return getVec(fTargetPos); }
+    virtual TVector3 get_pos_dump() const     { return getVec(fDumpPos); }
 
-    virtual TLorentzVector get_mom_target() const { return getlvec(fTargetMom); }
-    virtual TLorentzVector get_mom_dump() const   { return getlvec(fDumpMom); }
+    virtual TLorentzVector get_mom_target() const { return getlvec(getVec(fTargetMom)); }
+    virtual TLorentzVector get_mom_dump() const   { return getlvec(getVec(fDumpMom)); }
 
     virtual int get_hit_id(const int i) const { return fHitIndex[i]; }
 
     inline TLorentzVector getlvec(const TVector3& vec) const { TLorentzVector lvec; lvec.SetVectM(vec, M_MU); return lvec; }
 
     ///Gets
-    Int_t getCharge() const { return (fState[0])[0][0] > 0 ? 1 : -1; }
+    Int_t getCharge() const { return fNodeState[0] > 0 ? 1 : -1; }
     Int_t getNHits() const { return fHitIndex.size(); }
     Int_t getNHitsInStation(Int_t stationID);
     Double_t getChisq() const { return fChisq; }
@@ -105,17 +117,20 @@ public:
     Double_t getQuality() const { return (Double_t)getNHits() - 0.4*getChisq(); }
 
     Int_t getHitIndex(Int_t i) { return fHitIndex[i]; }
-    TMatrixD getStateVector(Int_t i) { return fState[i]; }
-    TMatrixD getCovariance(Int_t i) { return fCovar[i]; }
+    TMatrixD getStateVector(Int_t i) const;
+    TMatrixD getCovariance(Int_t i) const;
     Double_t getZ(Int_t i) { return fZ[i]; }
     Double_t getChisqAtNode(Int_t i) { return fChisqAtNode[i]; }
 
-    TVector3 getGFPlaneO(Int_t i)  { return fGFDetPlaneVec[0][i]; }
-    TVector3 getGFPlaneU(Int_t i)  { return fGFDetPlaneVec[1][i]; }
-    TVector3 getGFPlaneV(Int_t i)  { return fGFDetPlaneVec[2][i]; }
-    TVectorD getGFAuxInfo(Int_t i) { return fGFAuxInfo[i]; }
-    TVectorD getGFState(Int_t i)   { return fGFStateVec[i]; }
-    TMatrixDSym getGFCov(Int_t i)  { return fGFCov[i]; }
+    ///Number of nodes with the GenFit info, which is 0 for tracks not from the GF fitter or read from version <= 11
+    ///The GF getters throw std::out_of_range for a node without the corresponding info
+    Int_t getNGFStates() const { return std::min(fGFState.size()/5, fGFPlane.size()/9); }
+    TVector3 getGFPlaneO(Int_t i)  { return getVec(&fGFPlane[9*checkGFIndex(i, fGFPlane.size()/9, __PRETTY_FUNCTION__)]); }
+    TVector3 getGFPlaneU(Int_t i)  { return getVec(&fGFPlane[9*checkGFIndex(i, fGFPlane.size()/9, __PRETTY_FUNCTION__)+3]); }
+    TVector3 getGFPlaneV(Int_t i)  { return getVec(&fGFPlane[9*checkGFIndex(i, fGFPlane.size()/9, __PRETTY_FUNCTION__)+6]); }
+    TVectorD getGFAuxInfo(Int_t i) const;
+    TVectorD getGFState(Int_t i) const;
+    TMatrixDSym getGFCov(Int_t i) const;
 
     Int_t getNearestNode(Double_t z);
     void getExpPositionFast(Double_t z, Double_t& x, Double_t& y, Int_t iNode = -1);
@@ -123,19 +138,19 @@ public:
     Double_t getExpMomentumFast(Double_t z, Double_t& px, Double_t& py, Double_t& pz, Int_t iNode = -1);
     Double_t getExpMomentumFast(Double_t z, Int_t iNode = -1);
 
-    Double_t getMomentumSt1(Double_t& px, Double_t& py, Double_t& pz) const { return getMomentum(fState.front(), px, py, pz); }
+    Double_t getMomentumSt1(Double_t& px, Double_t& py, Double_t& pz) const { return getNodeMomentum(0, px, py, pz); }
     Double_t getMomentumSt1() const { Double_t px, py, pz; return getMomentumSt1(px, py, pz); }
     TVector3 getMomentumVecSt1() const { Double_t px, py, pz; getMomentumSt1(px, py, pz); return TVector3(px, py, pz); }
 
-    Double_t getMomentumSt3(Double_t& px, Double_t& py, Double_t& pz) const { return getMomentum(fState.back(), px, py, pz); }
+    Double_t getMomentumSt3(Double_t& px, Double_t& py, Double_t& pz) const { return getNodeMomentum(getNNodes()-1, px, py, pz); }
     Double_t getMomentumSt3() const { Double_t px, py, pz; return getMomentumSt3(px, py, pz); }
     TVector3 getMomentumVecSt3() const { Double_t px, py, pz; getMomentumSt3(px, py, pz); return TVector3(px, py, pz); }
 
-    Double_t getPositionSt1(Double_t& x, Double_t& y) const { return getPosition(fState.front(), x, y); }
+    Double_t getPositionSt1(Double_t& x, Double_t& y) const { return getNodePosition(0, x, y); }
     Double_t getPositionSt1() const { Double_t x, y; return getPositionSt1(x, y); }
     TVector3 getPositionVecSt1() const { Double_t x, y; getPositionSt1(x, y); return TVector3(x, y, fZ.front()); }
 
-    Double_t getPositionSt3(Double_t& x, Double_t& y) const { return getPosition(fState.back(), x, y); }
+    Double_t getPositionSt3(Double_t& x, Double_t& y) const { return getNodePosition(getNNodes()-1, x, y); }
     Double_t getPositionSt3() const { Double_t x, y; return getPositionSt3(x, y); }
     TVector3 getPositionVecSt3() const { Double_t x, y; getPositionSt3(x, y); return TVector3(x, y, fZ.back()); }
 
@@ -152,8 +167,8 @@ public:
     ///Sets
     void setChisq(Double_t chisq) { fChisq = chisq; }
     void insertHitIndex(Int_t index) { fHitIndex.push_back(index); }
-    void insertStateVector(TMatrixD state) { fState.push_back(state); }
-    void insertCovariance(TMatrixD covar) { fCovar.push_back(covar); }
+    void insertStateVector(const TMatrixD& state) { packState(state, fNodeState); }
+    void insertCovariance(const TMatrixD& covar);
     void insertZ(Double_t z) { fZ.push_back(z); }
     void insertChisq(Double_t chisq) { fChisqAtNode.push_back(chisq); }
     void insertGFState(const genfit::MeasuredStateOnPlane& msop);
@@ -176,41 +191,41 @@ public:
     TLorentzVector getMomentumVertex();
     Double_t getMomentumVertex(Double_t& px, Double_t& py, Double_t& pz) { return getMomentum(fStateVertex, px, py, pz); }
     Double_t getZVertex() { return fVertexPos[2]; }
-    Double_t getRVertex() { return fVertexPos.Perp(); }
-    TVector3 getVertex() { return fVertexPos; }
+    Double_t getRVertex() { return sqrt(fVertexPos[0]*fVertexPos[0] + fVertexPos[1]*fVertexPos[1]); }
+    TVector3 getVertex() { return getVec(fVertexPos); }
     Double_t getVtxPar(Int_t i) { return fVertexPos[i]; }
     Double_t getChisqVertex() { return fChisqVertex; }
 
     //Get mom/pos at a given location
-    TVector3 getDumpPos() { return fDumpPos; }
-    TVector3 getDumpFacePos() { return fDumpFacePos; }
-    TVector3 getTargetPos() { return fTargetPos; }
-    TVector3 getXVertexPos() { return fXVertexPos; }
-    TVector3 getYVertexPos() { return fYVertexPos; }
-    TVector3 getDumpMom() { return fDumpMom; }
-    TVector3 getDumpFaceMom() { return fDumpFaceMom; }
-    TVector3 getTargetMom() { return fTargetMom; }
-    TVector3 getXVertexMom() { return fXVertexMom; }
-    TVector3 getYVertexMom() { return fYVertexMom; }
-    TVector3 getVertexPos() { return fVertexPos; }
-    TVector3 getVertexMom() { return fVertexMom; }
+    TVector3 getDumpPos() { return getVec(fDumpPos); }
+    TVector3 getDumpFacePos() { return getVec(fDumpFacePos); }
+    TVector3 getTargetPos() { return getVec(fTargetPos); }
+    TVector3 getXVertexPos() { return getVec(fXVertexPos); }
+    TVector3 getYVertexPos() { return getVec(fYVertexPos); }
+    TVector3 getDumpMom() { return getVec(fDumpMom); }
+    TVector3 getDumpFaceMom() { return getVec(fDumpFaceMom); }
+    TVector3 getTargetMom() { return getVec(fTargetMom); }
+    TVector3 getXVertexMom() { return getVec(fXVertexMom); }
+    TVector3 getYVertexMom() { return getVec(fYVertexMom); }
+    TVector3 getVertexPos() { return getVec(fVertexPos); }
+    TVector3 getVertexMom() { return getVec(fVertexMom); }
     Double_t getChisqDump() { return fChisqDump; }
     Double_t getChisqTarget() { return fChisqTarget; }
     Double_t getChisqUpstream() { return fChisqUpstream; }
 
     //Set mom/pos at a given location
-    void setDumpPos(TVector3 pos) { fDumpPos = pos; }
-    void setDumpFacePos(TVector3 pos) { fDumpFacePos = pos; }
-    void setTargetPos(TVector3 pos) { fTargetPos = pos; }
-    void setXVertexPos(TVector3 pos) { fXVertexPos = pos; }
-    void setYVertexPos(TVector3 pos) { fYVertexPos = pos; }
-    void setVertexPos(TVector3 pos) { fVertexPos = pos; }
-    void setDumpMom(TVector3 mom) { fDumpMom = mom; }
-    void setDumpFaceMom(TVector3 mom) { fDumpFaceMom = mom; }
-    void setTargetMom(TVector3 mom) { fTargetMom = mom; }
-    void setXVertexMom(TVector3 mom) { fXVertexMom = mom; }
-    void setYVertexMom(TVector3 mom) { fYVertexMom = mom; }
-    void setVertexMom(TVector3 mom) { fVertexMom = mom; }
+    void setDumpPos(TVector3 pos) { setVec(fDumpPos, pos); }
+    void setDumpFacePos(TVector3 pos) { setVec(fDumpFacePos, pos); }
+    void setTargetPos(TVector3 pos) { setVec(fTargetPos, pos); }
+    void setXVertexPos(TVector3 pos) { setVec(fXVertexPos, pos); }
+    void setYVertexPos(TVector3 pos) { setVec(fYVertexPos, pos); }
+    void setVertexPos(TVector3 pos) { setVec(fVertexPos, pos); }
+    void setDumpMom(TVector3 mom) { setVec(fDumpMom, mom); }
+    void setDumpFaceMom(TVector3 mom) { setVec(fDumpFaceMom, mom); }
+    void setTargetMom(TVector3 mom) { setVec(fTargetMom, mom); }
+    void setXVertexMom(TVector3 mom) { setVec(fXVertexMom, mom); }
+    void setYVertexMom(TVector3 mom) { setVec(fYVertexMom, mom); }
+    void setVertexMom(TVector3 mom) { setVec(fVertexMom, mom); }
     void setChisqDump(Double_t chisq) { fChisqDump = chisq; }
     void setChisqTarget(Double_t chisq) { fChisqTarget = chisq; }
     void setChisqUpstream(Double_t chisq) { fChisqUpstream = chisq; }
@@ -225,8 +240,8 @@ public:
     void setNHitsInPT(Int_t nHitsX, Int_t nHitsY) { fNPropHitsX = nHitsX; fNPropHitsY = nHitsY; }
     Double_t getPTSlopeX() { return fPropSlopeX; }
     Double_t getPTSlopeY() { return fPropSlopeY; }
-    Double_t getDeflectionX() { return fState.back()[1][0] - fPropSlopeX; }
-    Double_t getDeflectionY() { return fState.back()[2][0] - fPropSlopeY; }
+    Double_t getDeflectionX() { return fNodeState[5*(getNNodes()-1) + 1] - fPropSlopeX; }
+    Double_t getDeflectionY() { return fNodeState[5*(getNNodes()-1) + 2] - fPropSlopeY; }
     Int_t getNHitsInPTX() { return fNPropHitsX; }
     Int_t getNHitsInPTY() { return fNPropHitsY; }
 
@@ -238,36 +253,61 @@ public:
     ///Debugging output
     void print(std::ostream& os = std::cout) const;
 
+    ///Packing of the state vector and of the upper triangle of the symmetric 5x5 covariance, also used by the
+    ///I/O rules converting the older versions
+    static Int_t covIndex(Int_t i, Int_t j) { return i <= j ? 5*i - i*(i-1)/2 + j - i : 5*j - j*(j-1)/2 + i - j; }
+    static void packState(const TMatrixD& state, std::vector<Float_t>& packed);
+    static void packCovariance(const TMatrixD& cov, SQFloatColumn& packed, std::vector<Float_t>& sigma);
+    static void packCovariance(const TMatrixD& cov, std::vector<Double_t>& packed);
+    static void packCovariance(const TMatrixD& cov, Float_t* packed);
+
 private:
+    Int_t getNNodes() const { return fNodeState.size()/5; }
+    Double_t getNodeMomentum(Int_t i, Double_t& px, Double_t& py, Double_t& pz) const;
+    Double_t getNodePosition(Int_t i, Double_t& x, Double_t& y) const;
+    Double_t getNodeCovariance(Int_t iNode, Int_t i, Int_t j) const;
+    Double_t getMomentum(const Float_t* state, Double_t& px, Double_t& py, Double_t& pz) const;
+
+    ///Covariance packed in a SQFloatColumn, as 15 elements per node or, if half, as 5 sigmas in "sigma" and 10 atanh(rho)
+    static void packCovariance(const Double_t* cov, SQFloatColumn& packed, std::vector<Float_t>& sigma);
+    static Double_t getPackedCovariance(const SQFloatColumn& packed, const std::vector<Float_t>& sigma, Int_t iNode, Int_t i, Int_t j);
+
+    static Int_t checkGFIndex(Int_t i, size_t n, const char* func) { if(i < 0 || size_t(i) >= n) throw std::out_of_range(func); return i; }
+    static TVector3 getVec(const Float_t* v) { return TVector3(v[0], v[1], v[2]); }
+    static void setVec(Float_t* v, const TVector3& vec) { v[0] = vec.X(); v[1] = vec.Y(); v[2] = vec.Z(); }
+
     ///Total Chisq
     Double_t fChisq;
 
-    ///Hit list and associated track parameters
+    ///Hit list and associated track parameters, 5 state parameters and 15 covariance elements per node
+    ///The covariance is either in fNodeCovar (float or half, with fNodeSigma) or in fNodeCovarFull, see SRECTRACK_DETAIL
     std::vector<Int_t> fHitIndex;
-    std::vector<TMatrixD> fState;
-    std::vector<TMatrixD> fCovar;
+    std::vector<Float_t> fNodeState;
+    SQFloatColumn fNodeCovar;
+    std::vector<Float_t> fNodeSigma;
+    std::vector<Double_t> fNodeCovarFull;
     std::vector<Double_t> fZ;
     std::vector<Double_t> fChisqAtNode;
 
     ///Momentum/Position at a given z
-    TVector3 fDumpFacePos;
-    TVector3 fDumpPos;
-    TVector3 fTargetPos;
-    TVector3 fXVertexPos;
-    TVector3 fYVertexPos;
-
-    TVector3 fDumpFaceMom;
-    TVector3 fDumpMom;
-    TVector3 fTargetMom;
-    TVector3 fXVertexMom;
-    TVector3 fYVertexMom;
+    Float_t fDumpFacePos[3];
+    Float_t fDumpPos[3];
+    Float_t fTargetPos[3];
+    Float_t fXVertexPos[3];
+    Float_t fYVertexPos[3];
+
+    Float_t fDumpFaceMom[3];
+    Float_t fDumpMom[3];
+    Float_t fTargetMom[3];
+    Float_t fXVertexMom[3];
+    Float_t fYVertexMom[3];
 
     ///Vertex infomation
-    TVector3 fVertexMom;      //duplicate information as fStateVertex already contains all the info., just keep it for now
-    TVector3 fVertexPos;
+    Float_t fVertexMom[3];      //duplicate information as fStateVertex already contains all the info., just keep it for now
+    Float_t fVertexPos[3];
     Double_t fChisqVertex;
-    TMatrixD fStateVertex;
-    TMatrixD fCovarVertex;
+    Float_t fStateVertex[5];
+    Float_t fCovarVertex[15];
 
     ///Kalman Fitted
     Int_t fKalmanStatus;
@@ -287,12 +327,16 @@ private:
     Double_t fChisqUpstream;
 
     //GenFit track info - only available if the track comes from GF fitter
-    std::vector<TVector3> fGFDetPlaneVec[3];
-    std::vector<TVectorD> fGFAuxInfo;
-    std::vector<TVectorD> fGFStateVec;
-    std::vector<TMatrixDSym> fGFCov;
-
-    ClassDef(SRecTrack, 11)
+    //plane O, U, V (9 per node), state (5 per node), covariance (15 per node) and fGFAuxSize aux. info per node
+    std::vector<Float_t> fGFPlane;
+    std::vector<Float_t> fGFState;
+    SQFloatColumn fGFCov;
+    std::vector<Float_t> fGFSigma;
+    std::vector<Double_t> fGFCovFull;
+    Int_t fGFAuxSize;
+    std::vector<Float_t> fGFAuxInfo;
+
+    ClassDef(SRecTrack, 13)
 };
 
 class SRecDimuon: public SQDimuon
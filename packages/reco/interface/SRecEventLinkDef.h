@@ -5,6 +5,28 @@
 #pragma link off all functions;
 
 #pragma link C++ class SRecTrack+;
+
+//SRecTrack version 13 packs the node states and replaces the TVector3/TMatrixD members by float arrays
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="std::vector<TMatrixD> fState; std::vector<TMatrixD> fCovar" target="fNodeState, fNodeCovarFull" code="{ fNodeState.clear(); fNodeCovarFull.clear(); for(unsigned int i = 0; i < onfile.fState.size(); ++i) { SRecTrack::packState(onfile.fState[i], fNodeState); SRecTrack::packCovariance(onfile.fCovar[i], fNodeCovarFull); } }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TMatrixD fStateVertex; TMatrixD fCovarVertex" target="fStateVertex, fCovarVertex" code="{ for(int i = 0; i < 5; ++i) fStateVertex[i] = onfile.fStateVertex[i][0]; SRecTrack::packCovariance(onfile.fCovarVertex, fCovarVertex); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fDumpFacePos" target="fDumpFacePos" code="{ onfile.fDumpFacePos.GetXYZ(fDumpFacePos); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fDumpPos" target="fDumpPos" code="{ onfile.fDumpPos.GetXYZ(fDumpPos); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fTargetPos" target="fTargetPos" code="{ onfile.fTargetPos.GetXYZ(fTargetPos); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fXVertexPos" target="fXVertexPos" code="{ onfile.fXVertexPos.GetXYZ(fXVertexPos); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fYVertexPos" target="fYVertexPos" code="{ onfile.fYVertexPos.GetXYZ(fYVertexPos); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fDumpFaceMom" target="fDumpFaceMom" code="{ onfile.fDumpFaceMom.GetXYZ(fDumpFaceMom); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fDumpMom" target="fDumpMom" code="{ onfile.fDumpMom.GetXYZ(fDumpMom); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fTargetMom" target="fTargetMom" code="{ onfile.fTargetMom.GetXYZ(fTargetMom); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fXVertexMom" target="fXVertexMom" code="{ onfile.fXVertexMom.GetXYZ(fXVertexMom); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fYVertexMom" target="fYVertexMom" code="{ onfile.fYVertexMom.GetXYZ(fYVertexMom); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fVertexMom" target="fVertexMom" code="{ onfile.fVertexMom.GetXYZ(fVertexMom); }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="TVector3 fVertexPos" target="fVertexPos" code="{ onfile.fVertexPos.GetXYZ(fVertexPos); }"
+
+//GenFit per-node info of version <= 11, the planes (std::vector<TVector3> fGFDetPlaneVec[3]) are not converted
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="std::vector<TVectorD> fGFStateVec" target="fGFState" code="{ fGFState.clear(); for(unsigned int i = 0; i < onfile.fGFStateVec.size(); ++i) { for(int j = 0; j < 5; ++j) fGFState.push_back(onfile.fGFStateVec[i][j]); } }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="std::vector<TMatrixDSym> fGFCov" target="fGFCovFull" code="{ fGFCovFull.clear(); for(unsigned int i = 0; i < onfile.fGFCov.size(); ++i) { for(int j = 0; j < 5; ++j) { for(int k = j; k < 5; ++k) fGFCovFull.push_back(onfile.fGFCov[i](j, k)); } } }"
+#pragma read sourceClass="SRecTrack" version="[-11]" targetClass="SRecTrack" source="std::vector<TVectorD> fGFAuxInfo" target="fGFAuxInfo, fGFAuxSize" code="{ fGFAuxInfo.clear(); fGFAuxSize = onfile.fGFAuxInfo.empty() ? 0 : onfile.fGFAuxInfo[0].GetNrows(); for(unsigned int i = 0; i < onfile.fGFAuxInfo.size(); ++i) { for(int j = 0; j < fGFAuxSize; ++j) fGFAuxInfo.push_back(onfile.fGFAuxInfo[i][j]); } }"
+
 #pragma link C++ class SRecDimuon+;
 #pragma link C++ class SRecEvent+;
 
@@ -0,0 +1,325 @@
+/*
+TrackletFunc.h
+
+Track model and quality cuts shared by Tracklet (FastTracklet.h) and the CompactTracklet
+used inside KalmanFastTracking. The templates only use the data members common to both
+classes (stationID, nXHits/nUHits/nVHits, chisq, tx, ty, x0, y0, invP and their errors),
+the hit lists are walked by each class itself.
+
+The constants are read once from recoConsts and GeomSvc, see initGlobalVariables() in
+FastTracklet.cxx.
+*/
+
+#ifndef _TRACKLETFUNC_H
+#define _TRACKLETFUNC_H
+
+#include <GlobalConsts.h>
+
+#include <cmath>
+
+#include <TMath.h>
+
+#include <geom_svc/GeomSvc.h>
+
+namespace TrackletGlobals
+{
+    //pointer to geomtry service
+    extern GeomSvc* p_geomSvc;
+
+    //flag of kmag on/off
+    extern bool KMAG_ON;
+
+    //corase geometry
+    extern bool COARSE_MODE;
+
+    //kmag strength
+    extern double FMAGSTR;
+    extern double KMAGSTR;
+
+    extern double PT_KICK_FMAG;
+    extern double PT_KICK_KMAG;
+
+    //Track quality cuts
+    extern double TX_MAX;
+    extern double TY_MAX;
+    extern double X0_MAX;
+    extern double Y0_MAX;
+    extern double INVP_MAX;
+    extern double INVP_MIN;
+    extern double PROB_LOOSE;
+    extern double PROB_TIGHT;
+
+    //Geometric positions
+    extern double Z_KMAG_BEND;
+    extern double Z_ABSORBER;
+    extern double Z_FMAG_BEND;
+    extern double Z_KFMAG_BEND;
+    extern double ELOSS_KFMAG;
+    extern double ELOSS_ABSORBER;
+
+    //initialize global variables, only the first call does the work
+    void initGlobalVariables();
+}
+
+namespace TrackletFunc
+{
+    //Decide charge by KMag bending direction
+    template<class T> int getCharge(const T& trk)
+    {
+        return trk.x0*TrackletGlobals::KMAGSTR > trk.tx ? 1 : -1;
+    }
+
+    //Slope and intersection in station 1
+    template<class T> void getXZInfoInSt1(const T& trk, double& tx_st1, double& x0_st1)
+    {
+        using namespace TrackletGlobals;
+        if(KMAG_ON)
+        {
+            tx_st1 = trk.tx + PT_KICK_KMAG*trk.invP*getCharge(trk);
+            x0_st1 = trk.tx*Z_KMAG_BEND + trk.x0 - tx_st1*Z_KMAG_BEND;
+        }
+        else
+        {
+            tx_st1 = trk.tx;
+            x0_st1 = trk.x0;
+        }
+    }
+
+    template<class T> void getXZErrorInSt1(const T& trk, double& err_tx_st1, double& err_x0_st1)
+    {
+        using namespace TrackletGlobals;
+        if(KMAG_ON)
+        {
+            double err_kick = fabs(trk.err_invP*PT_KICK_KMAG);
+            err_tx_st1 = trk.err_tx + err_kick;
+            err_x0_st1 = trk.err_x0 + err_kick*Z_KMAG_BEND;
+        }
+        else
+        {
+            err_tx_st1 = trk.err_tx;
+            err_x0_st1 = trk.err_x0;
+        }
+    }
+
+    //Expected x and y positions and errors at a given z
+    template<class T> double getExpPositionX(const T& trk, double z)
+    {
+        using namespace TrackletGlobals;
+        if(KMAG_ON && trk.stationID >= nStations-1 && z < Z_KMAG_BEND - 1.)
+        {
+            double tx_st1, x0_st1;
+            getXZInfoInSt1(trk, tx_st1, x0_st1);
+            return x0_st1 + tx_st1*z;
+        }
+        return trk.x0 + trk.tx*z;
+    }
+
+    template<class T> double getExpPosErrorX(const T& trk, double z)
+    {
+        using namespace TrackletGlobals;
+        double err_x;
+        if(KMAG_ON && trk.stationID >= nStations-1 && z < Z_KMAG_BEND - 1.)
+        {
+            double err_tx_st1, err_x0_st1;
+            getXZErrorInSt1(trk, err_tx_st1, err_x0_st1);
+            err_x = err_x0_st1 + fabs(err_tx_st1*z);
+        }
+        else
+        {
+            err_x = fabs(trk.err_tx*z) + trk.err_x0;
+        }
+
+        if(z > Z_ABSORBER) err_x += 1.;
+        return err_x;
+    }
+
+    template<class T> double getExpPosErrorY(const T& trk, double z)
+    {
+        double err_y = fabs(trk.err_ty*z) + trk.err_y0;
+        if(z > TrackletGlobals::Z_ABSORBER) err_y += 1.;
+
+        return err_y;
+    }
+
+    //Momentum estimation using back partial
+    template<class T> double getMomentum(const T& trk)
+    {
+        //Ref. SEAQUEST-doc-453-v3 by Don. Geesaman
+        using namespace TrackletGlobals;
+        double p = 50.;
+        double charge = getCharge(trk);
+
+        double c1 = Z_FMAG_BEND*PT_KICK_FMAG*charge;
+        double c2 = Z_KMAG_BEND*PT_KICK_KMAG*charge;
+        double c3 = -trk.x0;
+        double c4 = ELOSS_KFMAG/2.;
+        double c5 = ELOSS_KFMAG;
+
+        double b = c1/c3 + c2/c3 - c4 - c5;
+        double c = c4*c5 - c1*c5/c3 - c2*c4/c3;
+
+        double disc = b*b - 4*c;
+        if(disc > 0.)
+        {
+            p = (-b + sqrt(disc))/2. - ELOSS_KFMAG;
+        }
+
+        if(p < 10. || p > 120. || disc < 0)
+        {
+            double k = fabs(getExpPositionX(trk, Z_KFMAG_BEND)/Z_KFMAG_BEND - trk.tx);
+            p = 1./(0.00832161 + 0.184186*k - 0.104132*k*k) + ELOSS_ABSORBER;
+        }
+
+        return p;
+    }
+
+    template<class T> double getProb(const T& trk)
+    {
+        int ndf = (trk.stationID == nStations && TrackletGlobals::KMAG_ON) ? trk.getNHits() - 5 : trk.getNHits() - 4;
+        return TMath::Prob(trk.chisq, ndf);
+    }
+
+    //Count a real (not dummy, not removed) hit in nRealHits[station][X/U/V] and in the hit counts of trk
+    template<class T> void countRealHit(const T& trk, int detectorID, int nRealHits[3][3])
+    {
+        int idx1 = detectorID <= 12 ? 0 : (detectorID <= 18 ? 1 : 2);
+        int idx2 = TrackletGlobals::p_geomSvc->getPlaneType(detectorID) - 1;
+
+        ++nRealHits[idx1][idx2];
+        if(idx2 == 0)
+            ++trk.nXHits;
+        else if(idx2 == 1)
+            ++trk.nUHits;
+        else
+            ++trk.nVHits;
+    }
+
+    //Quality cut, countHits(nRealHits) has to call countRealHit() for every real hit of trk
+    template<class T, class HitCounter> int isValid(const T& trk, HitCounter countHits)
+    {
+        using namespace TrackletGlobals;
+        if(trk.stationID < 1 || trk.stationID > nStations) return 0;
+        if(fabs(trk.tx) > TX_MAX || fabs(trk.x0) > X0_MAX) return 0;
+        if(fabs(trk.ty) > TY_MAX || fabs(trk.y0) > Y0_MAX) return 0;
+        if(trk.err_tx < 0 || trk.err_ty < 0 || trk.err_x0 < 0 || trk.err_y0 < 0) return 0;
+
+        double prob = getProb(trk);
+        if(trk.stationID != nStations && prob < PROB_LOOSE) return 0;
+
+        //Tracklets in each station
+        int nHits = trk.nXHits + trk.nUHits + trk.nVHits;
+        if(trk.stationID < nStations-1)
+        {
+            if(trk.nXHits < 1 || trk.nUHits < 1 || trk.nVHits < 1) return 0;
+            if(nHits < 4) return 0;
+            if(trk.chisq > 40.) return 0;
+        }
+        else
+        {
+            //Number of hits cuts, second index is X, U, V, first index is station-1, 2, 3
+            int nRealHits[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+            trk.nXHits = 0; trk.nUHits = 0; trk.nVHits = 0;
+            countHits(nRealHits);
+
+            //Number of hits cut after removing bad hits
+            for(int i = 1; i < 3; ++i)
+            {
+                if(nRealHits[i][0] < 1 || nRealHits[i][1] < 1 || nRealHits[i][2] < 1) return 0;
+                if(nRealHits[i][0] + nRealHits[i][1] + nRealHits[i][2] < 4) return 0;
+            }
+
+            //for global tracks only -- TODO: may need to set a new station-1 cut
+            if(trk.stationID == nStations)
+            {
+                if(nRealHits[0][0] < 1 || nRealHits[0][1] < 1 || nRealHits[0][2] < 1) return 0;
+                if(nRealHits[0][0] + nRealHits[0][1] + nRealHits[0][2] < 4) return 0;
+
+                if(prob < PROB_TIGHT) return 0;
+                if(KMAG_ON)
+                {
+                    if(trk.invP < INVP_MIN || trk.invP > INVP_MAX) return 0;
+                }
+            }
+        }
+
+        return 1;
+    }
+
+    //Station-1 parameters used by hitChisq(), only needed for global tracks with KMag on
+    template<class T> void getChisqParameters(const T& trk, double& tx_st1, double& x0_st1)
+    {
+        tx_st1 = trk.tx;
+        x0_st1 = trk.x0;
+        if(trk.stationID == nStations && TrackletGlobals::KMAG_ON) getXZInfoInSt1(trk, tx_st1, x0_st1);
+    }
+
+    //Chi square contribution of one real hit, its residual is returned in residual
+    template<class T> double hitChisq(const T& trk, double tx_st1, double x0_st1, int detectorID, int elementID, double driftDistance, int sign, double& residual)
+    {
+        using namespace TrackletGlobals;
+        double sigma;
+        if(sign == 0 || COARSE_MODE)
+            sigma = p_geomSvc->getPlaneSpacing(detectorID)/sqrt(12.);
+        else
+            sigma = p_geomSvc->getPlaneResolution(detectorID);
+
+        if(KMAG_ON && trk.stationID == nStations && detectorID <= 12)
+        {
+            residual = sign*fabs(driftDistance) - p_geomSvc->getDCA(detectorID, elementID, tx_st1, trk.ty, x0_st1, trk.y0);
+        }
+        else
+        {
+            residual = sign*fabs(driftDistance) - p_geomSvc->getDCA(detectorID, elementID, trk.tx, trk.ty, trk.x0, trk.y0);
+        }
+
+        return residual*residual/sigma/sigma;
+    }
+
+    //For sorting tracklet list
+    template<class T> bool lessThan(const T& trk, const T& elem)
+    {
+        if(trk.getNHits() == elem.getNHits()) return trk.chisq < elem.chisq;
+        return getProb(trk) > getProb(elem);
+    }
+
+    //For reducing similar tracklets, nCommonHits is counted by the caller
+    template<class T> bool isSimilar(const T& elem, int nCommonHits)
+    {
+        return nCommonHits/double(elem.getNHits()) > 0.33333;
+    }
+
+    //Parameters of the back partial track built from two station tracklets (operator+)
+    template<class T> void setBackPartialParameters(const T& trk1, const T& trk2, T& tracklet)
+    {
+        tracklet.err_tx = 1./sqrt(1./trk1.err_tx/trk1.err_tx + 1./trk2.err_tx/trk2.err_tx);
+        tracklet.err_ty = 1./sqrt(1./trk1.err_ty/trk1.err_ty + 1./trk2.err_ty/trk2.err_ty);
+        tracklet.err_x0 = 1./sqrt(1./trk1.err_x0/trk1.err_x0 + 1./trk2.err_x0/trk2.err_x0);
+        tracklet.err_y0 = 1./sqrt(1./trk1.err_y0/trk1.err_y0 + 1./trk2.err_y0/trk2.err_y0);
+
+        tracklet.tx = (trk1.tx/trk1.err_tx/trk1.err_tx + trk2.tx/trk2.err_tx/trk2.err_tx)*tracklet.err_tx*tracklet.err_tx;
+        tracklet.ty = (trk1.ty/trk1.err_ty/trk1.err_ty + trk2.ty/trk2.err_ty/trk2.err_ty)*tracklet.err_ty*tracklet.err_ty;
+        tracklet.x0 = (trk1.x0/trk1.err_x0/trk1.err_x0 + trk2.x0/trk2.err_x0/trk2.err_x0)*tracklet.err_x0*tracklet.err_x0;
+        tracklet.y0 = (trk1.y0/trk1.err_y0/trk1.err_y0 + trk2.y0/trk2.err_y0/trk2.err_y0)*tracklet.err_y0*tracklet.err_y0;
+
+        tracklet.invP = 1./getMomentum(tracklet);
+        tracklet.err_invP = 0.25*tracklet.invP;
+    }
+
+    //Parameters taken over from the back partial track (operator*, merge)
+    template<class T> void setParametersFrom(const T& partial, T& tracklet)
+    {
+        tracklet.tx = partial.tx;
+        tracklet.ty = partial.ty;
+        tracklet.x0 = partial.x0;
+        tracklet.y0 = partial.y0;
+        tracklet.invP = 1./getMomentum(partial);
+
+        tracklet.err_tx = partial.err_tx;
+        tracklet.err_ty = partial.err_ty;
+        tracklet.err_x0 = partial.err_x0;
+        tracklet.err_y0 = partial.err_y0;
+        tracklet.err_invP = 0.25*tracklet.invP;
+    }
+}
+
+#endif
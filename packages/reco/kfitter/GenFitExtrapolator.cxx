@@ -15,6 +15,9 @@
 
 //ROOT
 #include <TGeoManager.h>
+#include <TGeoMaterial.h>
+#include <TGeoNode.h>
+#include <TGeoVolume.h>
 #include <TMath.h>
 
 //
@@ -38,6 +41,10 @@ namespace
     static double FMAG_LENGTH;
     static double Z_UPSTREAM;
 
+    //Straight-line transport: field sampling step along the line (cm) and muon mass (GeV)
+    static const double FIELD_SAMPLE_STEP = 10.;
+    static const double MUON_MASS = 0.1056584;
+
     //initialize global variables
     void initGlobalVariables()
     {
@@ -60,17 +67,40 @@ static const double c_light   = 2.99792458e+8 * m/s;
 
 using namespace std;
 
+///The RKTrackRep keeps the Jacobian of the last extrapolation, the planes are moved
+///to the requested z instead of being re-created
+struct GenFitExtrapolator::RKPropagator
+{
+    RKPropagator(int pid):
+        rep(pid), state(&rep),
+        startPlane(new genfit::DetPlane(TVector3(0, 0, 0), TVector3(0, 0, 1))),
+        destPlane(new genfit::DetPlane(TVector3(0, 0, 0), TVector3(0, 0, 1)))
+    {}
+
+    genfit::RKTrackRep rep;
+    genfit::MeasuredStateOnPlane state;
+    genfit::SharedPlanePtr startPlane;
+    genfit::SharedPlanePtr destPlane;
+};
+
 GenFitExtrapolator::GenFitExtrapolator():
 	pos_i(TVector3()), mom_i(TVector3()), cov_i(TMatrixDSym(5)),
 	pos_f(TVector3()), mom_f(TVector3()), cov_f(TMatrixDSym(5)),
 	jac_sd2sc(TMatrixD(5,5)), jac_sc2sd(TMatrixD(5,5)), propM(TMatrixD(5,5)),
-        jac_genfit2legacy(TMatrixD(5,5)), jac_legacy2genfit(TMatrixD(5,5))
+        jac_genfit2legacy(TMatrixD(5,5)), jac_legacy2genfit(TMatrixD(5,5)),
+        _tgeo_manager(nullptr), straightLine(false), maxFieldSL(1E-3), maxX0SL(0.05), nMatSteps(0)
 {
+    rkProp[0] = nullptr;
+    rkProp[1] = nullptr;
+
     initGlobalVariables();
 }
 
 GenFitExtrapolator::~GenFitExtrapolator()
-	{}
+{
+    delete rkProp[0];
+    delete rkProp[1];
+}
 
 bool GenFitExtrapolator::init(const PHField* field, const TGeoManager *geom)
 {
@@ -303,6 +333,13 @@ bool GenFitExtrapolator::extrapolateTo(double z_out) {
       return true;
   }
 
+  ///field-free and (almost) empty gap, no need for Runge-Kutta
+  if(straightLine && isStraightLineGap(z_out))
+  {
+      extrapolateStraight(z_out);
+      return true;
+  }
+
 	int pid = iParType > 0 ? -13 : 13;
 #ifdef _DEBUG_ON
 		cout
@@ -312,21 +349,20 @@ bool GenFitExtrapolator::extrapolateTo(double z_out) {
 		<< endl;
 #endif
 
-	auto up_rep = std::unique_ptr<genfit::AbsTrackRep> (new genfit::RKTrackRep(pid));
-	auto rep = up_rep.get();
-        ///set destination plane
-	genfit::SharedPlanePtr destPlane(new genfit::DetPlane(TVector3(0, 0, z_out), TVector3(0, 0, 1)));
+	RKPropagator*& prop = rkProp[iParType > 0 ? 0 : 1];
+	if(prop == nullptr) prop = new RKPropagator(pid);
+
+	///Set starting plane first, the state may still sit on the destination plane of the previous call
+	prop->startPlane->setO(TVector3(0, 0, pos_i[2]));
+	prop->state.setPlane(prop->startPlane);
+	prop->state.setPosMom(pos_i, mom_i);
+	prop->state.setCov(cov_i);
 
-	std::unique_ptr<genfit::MeasuredStateOnPlane> currentState = std::unique_ptr < genfit::MeasuredStateOnPlane > (new genfit::MeasuredStateOnPlane(rep));
-        ///Set starting plane in GenFit (similar as destination plane)
-        genfit::SharedPlanePtr startplane(new genfit::DetPlane(TVector3(0, 0, pos_i[2]), TVector3(0, 0, 1)));
-        currentState->setPlane(startplane);
-	//rep->setPosMomCov(*currentState, pos_i, mom_i, cov_i);
-	currentState->setPosMom(pos_i, mom_i);
-	currentState->setCov(cov_i);
+	///set destination plane
+	prop->destPlane->setO(TVector3(0, 0, z_out));
 
 	try {
-		travelLength = rep->extrapolateToPlane(*currentState, destPlane);
+		travelLength = prop->rep.extrapolateToPlane(prop->state, prop->destPlane);
 	} catch (...) {
 #ifdef _DEBUG_ON
 		cout << "extrapolateToPlane failed!" << endl;
@@ -334,13 +370,153 @@ bool GenFitExtrapolator::extrapolateTo(double z_out) {
 		return false;
 	}
 
-	currentState->getPosMom(pos_f, mom_f);
-	cov_f = currentState->getCov();
-	propM =  rep->getJacobian();///Get propagator between the starting and destination plane
+	prop->state.getPosMom(pos_f, mom_f);
+	cov_f = prop->state.getCov();
+	propM =  prop->rep.getJacobian();///Get propagator between the starting and destination plane
 
 	return true;
 }
 
+bool GenFitExtrapolator::isStraightLineGap(double z_out)
+{
+  nMatSteps = 0;
+  if(mom_i[2] <= 0.) return false;
+
+  double dz = z_out - pos_i[2];
+  double tx = mom_i[0]/mom_i[2];
+  double ty = mom_i[1]/mom_i[2];
+
+  ///Sample the field along the line, both ends included
+  genfit::AbsBField* field = genfit::FieldManager::getInstance()->getField();
+  if(field != nullptr)
+  {
+      int nSamples = int(fabs(dz)/FIELD_SAMPLE_STEP) + 2;
+      for(int i = 0; i < nSamples; ++i)
+      {
+          double z = pos_i[2] + dz*i/(nSamples - 1);
+          TVector3 H = field->get(TVector3(pos_i[0] + tx*(z - pos_i[2]), pos_i[1] + ty*(z - pos_i[2]), z));
+          if(H.Mag2() > maxFieldSL*maxFieldSL) return false;
+      }
+  }
+
+  ///Walk through the volumes along the line and sum up X/X0
+  if(_tgeo_manager == nullptr) return false;
+
+  double dirScale = (dz > 0. ? 1. : -1.)/sqrt(1. + tx*tx + ty*ty);
+  _tgeo_manager->InitTrack(pos_i[0], pos_i[1], pos_i[2], tx*dirScale, ty*dirScale, dirScale);
+
+  double cosz = fabs(dirScale);
+  double remaining = fabs(dz)/cosz;
+  double z_curr = pos_i[2];
+  double sumX0 = 0.;
+  while(remaining > 1E-6)
+  {
+      if(nMatSteps == MAXMATSTEPS || _tgeo_manager->IsOutside()) return false;
+
+      TGeoNode* node = _tgeo_manager->GetCurrentNode();
+      if(node == nullptr) return false;
+      double radLen = node->GetVolume()->GetMaterial()->GetRadLen();
+
+      _tgeo_manager->FindNextBoundaryAndStep(remaining);
+      double step = _tgeo_manager->GetStep();
+      if(step > remaining) step = remaining;
+      remaining -= step;
+
+      ///one step ahead along z
+      double stepZ = step*cosz*(dz > 0. ? 1. : -1.);
+      if(radLen > 0.)
+      {
+          matStepDz[nMatSteps] = fabs(stepZ);
+          matStepDist[nMatSteps] = z_out - (z_curr + 0.5*stepZ);
+          matStepX0[nMatSteps] = step/radLen;
+          sumX0 += matStepX0[nMatSteps];
+          ++nMatSteps;
+
+          if(sumX0 > maxX0SL) return false;
+      }
+      z_curr += stepZ;
+
+      ///guard against navigation stuck on a boundary
+      if(step < 1E-9 && remaining > 1E-6) return false;
+  }
+
+  return true;
+}
+
+void GenFitExtrapolator::extrapolateStraight(double z_out)
+{
+  double dz = z_out - pos_i[2];
+  double tx = mom_i[0]/mom_i[2];
+  double ty = mom_i[1]/mom_i[2];
+
+  mom_f = mom_i;
+  pos_f.SetXYZ(pos_i[0] + tx*dz, pos_i[1] + ty*dz, z_out);
+  travelLength = dz*sqrt(1. + tx*tx + ty*ty);
+
+  ///Propagator on the GenFit plane parameters (q/p, u', v', u, v), u = -x and v = -y:
+  ///only the positions move, by the slope times dz
+  propM.UnitMatrix();
+  propM[3][1] = dz;
+  propM[4][2] = dz;
+
+  ///cov_f = propM*cov_i*propM^T, done on the two rows/columns which change
+  double c[5][5];
+  for(int i = 0; i < 5; ++i)
+  {
+      for(int j = 0; j < 5; ++j) c[i][j] = cov_i[i][j];
+  }
+  for(int j = 0; j < 5; ++j)
+  {
+      c[3][j] += dz*c[1][j];
+      c[4][j] += dz*c[2][j];
+  }
+  for(int i = 0; i < 5; ++i)
+  {
+      c[i][3] += dz*c[i][1];
+      c[i][4] += dz*c[i][2];
+  }
+
+  ///Multiple scattering in the traversed material (Highland), each step is treated as a uniform slab
+  double sumX0 = 0.;
+  for(int i = 0; i < nMatSteps; ++i) sumX0 += matStepX0[i];
+  if(sumX0 > 0.)
+  {
+      double p = mom_i.Mag();
+      double beta = p/sqrt(p*p + MUON_MASS*MUON_MASS);
+      double theta0 = 0.0136/(beta*p)*(1. + 0.038*log(sumX0));
+      double theta2 = theta0*theta0*sumX0;
+
+      ///first and second moments of the distance between the scattering point and z_out
+      double m1 = 0.;
+      double m2 = 0.;
+      for(int i = 0; i < nMatSteps; ++i)
+      {
+          double w = matStepX0[i]/sumX0;
+          m1 += w*matStepDist[i];
+          m2 += w*(matStepDist[i]*matStepDist[i] + matStepDz[i]*matStepDz[i]/12.);
+      }
+
+      ///projected slope covariance, same sign for u', v' as for x', y'
+      double norm = theta2*(1. + tx*tx + ty*ty);
+      double s11 = norm*(1. + tx*tx);
+      double s12 = norm*tx*ty;
+      double s22 = norm*(1. + ty*ty);
+
+      c[1][1] += s11;    c[1][2] += s12;    c[2][2] += s22;
+      c[1][3] += s11*m1; c[1][4] += s12*m1; c[2][3] += s12*m1; c[2][4] += s22*m1;
+      c[3][3] += s11*m2; c[3][4] += s12*m2; c[4][4] += s22*m2;
+
+      c[2][1] = c[1][2];
+      c[3][1] = c[1][3]; c[4][1] = c[1][4]; c[3][2] = c[2][3]; c[4][2] = c[2][4];
+      c[4][3] = c[3][4];
+  }
+
+  for(int i = 0; i < 5; ++i)
+  {
+      for(int j = 0; j < 5; ++j) cov_f[i][j] = c[i][j];
+  }
+}
+
 //int GenFitExtrapolator::propagate() {
 //
 //	return -1;
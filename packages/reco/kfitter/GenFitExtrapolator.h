@@ -77,6 +77,12 @@ public:
     void setPropCalc(bool option) { calcProp = option; }
     void setLengthCalc(bool option) { calcLength = option; }
 
+    ///Analytic straight-line transport in the gaps where the field is below maxField (kGauss)
+    ///and the material along the line is below maxX0 radiation lengths, Runge-Kutta elsewhere.
+    ///Off by default since the energy loss in those gaps is neglected
+    void setStraightLineTransport(bool option) { straightLine = option; }
+    void setStraightLineCuts(double maxField, double maxX0) { maxFieldSL = maxField; maxX0SL = maxX0; }
+
 
    ///Tranformation between GenFit and Legacy plane; Abi
     void TRGENFIT2LEGACY(int charge, TVector3 mom_input, TVector3 pos_input);
@@ -87,6 +93,15 @@ public:
     void print();
 
 private:
+    GenFitExtrapolator(const GenFitExtrapolator&);
+    GenFitExtrapolator& operator=(const GenFitExtrapolator&);
+
+    ///Check if the gap between pos_i and z_out can be crossed on a straight line, also
+    ///fills the material steps used for the multiple scattering noise
+    bool isStraightLineGap(double z_out);
+
+    ///Straight-line transport from pos_i to z_out, with exact propagator and multiple scattering noise
+    void extrapolateStraight(double z_out);
 
     ///Internal static flag, check if the tracking manager has been inited of not
     static bool fullInit;
@@ -147,6 +162,22 @@ private:
     TMatrixD propM;    
 
     TGeoManager* _tgeo_manager;
+
+    ///Persistent GenFit track rep, state and planes re-used by all RK extrapolations, one per charge
+    struct RKPropagator;
+    RKPropagator* rkProp[2];
+
+    ///Straight-line transport settings
+    bool straightLine;
+    double maxFieldSL;
+    double maxX0SL;
+
+    ///Material steps found by isStraightLineGap: length in z, distance of the step center to z_out, and X/X0
+    static const int MAXMATSTEPS = 50;
+    int nMatSteps;
+    double matStepDz[MAXMATSTEPS];
+    double matStepDist[MAXMATSTEPS];
+    double matStepX0[MAXMATSTEPS];
 };
 
 #endif
@@ -45,6 +45,7 @@ KalmanFilter::KalmanFilter(bool limitedStep)
 bool KalmanFilter::initExtrapolator(const PHField *field,  const TGeoManager *geom)
 {
 	_extrapolator.init(field, geom);
+	_extrapolator.setStraightLineTransport(recoConsts::instance()->get_BoolFlag("KF_STRAIGHT_LINE"));
 }
 
 bool KalmanFilter::fit_node(Node& _node)
@@ -0,0 +1,331 @@
+/*
+CompactTracklet.cxx
+
+Implementation of class CompactSegment and CompactTracklet, the track model and the
+quality cuts are shared with Tracklet through TrackletFunc.h
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "TrackletFunc.h"
+
+#include "CompactTracklet.h"
+
+CompactSegment::CompactSegment(): a(-999.), b(-999.), err_a(100.), err_b(100.), chisq(1.E6), nHits(0), nPlanes(0), valid(false), nHodoHits(0)
+{
+    for(int i = 0; i < 4; ++i)
+    {
+        hitIDs[i] = -1;
+        signs[i] = 0;
+        hodoHitIDs[i] = -1;
+    }
+}
+
+void CompactSegment::pack(const PropSegment& seg, const int* hitIDs_seg)
+{
+    a = seg.a;
+    b = seg.b;
+    err_a = seg.err_a;
+    err_b = seg.err_b;
+    chisq = seg.chisq;
+
+    //PropSegment::fit() may have dropped some of the hits
+    for(int i = 0; i < 4; ++i)
+    {
+        hitIDs[i] = seg.hits[i].hit.index < 0 ? -1 : hitIDs_seg[i];
+        signs[i] = seg.hits[i].sign;
+    }
+
+    nHits = seg.getNHits();
+    nPlanes = seg.getNPlanes();
+    valid = seg.isValid() > 0;
+
+    //hodoscope hits are only added afterwards by muon ID
+    nHodoHits = 0;
+    for(int i = 0; i < 4; ++i) hodoHitIDs[i] = -1;
+}
+
+void CompactSegment::unpack(const std::vector<Hit>& hitAll, PropSegment& seg) const
+{
+    seg.a = a;
+    seg.b = b;
+    seg.err_a = err_a;
+    seg.err_b = err_b;
+    seg.chisq = chisq;
+
+    for(int i = 0; i < 4; ++i)
+    {
+        if(hitIDs[i] >= 0)
+        {
+            seg.hits[i] = SignedHit(hitAll[hitIDs[i]], signs[i]);
+        }
+        else
+        {
+            seg.hits[i] = SignedHit();
+            seg.hits[i].hit.index = -1;
+        }
+    }
+
+    seg.nHodoHits = nHodoHits;
+    for(int i = 0; i < nHodoHits && i < 4; ++i) seg.hodoHits[i] = hitAll[hodoHitIDs[i]];
+}
+
+CompactTracklet::CompactTracklet(): stationID(-1), nXHits(0), nUHits(0), nVHits(0), chisq(9999.), chisq_vtx(9999.), nHits(0), tx(0.), ty(0.), x0(0.), y0(0.), invP(0.1), err_tx(-1.), err_ty(-1.), err_x0(-1.), err_y0(-1.), err_invP(-1.)
+{
+    TrackletGlobals::initGlobalVariables();
+}
+
+void CompactTracklet::addHit(int hitID, int detectorID, int sign)
+{
+    if(nHits >= MAXHITS) return;
+
+    hitIDs[nHits] = hitID;
+    detectorIDs[nHits] = detectorID;
+    signs[nHits] = sign;
+    residual[nHits] = 999.;
+    ++nHits;
+}
+
+void CompactTracklet::sortHits()
+{
+    //stable insertion sort by detectorID, the lists are short and mostly sorted already
+    for(int i = 1; i < nHits; ++i)
+    {
+        int hitID = hitIDs[i];
+        signed char detectorID = detectorIDs[i];
+        signed char sign = signs[i];
+        double res = residual[i];
+
+        int j = i - 1;
+        for(; j >= 0 && detectorIDs[j] > detectorID; --j)
+        {
+            hitIDs[j+1] = hitIDs[j];
+            detectorIDs[j+1] = detectorIDs[j];
+            signs[j+1] = signs[j];
+            residual[j+1] = residual[j];
+        }
+        hitIDs[j+1] = hitID;
+        detectorIDs[j+1] = detectorID;
+        signs[j+1] = sign;
+        residual[j+1] = res;
+    }
+}
+
+void CompactTracklet::addDummyHits()
+{
+    for(int detectorID = stationID*6 - 5; detectorID <= stationID*6; ++detectorID)
+    {
+        bool found = false;
+        for(int i = 0; i < nHits; ++i)
+        {
+            if(detectorIDs[i] == detectorID)
+            {
+                found = true;
+                break;
+            }
+        }
+        if(!found) addHit(-1, detectorID);
+    }
+
+    sortHits();
+}
+
+int CompactTracklet::isValid() const
+{
+    return TrackletFunc::isValid(*this, [this](int nRealHits[3][3]) {
+        for(int i = 0; i < nHits; ++i)
+        {
+            if(hitIDs[i] >= 0) TrackletFunc::countRealHit(*this, detectorIDs[i], nRealHits);
+        }
+    });
+}
+
+double CompactTracklet::getProb() const
+{
+    return TrackletFunc::getProb(*this);
+}
+
+double CompactTracklet::getExpPositionX(double z) const
+{
+    return TrackletFunc::getExpPositionX(*this, z);
+}
+
+double CompactTracklet::getExpPosErrorX(double z) const
+{
+    return TrackletFunc::getExpPosErrorX(*this, z);
+}
+
+double CompactTracklet::getExpPosErrorY(double z) const
+{
+    return TrackletFunc::getExpPosErrorY(*this, z);
+}
+
+double CompactTracklet::getMomentum() const
+{
+    return TrackletFunc::getMomentum(*this);
+}
+
+int CompactTracklet::getCharge() const
+{
+    return TrackletFunc::getCharge(*this);
+}
+
+void CompactTracklet::getXZInfoInSt1(double& tx_st1, double& x0_st1) const
+{
+    TrackletFunc::getXZInfoInSt1(*this, tx_st1, x0_st1);
+}
+
+void CompactTracklet::getXZErrorInSt1(double& err_tx_st1, double& err_x0_st1) const
+{
+    TrackletFunc::getXZErrorInSt1(*this, err_tx_st1, err_x0_st1);
+}
+
+double CompactTracklet::calcChisq(const std::vector<Hit>& hitAll)
+{
+    chisq = 0.;
+
+    double tx_st1, x0_st1;
+    TrackletFunc::getChisqParameters(*this, tx_st1, x0_st1);
+
+    for(int i = 0; i < nHits; ++i)
+    {
+        if(hitIDs[i] < 0) continue;
+
+        const Hit& hit = hitAll[hitIDs[i]];
+        chisq += TrackletFunc::hitChisq(*this, tx_st1, x0_st1, detectorIDs[i], hit.elementID, hit.driftDistance, signs[i], residual[i]);
+    }
+
+    return chisq;
+}
+
+bool CompactTracklet::operator<(const CompactTracklet& elem) const
+{
+    return TrackletFunc::lessThan(*this, elem);
+}
+
+bool CompactTracklet::similarity(const CompactTracklet& elem) const
+{
+    //both hit lists are sorted by detectorID, dummy and removed hits compare equal as in Tracklet
+    int nCommonHits = 0;
+    int first = 0;
+    int second = 0;
+    while(first < nHits && second < elem.nHits)
+    {
+        if(detectorIDs[first] < elem.detectorIDs[second])
+        {
+            ++first;
+        }
+        else if(elem.detectorIDs[second] < detectorIDs[first])
+        {
+            ++second;
+        }
+        else
+        {
+            if(hitIDs[first] == elem.hitIDs[second]) nCommonHits++;
+            ++first;
+            ++second;
+        }
+    }
+
+    return TrackletFunc::isSimilar(elem, nCommonHits);
+}
+
+CompactTracklet CompactTracklet::operator+(const CompactTracklet& elem) const
+{
+    CompactTracklet tracklet;
+    tracklet.stationID = nStations - 1;
+
+    tracklet.nXHits = nXHits + elem.nXHits;
+    tracklet.nUHits = nUHits + elem.nUHits;
+    tracklet.nVHits = nVHits + elem.nVHits;
+
+    const CompactTracklet& front = elem.stationID > stationID ? *this : elem;
+    const CompactTracklet& back  = elem.stationID > stationID ? elem : *this;
+    for(int i = 0; i < front.nHits; ++i) tracklet.addHit(front.hitIDs[i], front.detectorIDs[i], front.signs[i]);
+    for(int i = 0; i < back.nHits; ++i)  tracklet.addHit(back.hitIDs[i], back.detectorIDs[i], back.signs[i]);
+
+    TrackletFunc::setBackPartialParameters(*this, elem, tracklet);
+
+    return tracklet;
+}
+
+CompactTracklet CompactTracklet::operator*(const CompactTracklet& elem) const
+{
+    CompactTracklet tracklet;
+    tracklet.stationID = nStations;
+
+    tracklet.nXHits = nXHits + elem.nXHits;
+    tracklet.nUHits = nUHits + elem.nUHits;
+    tracklet.nVHits = nVHits + elem.nVHits;
+
+    const CompactTracklet& front = elem.stationID > stationID ? *this : elem;
+    const CompactTracklet& back  = elem.stationID > stationID ? elem : *this;
+    for(int i = 0; i < front.nHits; ++i) tracklet.addHit(front.hitIDs[i], front.detectorIDs[i], front.signs[i]);
+    for(int i = 0; i < back.nHits; ++i)  tracklet.addHit(back.hitIDs[i], back.detectorIDs[i], back.signs[i]);
+
+    TrackletFunc::setParametersFrom(elem.stationID == nStations - 1 ? elem : *this, tracklet);
+
+    return tracklet;
+}
+
+CompactTracklet CompactTracklet::merge(const CompactTracklet& elem) const
+{
+    CompactTracklet tracklet;
+    tracklet.stationID = stationID;
+    TrackletFunc::setParametersFrom(*this, tracklet);
+
+    tracklet.chisq_vtx = chisq_vtx < 999 ? chisq_vtx : elem.chisq_vtx;
+
+    tracklet.seg_x = seg_x;
+    tracklet.seg_y = seg_y;
+
+    //station-1 hits of the other candidate, then all hits of this one, stable-sorted by detectorID
+    //as the std::list::sort of Tracklet::merge, so both hits are kept in this order on a common plane
+    for(int i = 0; i < 6 && i < elem.nHits; ++i) tracklet.addHit(elem.hitIDs[i], elem.detectorIDs[i], elem.signs[i]);
+    for(int i = 0; i < nHits; ++i) tracklet.addHit(hitIDs[i], detectorIDs[i], signs[i]);
+    tracklet.sortHits();
+
+    //update the hit counts
+    tracklet.isValid();
+    return tracklet;
+}
+
+void CompactTracklet::fillTracklet(const std::vector<Hit>& hitAll, Tracklet& tracklet) const
+{
+    tracklet.stationID = stationID;
+    tracklet.nXHits = nXHits;
+    tracklet.nUHits = nUHits;
+    tracklet.nVHits = nVHits;
+    tracklet.chisq = chisq;
+    tracklet.chisq_vtx = chisq_vtx;
+
+    tracklet.hits.clear();
+    for(int i = 0; i < nHits; ++i)
+    {
+        if(hitIDs[i] >= 0)
+        {
+            tracklet.hits.push_back(SignedHit(hitAll[hitIDs[i]], signs[i]));
+        }
+        else
+        {
+            tracklet.hits.push_back(SignedHit(detectorIDs[i]));
+        }
+        tracklet.residual[detectorIDs[i]-1] = residual[i];
+    }
+
+    seg_x.unpack(hitAll, tracklet.seg_x);
+    seg_y.unpack(hitAll, tracklet.seg_y);
+
+    tracklet.tx = tx;
+    tracklet.ty = ty;
+    tracklet.x0 = x0;
+    tracklet.y0 = y0;
+    tracklet.invP = invP;
+
+    tracklet.err_tx = err_tx;
+    tracklet.err_ty = err_ty;
+    tracklet.err_x0 = err_x0;
+    tracklet.err_y0 = err_y0;
+    tracklet.err_invP = err_invP;
+}
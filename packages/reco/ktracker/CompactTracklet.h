@@ -0,0 +1,149 @@
+/*
+CompactTracklet.h
+
+Light-weight tracklet and prop. tube segment used internally by KalmanFastTracking.
+
+Hits are referred to by their position in the hit vector of the current SRawEvent
+(-1 for dummy or removed hits), so both classes are plain, trivially copyable values
+that can be kept in per-event vectors whose capacity is re-used event by event.
+The PHObject based Tracklet/PropSegment are only produced for the output lists.
+*/
+
+#ifndef _COMPACTTRACKLET_H
+#define _COMPACTTRACKLET_H
+
+#include <GlobalConsts.h>
+
+#include <vector>
+
+#include "SRawEvent.h"
+#include "FastTracklet.h"
+
+class CompactSegment
+{
+public:
+    CompactSegment();
+
+    //Copy the fit result of a PropSegment, hitIDs[i] is the hit vector index of seg.hits[i]
+    void pack(const PropSegment& seg, const int* hitIDs_seg);
+
+    //Re-create the full PropSegment
+    void unpack(const std::vector<Hit>& hitAll, PropSegment& seg) const;
+
+    int isValid() const { return valid ? 1 : 0; }
+    int getNHits() const { return nHits; }
+    int getNPlanes() const { return nPlanes; }
+    double getExpPosition(double z) const { return a*z + b; }
+
+    //track slope the interception
+    double a;
+    double b;
+    double err_a;
+    double err_b;
+    double chisq;
+
+    //hits on the four prop. tube planes
+    int hitIDs[4];
+    signed char signs[4];
+
+    //cached from PropSegment at pack() time
+    short nHits;
+    short nPlanes;
+    bool valid;
+
+    //Auxilary hodoscope hits
+    int nHodoHits;
+    int hodoHitIDs[4];
+};
+
+class CompactTracklet
+{
+public:
+    //3 stations x 6 planes for a global track, plus the station-1 hits of the other chamber after merge()
+    static const int MAXHITS = 24;
+
+    CompactTracklet();
+
+    //Hit list
+    void addHit(int hitID, int detectorID, int sign = 0);
+    void sortHits();
+    void addDummyHits();
+    int getNHits() const { return nXHits + nUHits + nVHits; }
+    int getNAllHits() const { return nHits; }
+
+    //Quality cut, shared with Tracklet::isValid() through TrackletFunc.h
+    int isValid() const;
+
+    double getProb() const;
+    double getChisq() const { return chisq; }
+
+    //Get x and y positions at a given z
+    double getExpPositionX(double z) const;
+    double getExpPosErrorX(double z) const;
+    double getExpPositionY(double z) const { return y0 + ty*z; }
+    double getExpPosErrorY(double z) const;
+
+    //Momentum estimation using back partial and charge from KMag bending direction
+    double getMomentum() const;
+    int getCharge() const;
+
+    //Get the slope and intersection in station 1
+    void getXZInfoInSt1(double& tx_st1, double& x0_st1) const;
+    void getXZErrorInSt1(double& err_tx_st1, double& err_x0_st1) const;
+
+    //Chi square and residuals with the current parameters
+    double calcChisq(const std::vector<Hit>& hitAll);
+
+    //For sorting tracklet list
+    bool operator<(const CompactTracklet& elem) const;
+
+    //For reducing similar tracklets
+    bool similarity(const CompactTracklet& elem) const;
+
+    //Combinations, same as Tracklet::operator+, operator* and merge, except that the chi square
+    //is not re-calculated since all callers re-fit the result right away
+    CompactTracklet operator+(const CompactTracklet& elem) const;
+    CompactTracklet operator*(const CompactTracklet& elem) const;
+    CompactTracklet merge(const CompactTracklet& elem) const;
+
+    //Produce the full Tracklet for output
+    void fillTracklet(const std::vector<Hit>& hitAll, Tracklet& tracklet) const;
+
+    //Station ID, ranging from 1 to nStation, nStation-1 means back partial track, nStation means global track
+    int stationID;
+
+    //Number of hits
+    mutable int nXHits;
+    mutable int nUHits;
+    mutable int nVHits;
+
+    //Chi square
+    double chisq;
+    double chisq_vtx;
+
+    //Hit list sorted by detectorID, hitID is the index in the hit vector (-1 for dummy/removed hits)
+    int nHits;
+    int hitIDs[MAXHITS];
+    signed char detectorIDs[MAXHITS];
+    signed char signs[MAXHITS];
+    double residual[MAXHITS];
+
+    //Corresponding prop. tube segments
+    CompactSegment seg_x;
+    CompactSegment seg_y;
+
+    //Slope, intersection, momentum and their errors
+    double tx;
+    double ty;
+    double x0;
+    double y0;
+    double invP;
+
+    double err_tx;
+    double err_ty;
+    double err_x0;
+    double err_y0;
+    double err_invP;
+};
+
+#endif
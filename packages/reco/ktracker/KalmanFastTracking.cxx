@@ -20,8 +20,11 @@ Created: 05-28-2013
 #include <TGraphErrors.h>
 #include <TBox.h>
 #include <TMatrixD.h>
+#include <TMath.h>
+#include <TVector3.h>
 
 #include "KalmanFastTracking.h"
+#include "TaskPool.h"
 #include "TriggerRoad.h"
 
 //#define _DEBUG_ON
@@ -31,6 +34,12 @@ namespace
     //static flag to indicate the initialized has been done
     static bool inited = false;
 
+    //Position of the lowest set bit of a non-zero element bitmap word
+    inline int lowestBit(uint64_t bits)
+    {
+        return __builtin_ctzll(bits);
+    }
+
     //Event acceptance cut
     static int MaxHitsDC0;
     static int MaxHitsDC1;
@@ -53,6 +62,7 @@ namespace
     static double Y0_MAX;
     static double INVP_MAX;
     static double INVP_MIN;
+    static double PROB_LOOSE;
     static double Z_KMAG_BEND;
 
     //MuID cuts 
@@ -101,6 +111,7 @@ namespace
             Y0_MAX = rc->get_DoubleFlag("Y0_MAX");
             INVP_MAX = rc->get_DoubleFlag("INVP_MAX");
             INVP_MIN = rc->get_DoubleFlag("INVP_MIN");
+            PROB_LOOSE = rc->get_DoubleFlag("PROB_LOOSE");
             Z_KMAG_BEND = rc->get_DoubleFlag("Z_KMAG_BEND");
 
             SAGITTA_TARGET_CENTER = rc->get_DoubleFlag("SAGITTA_TARGET_CENTER");
@@ -122,11 +133,13 @@ namespace
     }
 }
 
-KalmanFastTracking::KalmanFastTracking(const PHField* field, const TGeoManager* geom, bool flag): verbosity(0), enable_KF(flag), outputListIdx(4)
+KalmanFastTracking::KalmanFastTracking(const PHField* field, const TGeoManager* geom, bool flag): verbosity(0), outputListIdx(4), taskPool(nullptr), enable_KF(flag)
 {
     using namespace std;
     initGlobalVariables();
 
+    for(int i = 0; i < 5; ++i) trackletsOutFilled[i] = false;
+
 #ifdef _DEBUG_ON
     cout << "Initialization of KalmanFastTracking ..." << endl;
     cout << "========================================" << endl;
@@ -153,6 +166,8 @@ KalmanFastTracking::KalmanFastTracking(const PHField* field, const TGeoManager*
     minimizer[1] = ROOT::Math::Factory::CreateMinimizer("Minuit2", "Combined");
     fcn = ROOT::Math::Functor(&tracklet_curr, &Tracklet::Eval, KMAG_ON ? 5 : 4);
 
+    fitContexts.push_back(new FitContext(&hitAll));
+
     for(int i = 0; i < 2; ++i)
     {
         minimizer[i]->SetMaxFunctionCalls(1000000);
@@ -236,6 +251,13 @@ KalmanFastTracking::KalmanFastTracking(const PHField* field, const TGeoManager*
     z_ref_muid[1][2] = 0.5*(p_geomSvc->getPlanePosition(detectorIDs_muid[1][0]) + p_geomSvc->getPlanePosition(detectorIDs_muid[1][1]));
     z_ref_muid[1][3] = z_ref_muid[1][2];
 
+    //Element bitmaps start empty, setRawEvent only clears what it has set
+    for(int i = 0; i < nHodoPlanes+nPropPlanes; ++i)
+    {
+        for(int j = 0; j < nMaskWords; ++j) elementBits[i][j] = 0;
+        for(int j = 0; j < 72; ++j) firstHitInElement[i][j] = -1;
+    }
+
     //Initialize masking window sizes, with optimized contingency
     for(int i = nChamberPlanes+1; i <= nChamberPlanes+nHodoPlanes+nPropPlanes; i++)
     {
@@ -387,6 +409,34 @@ KalmanFastTracking::KalmanFastTracking(const PHField* field, const TGeoManager*
         spacing_plane[i] = p_geomSvc->getPlaneSpacing(i);
     }
 
+    //Linearized DCA to each wire for prefitTracklet. With the wire direction w projected on the x-y plane,
+    //the DCA of the track (tx, ty, 1) through (x0, y0, 0) is N/|n|, N being linear in the parameters and
+    //|n|^2 = |w|^2 + (tx*wy - ty*wx)^2 <= |w|^2*(1 + kappa^2) inside the slope limits. The small tilt of
+    //the wires out of the x-y plane is neglected.
+    for(int i = 1; i <= nChamberPlanes; i++)
+    {
+        double sigma = spacing_plane[i]/sqrt(12.);
+        wireRows[i].resize(p_geomSvc->getPlaneNElements(i) + 1);
+        for(int j = 1; j <= p_geomSvc->getPlaneNElements(i); ++j)
+        {
+            TVector3 ep1, ep2;
+            p_geomSvc->getEndPoints(i, j, ep1, ep2);
+
+            double wx = ep2.X() - ep1.X();
+            double wy = ep2.Y() - ep1.Y();
+            double w = sqrt(wx*wx + wy*wy);
+            double kappa = (TX_MAX*fabs(wy) + TY_MAX*fabs(wx))/w;
+            double f = 1./(w*sqrt(1. + kappa*kappa)*sigma);
+
+            WireRow& row = wireRows[i][j];
+            row.h[0] = f*ep1.Z()*wy;
+            row.h[1] = -f*ep1.Z()*wx;
+            row.h[2] = f*wy;
+            row.h[3] = -f*wx;
+            row.m = f*(ep1.X()*wy - ep1.Y()*wx);
+        }
+    }
+
 #ifdef _DEBUG_ON
     cout << "======================================" << endl;
     cout << "Maximum local slope and intersection: " << endl;
@@ -417,6 +467,25 @@ KalmanFastTracking::~KalmanFastTracking()
     if(enable_KF) delete kmfitter;
     delete minimizer[0];
     delete minimizer[1];
+
+    delete taskPool;
+    for(unsigned int i = 0; i < fitContexts.size(); ++i) delete fitContexts[i];
+}
+
+void KalmanFastTracking::setNThreads(unsigned int n)
+{
+    if(n < 1) n = 1;
+
+    delete taskPool;
+    taskPool = n > 1 ? new TaskPool(n) : nullptr;
+
+    //The minimizers are created here in the calling thread, the plugin manager is not thread-safe
+    while(fitContexts.size() < n) fitContexts.push_back(new FitContext(&hitAll));
+    while(fitContexts.size() > n)
+    {
+        delete fitContexts.back();
+        fitContexts.pop_back();
+    }
 }
 
 void KalmanFastTracking::setRawEventDebug(SRawEvent* event_input)
@@ -433,8 +502,13 @@ int KalmanFastTracking::setRawEvent(SRawEvent* event_input)
         iter->second->reset();
     }
 
-    //Initialize tracklet lists
-    for(int i = 0; i < 5; i++) trackletsInSt[i].clear();
+    //Initialize tracklet lists, the compact lists keep their storage for the next event
+    for(int i = 0; i < 5; i++)
+    {
+        trackletsInSt[i].clear();
+        trackletsOut[i].clear();
+        trackletsOutFilled[i] = false;
+    }
     stracks.clear();
 
     //pre-tracking cuts
@@ -445,35 +519,21 @@ int KalmanFastTracking::setRawEvent(SRawEvent* event_input)
     for(std::vector<Hit>::iterator iter = hitAll.begin(); iter != hitAll.end(); ++iter) iter->print();
 #endif
 
-    //Initialize hodo and masking IDs
+    //Initialize hodo masking planes
     for(int i = 0; i < 4; i++)
     {
-        //std::cout << "For station " << i << std::endl;
-        hitIDs_mask[i].clear();
         if(MC_MODE || COSMIC_MODE || rawEvent->isFPGATriggered())
         {
-            hitIDs_mask[i] = rawEvent->getHitsIndexInDetectors(detectorIDs_maskX[i]);
+            planes_mask[i] = &detectorIDs_maskX[i];
         }
         else
         {
-            hitIDs_mask[i] = rawEvent->getHitsIndexInDetectors(detectorIDs_maskY[i]);
+            planes_mask[i] = &detectorIDs_maskY[i];
         }
-
-        //for(std::list<int>::iterator iter = hitIDs_mask[i].begin(); iter != hitIDs_mask[i].end(); ++iter) std::cout << *iter << " " << hitAll[*iter].detectorID << " === ";
-        //std::cout << std::endl;
     }
 
-    //Initialize prop. tube IDs
-    for(int i = 0; i < 2; ++i)
-    {
-        for(int j = 0; j < 4; ++j)
-        {
-            hitIDs_muid[i][j].clear();
-            hitIDs_muid[i][j] = rawEvent->getHitsIndexInDetector(detectorIDs_muid[i][j]);
-        }
-        hitIDs_muidHodoAid[i].clear();
-        hitIDs_muidHodoAid[i] = rawEvent->getHitsIndexInDetectors(detectorIDs_muidHodoAid[i]);
-    }
+    //Hodo. and prop. tube hits to element bitmaps
+    fillElementBitmaps();
 
     if(!COARSE_MODE)
     {
@@ -541,9 +601,11 @@ int KalmanFastTracking::setRawEvent(SRawEvent* event_input)
     {
         std::cout << "=======================================================================================" << std::endl;
         LogInfo("Prop tube segments in " << (i == 0 ? "X-Z" : "Y-Z"));
-        for(std::list<PropSegment>::iterator seg = propSegs[i].begin(); seg != propSegs[i].end(); ++seg)
+        for(std::vector<CompactSegment>::iterator seg = propSegs[i].begin(); seg != propSegs[i].end(); ++seg)
         {
-            seg->print();
+            PropSegment seg_print;
+            seg->unpack(hitAll, seg_print);
+            seg_print.print();
         }
         std::cout << "=======================================================================================" << std::endl;
     }
@@ -552,7 +614,8 @@ int KalmanFastTracking::setRawEvent(SRawEvent* event_input)
     {
         std::cout << "=======================================================================================" << std::endl;
         LogInfo("Final tracklets in station: " << i+1 << " is " << trackletsInSt[i].size());
-        for(std::list<Tracklet>::iterator tracklet = trackletsInSt[i].begin(); tracklet != trackletsInSt[i].end(); ++tracklet)
+        std::list<Tracklet>& tracklets = getTrackletList(i);
+        for(std::list<Tracklet>::iterator tracklet = tracklets.begin(); tracklet != tracklets.end(); ++tracklet)
         {
             tracklet->print();
         }
@@ -565,7 +628,8 @@ int KalmanFastTracking::setRawEvent(SRawEvent* event_input)
 
     //Build kalman tracks
     _timers["kalman"]->restart();
-    for(std::list<Tracklet>::iterator tracklet = trackletsInSt[outputListIdx].begin(); tracklet != trackletsInSt[outputListIdx].end(); ++tracklet)
+    std::list<Tracklet>& tracklets_out = getTrackletList(outputListIdx);
+    for(std::list<Tracklet>::iterator tracklet = tracklets_out.begin(); tracklet != tracklets_out.end(); ++tracklet)
     {
         SRecTrack strack = processOneTracklet(*tracklet);
         stracks.push_back(strack);
@@ -628,26 +692,26 @@ void KalmanFastTracking::buildBackPartialTracks()
     double z_fit[4], x_fit[4];
     double a, b;
 
-    for(std::list<Tracklet>::iterator tracklet3 = trackletsInSt[2].begin(); tracklet3 != trackletsInSt[2].end(); ++tracklet3)
+    for(std::vector<CompactTracklet>::iterator tracklet3 = trackletsInSt[2].begin(); tracklet3 != trackletsInSt[2].end(); ++tracklet3)
     {
         if(!COARSE_MODE)
         {
             //Extract the X hits only from station-3 tracks
             nHitsX3 = 0;
-            for(std::list<SignedHit>::iterator ptr_hit = tracklet3->hits.begin(); ptr_hit != tracklet3->hits.end(); ++ptr_hit)
+            for(int i = 0; i < tracklet3->nHits; ++i)
             {
-                if(ptr_hit->hit.index < 0) continue;
-                if(p_geomSvc->getPlaneType(ptr_hit->hit.detectorID) == 1)
+                if(tracklet3->hitIDs[i] < 0) continue;
+                if(p_geomSvc->getPlaneType(tracklet3->detectorIDs[i]) == 1)
                 {
-                    z_fit[nHitsX3] = z_plane[ptr_hit->hit.detectorID];
-                    x_fit[nHitsX3] = ptr_hit->hit.pos;
+                    z_fit[nHitsX3] = z_plane[tracklet3->detectorIDs[i]];
+                    x_fit[nHitsX3] = hitAll[tracklet3->hitIDs[i]].pos;
                     ++nHitsX3;
                 }
             }
         }
 
-        Tracklet tracklet_best;
-        for(std::list<Tracklet>::iterator tracklet2 = trackletsInSt[1].begin(); tracklet2 != trackletsInSt[1].end(); ++tracklet2)
+        CompactTracklet tracklet_best;
+        for(std::vector<CompactTracklet>::iterator tracklet2 = trackletsInSt[1].begin(); tracklet2 != trackletsInSt[1].end(); ++tracklet2)
         {
             if(!COARSE_MODE)
             {
@@ -655,13 +719,13 @@ void KalmanFastTracking::buildBackPartialTracks()
 
                 //Extract the X hits from station-2 tracke
                 nHitsX2 = nHitsX3;
-                for(std::list<SignedHit>::iterator ptr_hit = tracklet2->hits.begin(); ptr_hit != tracklet2->hits.end(); ++ptr_hit)
+                for(int i = 0; i < tracklet2->nHits; ++i)
                 {
-                    if(ptr_hit->hit.index < 0) continue;
-                    if(p_geomSvc->getPlaneType(ptr_hit->hit.detectorID) == 1)
+                    if(tracklet2->hitIDs[i] < 0) continue;
+                    if(p_geomSvc->getPlaneType(tracklet2->detectorIDs[i]) == 1)
                     {
-                        z_fit[nHitsX2] = z_plane[ptr_hit->hit.detectorID];
-                        x_fit[nHitsX2] = ptr_hit->hit.pos;
+                        z_fit[nHitsX2] = z_plane[tracklet2->detectorIDs[i]];
+                        x_fit[nHitsX2] = hitAll[tracklet2->hitIDs[i]].pos;
                         ++nHitsX2;
                     }
                 }
@@ -674,13 +738,17 @@ void KalmanFastTracking::buildBackPartialTracks()
                 int nPropHits = 0;
                 for(int i = 0; i < 4; ++i)
                 {
-                    double x_exp = a*z_mask[detectorIDs_muid[0][i] - nChamberPlanes - 1] + b;
-                    for(std::list<int>::iterator iter = hitIDs_muid[0][i].begin(); iter != hitIDs_muid[0][i].end(); ++iter)
+                    int idx1 = detectorIDs_muid[0][i] - nChamberPlanes - 1;
+                    double x_exp = a*z_mask[idx1] + b;
+                    for(int j = 0; j < nMaskWords && nPropHits == 0; ++j)
                     {
-                        if(fabs(hitAll[*iter].pos - x_exp) < 5.08)
+                        for(uint64_t bits = elementBits[idx1][j]; bits != 0; bits &= bits - 1)
                         {
-                            ++nPropHits;
-                            break;
+                            if(fabs(hitAll[firstHitInElement[idx1][64*j + lowestBit(bits)]].pos - x_exp) < 5.08)
+                            {
+                                ++nPropHits;
+                                break;
+                            }
                         }
                     }
                     if(nPropHits > 0) break;
@@ -688,19 +756,19 @@ void KalmanFastTracking::buildBackPartialTracks()
                 if(nPropHits == 0) continue;
             }
 
-            Tracklet tracklet_23 = (*tracklet2) + (*tracklet3);
+            CompactTracklet tracklet_23 = (*tracklet2) + (*tracklet3);
 #ifdef _DEBUG_ON
             LogInfo("Using following two tracklets:");
-            tracklet2->print();
-            tracklet3->print();
+            printTracklet(*tracklet2);
+            printTracklet(*tracklet3);
             LogInfo("Yield this combination:");
-            tracklet_23.print();
+            printTracklet(tracklet_23);
 #endif
             fitTracklet(tracklet_23);
             if(tracklet_23.chisq > 9000.)
             {
 #ifdef _DEBUG_ON
-                tracklet_23.print();
+                printTracklet(tracklet_23);
                 LogInfo("Impossible combination!");
 #endif
                 continue;
@@ -728,10 +796,10 @@ void KalmanFastTracking::buildBackPartialTracks()
 
 #ifdef _DEBUG_ON
             LogInfo("New tracklet: ");
-            tracklet_23.print();
+            printTracklet(tracklet_23);
 
             LogInfo("Current best:");
-            tracklet_best.print();
+            printTracklet(tracklet_best);
 
             LogInfo("Comparison: " << (tracklet_23 < tracklet_best));
             LogInfo("Quality: " << acceptTracklet(tracklet_23));
@@ -754,102 +822,57 @@ void KalmanFastTracking::buildBackPartialTracks()
     }
 
     reduceTrackletList(trackletsInSt[3]);
-    trackletsInSt[3].sort();
 }
 
 void KalmanFastTracking::buildGlobalTracks()
 {
-    double pos_exp[3], window[3];
-    for(std::list<Tracklet>::iterator tracklet23 = trackletsInSt[3].begin(); tracklet23 != trackletsInSt[3].end(); ++tracklet23)
+    //Each (back partial, station-1 chamber) pair is linked independently, possibly in parallel.
+    //The results are kept per pair and reduced below in the order of the back partials,
+    //so the global track list does not depend on the number of threads
+    unsigned int nLinks = 2*trackletsInSt[3].size();
+    if(st1Links.size() < nLinks) st1Links.resize(nLinks);
+
+    if(taskPool != nullptr)
+    {
+        taskPool->run(nLinks, [this](unsigned int idx, unsigned int) { linkStation1(trackletsInSt[3][idx/2], idx%2 + 1, st1Links[idx]); });
+    }
+    else
     {
-        Tracklet tracklet_best[2];
+        for(unsigned int idx = 0; idx < nLinks; ++idx) linkStation1(trackletsInSt[3][idx/2], idx%2 + 1, st1Links[idx]);
+    }
+
+    for(unsigned int idx23 = 0; idx23 < trackletsInSt[3].size(); ++idx23)
+    {
+        CompactTracklet tracklet_best[2];
         for(int i = 0; i < 2; ++i) //for two station-1 chambers
         {
-            trackletsInSt[0].clear();
-
-            //Calculate the window in station 1
-            if(KMAG_ON)
-            {
-                getSagittaWindowsInSt1(*tracklet23, pos_exp, window, i+1);
-            }
-            else
-            {
-                getExtrapoWindowsInSt1(*tracklet23, pos_exp, window, i+1);
-            }
-
-#ifdef _DEBUG_ON
-            LogInfo("Using this back partial: ");
-            tracklet23->print();
-            for(int j = 0; j < 3; j++) LogInfo("Extrapo: " << pos_exp[j] << "  " << window[j]);
-#endif
+            St1Link& link = st1Links[2*idx23 + i];
+            CompactTracklet& tracklet_best_prob = link.best_prob;
 
-            _timers["global_st1"]->restart();
-            buildTrackletsInStation(i+1, 0, pos_exp, window);
-            _timers["global_st1"]->stop();
-
-            _timers["global_link"]->restart();
-            Tracklet tracklet_best_prob, tracklet_best_vtx;
-            for(std::list<Tracklet>::iterator tracklet1 = trackletsInSt[0].begin(); tracklet1 != trackletsInSt[0].end(); ++tracklet1)
+            ///Set vertex information - only applied when KF is enabled, the Kalman fitter is not thread-safe
+            ///TODO: maybe in the future add a Genfit-based equivalent here, for now leave as is
+            CompactTracklet tracklet_best_vtx;
+            if(enable_KF)
             {
-#ifdef _DEBUG_ON
-                LogInfo("With this station 1 track:");
-                tracklet1->print();
-#endif
-
-                Tracklet tracklet_global = (*tracklet23) * (*tracklet1);
-                fitTracklet(tracklet_global);
-                if(!hodoMask(tracklet_global)) continue;
-
-                ///Resolve the left-right with a tight pull cut, then a loose one, then resolve by single projections
-                if(!COARSE_MODE)
-                {
-                    resolveLeftRight(tracklet_global, 75.);
-                    resolveLeftRight(tracklet_global, 150.);
-                    resolveSingleLeftRight(tracklet_global);
-                }
-
-                ///Remove bad hits if needed
-                removeBadHits(tracklet_global);
-
-                //Most basic cuts
-                if(!acceptTracklet(tracklet_global)) continue;
-
-                //Get the tracklets that has the best prob
-                if(tracklet_global < tracklet_best_prob) tracklet_best_prob = tracklet_global;
-
-                ///Set vertex information - only applied when KF is enabled
-                ///TODO: maybe in the future add a Genfit-based equivalent here, for now leave as is
-                if(enable_KF)
+                _timers["global_kalman"]->restart();
+                for(std::vector<CompactTracklet>::iterator tracklet_global = link.accepted.begin(); tracklet_global != link.accepted.end(); ++tracklet_global)
                 {
-                    _timers["global_kalman"]->restart();
-                    SRecTrack recTrack = processOneTracklet(tracklet_global);
-                    _timers["global_kalman"]->stop();
-                    tracklet_global.chisq_vtx = recTrack.getChisqVertex();
+                    Tracklet tracklet_kalman;
+                    tracklet_global->fillTracklet(hitAll, tracklet_kalman);
+                    SRecTrack recTrack = processOneTracklet(tracklet_kalman);
+                    tracklet_global->chisq_vtx = recTrack.getChisqVertex();
 
-                    if(recTrack.isValid() && tracklet_global.chisq_vtx < tracklet_best_vtx.chisq_vtx) tracklet_best_vtx = tracklet_global;
-                }
+                    if(recTrack.isValid() && tracklet_global->chisq_vtx < tracklet_best_vtx.chisq_vtx) tracklet_best_vtx = *tracklet_global;
 
 #ifdef _DEBUG_ON
-                LogInfo("New tracklet: ");
-                tracklet_global.print();
-
-                LogInfo("Current best by prob:");
-                tracklet_best_prob.print();
-
-                LogInfo("Comparison I: " << (tracklet_global < tracklet_best_prob));
-                LogInfo("Quality I   : " << acceptTracklet(tracklet_global));
-
-                if(enable_KF)
-                {
                     LogInfo("Current best by vtx:");
-                    tracklet_best_vtx.print();
+                    printTracklet(tracklet_best_vtx);
 
-                    LogInfo("Comparison II: " << (tracklet_global.chisq_vtx < tracklet_best_vtx.chisq_vtx));
-                    //LogInfo("Quality II   : " << recTrack.isValid());
-                }
+                    LogInfo("Comparison II: " << (tracklet_global->chisq_vtx < tracklet_best_vtx.chisq_vtx));
 #endif
+                }
+                _timers["global_kalman"]->stop();
             }
-            _timers["global_link"]->stop();
 
             //The selection logic is, prefer the tracks with best p-value, as long as it's not low-pz
             if(enable_KF && tracklet_best_prob.isValid() > 0 && 1./tracklet_best_prob.invP > 18.)
@@ -867,7 +890,7 @@ void KalmanFastTracking::buildGlobalTracks()
         }
 
         //Merge the tracklets from two stations if necessary
-        Tracklet tracklet_merge;
+        CompactTracklet tracklet_merge;
         if(fabs(tracklet_best[0].getMomentum() - tracklet_best[1].getMomentum())/tracklet_best[0].getMomentum() < MERGE_THRES)
         {
             //Merge the track and re-fit
@@ -876,9 +899,9 @@ void KalmanFastTracking::buildGlobalTracks()
 
 #ifdef _DEBUG_ON
             LogInfo("Merging two track candidates with momentum: " << tracklet_best[0].getMomentum() << "  " << tracklet_best[1].getMomentum());
-            LogInfo("tracklet_best_1:"); tracklet_best[0].print();
-            LogInfo("tracklet_best_2:"); tracklet_best[1].print();
-            LogInfo("tracklet_merge:"); tracklet_merge.print();
+            LogInfo("tracklet_best_1:"); printTracklet(tracklet_best[0]);
+            LogInfo("tracklet_best_2:"); printTracklet(tracklet_best[1]);
+            LogInfo("tracklet_merge:"); printTracklet(tracklet_merge);
 #endif
         }
 
@@ -905,14 +928,93 @@ void KalmanFastTracking::buildGlobalTracks()
         }
     }
 
-    trackletsInSt[4].sort();
+    std::stable_sort(trackletsInSt[4].begin(), trackletsInSt[4].end());
+
+    //Keep the station-1 tracklets of the last link in list 0, as in the serial implementation
+    if(nLinks > 0) trackletsInSt[0].swap(st1Links[nLinks-1].trackletsInSt1);
 }
 
-void KalmanFastTracking::resolveLeftRight(Tracklet& tracklet, double threshold)
+void KalmanFastTracking::linkStation1(const CompactTracklet& tracklet23, int st1ID, St1Link& link)
+{
+    //The timers are not shared between threads
+    bool timed = taskPool == nullptr;
+
+    link.trackletsInSt1.clear();
+    link.accepted.clear();
+    link.best_prob = CompactTracklet();
+
+    //Calculate the window in station 1
+    double pos_exp[3], window[3];
+    if(KMAG_ON)
+    {
+        getSagittaWindowsInSt1(tracklet23, pos_exp, window, st1ID);
+    }
+    else
+    {
+        getExtrapoWindowsInSt1(tracklet23, pos_exp, window, st1ID);
+    }
+
+#ifdef _DEBUG_ON
+    LogInfo("Using this back partial: ");
+    printTracklet(tracklet23);
+    for(int j = 0; j < 3; j++) LogInfo("Extrapo: " << pos_exp[j] << "  " << window[j]);
+#endif
+
+    if(timed) _timers["global_st1"]->restart();
+    buildTrackletsInStation(st1ID, link.trackletsInSt1, pos_exp, window);
+    if(timed) _timers["global_st1"]->stop();
+
+    if(timed) _timers["global_link"]->restart();
+    for(std::vector<CompactTracklet>::iterator tracklet1 = link.trackletsInSt1.begin(); tracklet1 != link.trackletsInSt1.end(); ++tracklet1)
+    {
+#ifdef _DEBUG_ON
+        LogInfo("With this station 1 track:");
+        printTracklet(*tracklet1);
+#endif
+
+        CompactTracklet tracklet_global = tracklet23 * (*tracklet1);
+        fitTracklet(tracklet_global);
+        if(!hodoMask(tracklet_global)) continue;
+
+        ///Resolve the left-right with a tight pull cut, then a loose one, then resolve by single projections
+        if(!COARSE_MODE)
+        {
+            resolveLeftRight(tracklet_global, 75.);
+            resolveLeftRight(tracklet_global, 150.);
+            resolveSingleLeftRight(tracklet_global);
+        }
+
+        ///Remove bad hits if needed
+        removeBadHits(tracklet_global);
+
+        //Most basic cuts
+        if(!acceptTracklet(tracklet_global)) continue;
+
+        //Get the tracklets that has the best prob
+        if(tracklet_global < link.best_prob) link.best_prob = tracklet_global;
+
+        //The vertex is evaluated by buildGlobalTracks in the calling thread
+        if(enable_KF) link.accepted.push_back(tracklet_global);
+
+#ifdef _DEBUG_ON
+        LogInfo("New tracklet: ");
+        printTracklet(tracklet_global);
+
+        LogInfo("Current best by prob:");
+        printTracklet(link.best_prob);
+
+        LogInfo("Comparison I: " << (tracklet_global < link.best_prob));
+        LogInfo("Quality I   : " << acceptTracklet(tracklet_global));
+#endif
+    }
+    if(timed) _timers["global_link"]->stop();
+}
+
+void KalmanFastTracking::resolveLeftRight(CompactTracklet& tracklet, double threshold)
 {
 #ifdef _DEBUG_ON
     LogInfo("Left right for this track..");
-    tracklet.print();
+    printTracklet(tracklet);
 #endif
 
     //Check if the track has been updated
@@ -922,36 +1024,38 @@ void KalmanFastTracking::resolveLeftRight(Tracklet& tracklet, double threshold)
     int possibility[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
 
     //Total number of hit pairs in this tracklet
-    int nPairs = tracklet.hits.size()/2;
+    int nPairs = tracklet.nHits/2;
 
     int nResolved = 0;
-    std::list<SignedHit>::iterator hit1 = tracklet.hits.begin();
-    std::list<SignedHit>::iterator hit2 = tracklet.hits.begin();
-    ++hit2;
+    int hit1 = 0;
+    int hit2 = 1;
     while(true)
     {
+        int detectorID1 = tracklet.detectorIDs[hit1];
+        int detectorID2 = tracklet.detectorIDs[hit2];
 #ifdef _DEBUG_ON
-        LogInfo(hit1->hit.index << "  " << hit2->sign << " === " << hit2->hit.index << "  " << hit2->sign);
-        int detectorID1 = hit1->hit.detectorID;
-        int detectorID2 = hit2->hit.detectorID;
-        LogInfo("Hit1: " << tracklet.getExpPositionX(z_plane[detectorID1])*costheta_plane[detectorID1] + tracklet.getExpPositionY(z_plane[detectorID1])*sintheta_plane[detectorID1] << "  " << hit1->hit.pos + hit1->hit.driftDistance << "  " << hit1->hit.pos - hit1->hit.driftDistance);
-        LogInfo("Hit2: " << tracklet.getExpPositionX(z_plane[detectorID2])*costheta_plane[detectorID2] + tracklet.getExpPositionY(z_plane[detectorID2])*sintheta_plane[detectorID2] << "  " << hit2->hit.pos + hit2->hit.driftDistance << "  " << hit2->hit.pos - hit2->hit.driftDistance);
+        LogInfo(tracklet.hitIDs[hit1] << "  " << int(tracklet.signs[hit2]) << " === " << tracklet.hitIDs[hit2] << "  " << int(tracklet.signs[hit2]));
 #endif
 
-        if(hit1->hit.index > 0 && hit2->hit.index > 0 && hit1->sign*hit2->sign == 0)
+        if(tracklet.hitIDs[hit1] >= 0 && tracklet.hitIDs[hit2] >= 0 && hitAll[tracklet.hitIDs[hit1]].index > 0 && hitAll[tracklet.hitIDs[hit2]].index > 0 && tracklet.signs[hit1]*tracklet.signs[hit2] == 0)
         {
+            const Hit& h1 = hitAll[tracklet.hitIDs[hit1]];
+            const Hit& h2 = hitAll[tracklet.hitIDs[hit2]];
+
             int index_min = -1;
             double pull_min = 1E6;
             for(int i = 0; i < 4; i++)
             {
-                double slope_local = (hit1->pos(possibility[i][0]) - hit2->pos(possibility[i][1]))/(z_plane[hit1->hit.detectorID] - z_plane[hit2->hit.detectorID]);
-                double inter_local = hit1->pos(possibility[i][0]) - slope_local*z_plane[hit1->hit.detectorID];
+                double pos1 = h1.pos + possibility[i][0]*h1.driftDistance;
+                double pos2 = h2.pos + possibility[i][1]*h2.driftDistance;
+                double slope_local = (pos1 - pos2)/(z_plane[detectorID1] - z_plane[detectorID2]);
+                double inter_local = pos1 - slope_local*z_plane[detectorID1];
 
-                if(fabs(slope_local) > slope_max[hit1->hit.detectorID] || fabs(inter_local) > intersection_max[hit1->hit.detectorID]) continue;
+                if(fabs(slope_local) > slope_max[detectorID1] || fabs(inter_local) > intersection_max[detectorID1]) continue;
 
                 double tx, ty, x0, y0;
                 double err_tx, err_ty, err_x0, err_y0;
-                if(tracklet.stationID == 6 && hit1->hit.detectorID <= 6)
+                if(tracklet.stationID == 6 && detectorID1 <= 6)
                 {
                     tracklet.getXZInfoInSt1(tx, x0);
                     tracklet.getXZErrorInSt1(err_tx, err_x0);
@@ -968,10 +1072,10 @@ void KalmanFastTracking::resolveLeftRight(Tracklet& tracklet, double threshold)
                 err_ty = tracklet.err_ty;
                 err_y0 = tracklet.err_y0;
 
-                double slope_exp = costheta_plane[hit1->hit.detectorID]*tx + sintheta_plane[hit1->hit.detectorID]*ty;
-                double err_slope = fabs(costheta_plane[hit1->hit.detectorID]*err_tx) + fabs(sintheta_plane[hit2->hit.detectorID]*err_ty);
-                double inter_exp = costheta_plane[hit1->hit.detectorID]*x0 + sintheta_plane[hit1->hit.detectorID]*y0;
-                double err_inter = fabs(costheta_plane[hit1->hit.detectorID]*err_x0) + fabs(sintheta_plane[hit2->hit.detectorID]*err_y0);
+                double slope_exp = costheta_plane[detectorID1]*tx + sintheta_plane[detectorID1]*ty;
+                double err_slope = fabs(costheta_plane[detectorID1]*err_tx) + fabs(sintheta_plane[detectorID2]*err_ty);
+                double inter_exp = costheta_plane[detectorID1]*x0 + sintheta_plane[detectorID1]*y0;
+                double err_inter = fabs(costheta_plane[detectorID1]*err_x0) + fabs(sintheta_plane[detectorID2]*err_y0);
 
                 double pull = sqrt((slope_exp - slope_local)*(slope_exp - slope_local)/err_slope/err_slope + (inter_exp - inter_local)*(inter_exp - inter_local)/err_inter/err_inter);
                 if(pull < pull_min)
@@ -981,7 +1085,7 @@ void KalmanFastTracking::resolveLeftRight(Tracklet& tracklet, double threshold)
                 }
 
 #ifdef _DEBUG_ON
-                LogInfo(hit1->hit.detectorID << ": " << i << "  " << possibility[i][0] << "  " << possibility[i][1]);
+                LogInfo(detectorID1 << ": " << i << "  " << possibility[i][0] << "  " << possibility[i][1]);
                 LogInfo(tx << "  " << x0 << "  " << ty << "  " << y0);
                 LogInfo("Slope: " << slope_local << "  " << slope_exp << "  " << err_slope);
                 LogInfo("Intersection: " << inter_local << "  " << inter_exp << "  " << err_inter);
@@ -989,11 +1093,10 @@ void KalmanFastTracking::resolveLeftRight(Tracklet& tracklet, double threshold)
 #endif
             }
 
-            //LogInfo("Final: " << index_min << "  " << pull_min);
-            if(index_min >= 0 && pull_min < threshold)//((tracklet.stationID == 5 && pull_min < 25.) || (tracklet.stationID == 6 && pull_min < 100.)))
+            if(index_min >= 0 && pull_min < threshold)
             {
-                hit1->sign = possibility[index_min][0];
-                hit2->sign = possibility[index_min][1];
+                tracklet.signs[hit1] = possibility[index_min][0];
+                tracklet.signs[hit2] = possibility[index_min][1];
                 isUpdated = true;
             }
         }
@@ -1001,31 +1104,29 @@ void KalmanFastTracking::resolveLeftRight(Tracklet& tracklet, double threshold)
         ++nResolved;
         if(nResolved >= nPairs) break;
 
-        ++hit1;
-        ++hit1;
-        ++hit2;
-        ++hit2;
+        hit1 += 2;
+        hit2 += 2;
     }
 
     if(isUpdated) fitTracklet(tracklet);
 }
 
-void KalmanFastTracking::resolveSingleLeftRight(Tracklet& tracklet)
+void KalmanFastTracking::resolveSingleLeftRight(CompactTracklet& tracklet)
 {
 #ifdef _DEBUG_ON
     LogInfo("Single left right for this track..");
-    tracklet.print();
+    printTracklet(tracklet);
 #endif
 
     //Check if the track has been updated
     bool isUpdated = false;
-    for(std::list<SignedHit>::iterator hit_sign = tracklet.hits.begin(); hit_sign != tracklet.hits.end(); ++hit_sign)
+    for(int i = 0; i < tracklet.nHits; ++i)
     {
-        if(hit_sign->hit.index < 0 || hit_sign->sign != 0) continue;
+        if(tracklet.hitIDs[i] < 0 || tracklet.signs[i] != 0) continue;
 
-        int detectorID = hit_sign->hit.detectorID;
+        int detectorID = tracklet.detectorIDs[i];
         double pos_exp = tracklet.getExpPositionX(z_plane[detectorID])*costheta_plane[detectorID] + tracklet.getExpPositionY(z_plane[detectorID])*sintheta_plane[detectorID];
-        hit_sign->sign = pos_exp > hit_sign->hit.pos ? 1 : -1;
+        tracklet.signs[i] = pos_exp > hitAll[tracklet.hitIDs[i]].pos ? 1 : -1;
 
         isUpdated = true;
     }
@@ -1033,12 +1134,12 @@ void KalmanFastTracking::resolveSingleLeftRight(Tracklet& tracklet)
     if(isUpdated) fitTracklet(tracklet);
 }
 
-void KalmanFastTracking::removeBadHits(Tracklet& tracklet)
+void KalmanFastTracking::removeBadHits(CompactTracklet& tracklet)
 {
 #ifdef _DEBUG_ON
     LogInfo("Removing hits for this track..");
-    tracklet.calcChisq();
-    tracklet.print();
+    tracklet.calcChisq(hitAll);
+    printTracklet(tracklet);
 #endif
 
     //Check if the track has beed updated
@@ -1049,46 +1150,44 @@ void KalmanFastTracking::removeBadHits(Tracklet& tracklet)
     while(isUpdated)
     {
         isUpdated = false;
-        tracklet.calcChisq();
+        tracklet.calcChisq(hitAll);
 
-        SignedHit* hit_remove = nullptr;
-        SignedHit* hit_neighbour = nullptr;
+        int hit_remove = -1;
+        int hit_neighbour = -1;
         double res_remove1 = -1.;
         double res_remove2 = -1.;
-        for(std::list<SignedHit>::iterator hit_sign = tracklet.hits.begin(); hit_sign != tracklet.hits.end(); ++hit_sign)
+        for(int i = 0; i < tracklet.nHits; ++i)
         {
-            if(hit_sign->hit.index < 0) continue;
+            if(tracklet.hitIDs[i] < 0) continue;
 
-            int detectorID = hit_sign->hit.detectorID;
-            double res_curr = fabs(tracklet.residual[detectorID-1]);
+            int detectorID = tracklet.detectorIDs[i];
+            double res_curr = fabs(tracklet.residual[i]);
             if(res_remove1 < res_curr)
             {
                 res_remove1 = res_curr;
-                res_remove2 = fabs(tracklet.residual[detectorID-1] - 2.*hit_sign->sign*hit_sign->hit.driftDistance);
-                hit_remove = &(*hit_sign);
-
-                std::list<SignedHit>::iterator iter = hit_sign;
-                hit_neighbour = detectorID % 2 == 0 ? &(*(--iter)) : &(*(++iter));
+                res_remove2 = fabs(tracklet.residual[i] - 2.*tracklet.signs[i]*hitAll[tracklet.hitIDs[i]].driftDistance);
+                hit_remove = i;
+                hit_neighbour = detectorID % 2 == 0 ? i - 1 : i + 1;
             }
         }
-        if(hit_remove == nullptr) continue;
-        if(hit_remove->sign == 0 && tracklet.isValid() > 0) continue;  //if sign is undecided, and chisq is OKay, then pass
+        if(hit_remove < 0) continue;
+        if(tracklet.signs[hit_remove] == 0 && tracklet.isValid() > 0) continue;  //if sign is undecided, and chisq is OKay, then pass
 
-        double cut = hit_remove->sign == 0 ? hit_remove->hit.driftDistance + resol_plane[hit_remove->hit.detectorID] : resol_plane[hit_remove->hit.detectorID];
+        int detectorID_remove = tracklet.detectorIDs[hit_remove];
+        double cut = tracklet.signs[hit_remove] == 0 ? hitAll[tracklet.hitIDs[hit_remove]].driftDistance + resol_plane[detectorID_remove] : resol_plane[detectorID_remove];
         if(res_remove1 > cut)
         {
 #ifdef _DEBUG_ON
-            LogInfo("Dropping this hit: " << res_remove1 << "  " << res_remove2 << "   " << signflipflag[hit_remove->hit.detectorID-1] << "  " << cut);
-            hit_remove->hit.print();
-            hit_neighbour->hit.print();
+            LogInfo("Dropping this hit: " << res_remove1 << "  " << res_remove2 << "   " << signflipflag[detectorID_remove-1] << "  " << cut);
+            hitAll[tracklet.hitIDs[hit_remove]].print();
 #endif
 
             //can only be changed less than twice
-            if(res_remove2 < cut && signflipflag[hit_remove->hit.detectorID-1] < 2)
+            if(res_remove2 < cut && signflipflag[detectorID_remove-1] < 2)
             {
-                hit_remove->sign = -hit_remove->sign;
-                hit_neighbour->sign = 0;
-                ++signflipflag[hit_remove->hit.detectorID-1];
+                tracklet.signs[hit_remove] = -tracklet.signs[hit_remove];
+                tracklet.signs[hit_neighbour] = 0;
+                ++signflipflag[detectorID_remove-1];
 #ifdef _DEBUG_ON
                 LogInfo("Only changing the sign.");
 #endif
@@ -1097,9 +1196,9 @@ void KalmanFastTracking::removeBadHits(Tracklet& tracklet)
             {
                 //Set the index of the hit to be removed to -1 so it's not used anymore
                 //also set the sign assignment of the neighbour hit to 0 (i.e. undecided)
-                hit_remove->hit.index = -1;
-                hit_neighbour->sign = 0;
-                int planeType = p_geomSvc->getPlaneType(hit_remove->hit.detectorID);
+                tracklet.hitIDs[hit_remove] = -1;
+                tracklet.signs[hit_neighbour] = 0;
+                int planeType = p_geomSvc->getPlaneType(detectorID_remove);
                 if(planeType == 1)
                 {
                     --tracklet.nXHits;
@@ -1114,7 +1213,7 @@ void KalmanFastTracking::removeBadHits(Tracklet& tracklet)
                 }
 
                 //If both hit pairs are not included, the track can be rejected
-                if(hit_neighbour->hit.index < 0)
+                if(tracklet.hitIDs[hit_neighbour] < 0)
                 {
 #ifdef _DEBUG_ON
                     LogInfo("Both hits in a view are missing! Will exit the bad hit removal...");
@@ -1174,6 +1273,11 @@ void KalmanFastTracking::resolveLeftRight(SRawEvent::hit_pair hpair, int& LR1, i
 }
 
 void KalmanFastTracking::buildTrackletsInStation(int stationID, int listID, double* pos_exp, double* window)
+{
+    buildTrackletsInStation(stationID, trackletsInSt[listID], pos_exp, window);
+}
+
+void KalmanFastTracking::buildTrackletsInStation(int stationID, std::vector<CompactTracklet>& tracklets, double* pos_exp, double* window)
 {
 #ifdef _DEBUG_ON
     LogInfo("Building tracklets in station " << stationID);
@@ -1182,6 +1286,14 @@ void KalmanFastTracking::buildTrackletsInStation(int stationID, int listID, doub
     //actuall ID of the tracklet lists
     int sID = stationID - 1;
 
+    //Candidates passing the pre-fit, kept as a max-heap on the pre-fit chi square once it is full
+    FitContext* context = fitContexts[TaskPool::threadID()];
+    std::vector<FitContext::Candidate>& candidates = context->candidates;
+    std::vector<FitContext::Candidate>& unconstrained = context->unconstrained;
+    candidates.clear();
+    unconstrained.clear();
+    int nCandidates = 0;
+
     //Extract the X, U, V hit pairs
     std::list<SRawEvent::hit_pair> pairs_X, pairs_U, pairs_V;
     if(pos_exp == nullptr)
@@ -1256,90 +1368,121 @@ void KalmanFastTracking::buildTrackletsInStation(int stationID, int listID, doub
                 if(v_pos < v_min || v_pos > v_max) continue;
 
                 //Now add the tracklet
-                int LR1 = 0;
-                int LR2 = 0;
-                Tracklet tracklet_new;
+                CompactTracklet tracklet_new;
                 tracklet_new.stationID = stationID;
 
-                //resolveLeftRight(*xiter, LR1, LR2);
                 if(xiter->first >= 0)
                 {
-                    tracklet_new.hits.push_back(SignedHit(hitAll[xiter->first], LR1));
+                    tracklet_new.addHit(xiter->first, hitAll[xiter->first].detectorID);
                     tracklet_new.nXHits++;
                 }
                 if(xiter->second >= 0)
                 {
-                    tracklet_new.hits.push_back(SignedHit(hitAll[xiter->second], LR2));
+                    tracklet_new.addHit(xiter->second, hitAll[xiter->second].detectorID);
                     tracklet_new.nXHits++;
                 }
 
-                //resolveLeftRight(*uiter, LR1, LR2);
                 if(uiter->first >= 0)
                 {
-                    tracklet_new.hits.push_back(SignedHit(hitAll[uiter->first], LR1));
+                    tracklet_new.addHit(uiter->first, hitAll[uiter->first].detectorID);
                     tracklet_new.nUHits++;
                 }
                 if(uiter->second >= 0)
                 {
-                    tracklet_new.hits.push_back(SignedHit(hitAll[uiter->second], LR2));
+                    tracklet_new.addHit(uiter->second, hitAll[uiter->second].detectorID);
                     tracklet_new.nUHits++;
                 }
 
-                //resolveLeftRight(*viter, LR1, LR2);
                 if(viter->first >= 0)
                 {
-                    tracklet_new.hits.push_back(SignedHit(hitAll[viter->first], LR1));
+                    tracklet_new.addHit(viter->first, hitAll[viter->first].detectorID);
                     tracklet_new.nVHits++;
                 }
                 if(viter->second >= 0)
                 {
-                    tracklet_new.hits.push_back(SignedHit(hitAll[viter->second], LR2));
+                    tracklet_new.addHit(viter->second, hitAll[viter->second].detectorID);
                     tracklet_new.nVHits++;
                 }
 
                 tracklet_new.sortHits();
-                if(tracklet_new.isValid() == 0) //TODO: What IS THIS?
+                if(tracklet_new.getNHits() < 4) continue;
+
+                //The full fit can not do better than the straight line through the wires, so the cuts of
+                //CompactTracklet::isValid on station tracklets can already be applied to its chi square
+                double chisq_min = prefitTracklet(tracklet_new);
+                FitContext::Candidate candidate = {chisq_min, nCandidates++, tracklet_new};
+                if(chisq_min < 0.)
                 {
-                    fitTracklet(tracklet_new);
+                    //No bound without a constrained pre-fit, so it can neither be rejected nor ranked here
+                    unconstrained.push_back(candidate);
+                    continue;
                 }
-                else
+                if(chisq_min > 40. || TMath::Prob(chisq_min, tracklet_new.getNHits() - 4) < PROB_LOOSE)
                 {
+#ifdef _DEBUG_ON
+                    LogInfo("Rejected by pre-fit, chisq >= " << chisq_min);
+#endif
                     continue;
                 }
 
-#ifdef _DEBUG_ON
-                tracklet_new.print();
-#endif
-                if(acceptTracklet(tracklet_new))
+                //Only the best MAX_TRACKLETS_STATION candidates by the pre-fit get the full fit
+                if(candidates.size() < MAX_TRACKLETS_STATION)
                 {
-                    trackletsInSt[listID].push_back(tracklet_new);
+                    candidates.push_back(candidate);
+                    if(candidates.size() == MAX_TRACKLETS_STATION) std::make_heap(candidates.begin(), candidates.end());
                 }
-#ifdef _DEBUG_ON
-                else
+                else if(candidate < candidates.front())
                 {
-                    LogInfo("Rejected!!!");
+                    std::pop_heap(candidates.begin(), candidates.end());
+                    candidates.back() = candidate;
+                    std::push_heap(candidates.begin(), candidates.end());
                 }
-#endif
             }
         }
     }
 
+    //Full fit of the retained and the unconstrained candidates, in the order they were found
+    if(candidates.size() == MAX_TRACKLETS_STATION || !unconstrained.empty())
+    {
+        candidates.insert(candidates.end(), unconstrained.begin(), unconstrained.end());
+        std::sort(candidates.begin(), candidates.end(), [](const FitContext::Candidate& a, const FitContext::Candidate& b) { return a.index < b.index; });
+    }
+    for(std::vector<FitContext::Candidate>::iterator iter = candidates.begin(); iter != candidates.end(); ++iter)
+    {
+        CompactTracklet& tracklet_new = iter->tracklet;
+        fitTracklet(tracklet_new);
+
+#ifdef _DEBUG_ON
+        printTracklet(tracklet_new);
+#endif
+        if(acceptTracklet(tracklet_new))
+        {
+            tracklets.push_back(tracklet_new);
+        }
+#ifdef _DEBUG_ON
+        else
+        {
+            LogInfo("Rejected!!!");
+        }
+#endif
+    }
+
     //Reduce the tracklet list and add dummy hits
-    //reduceTrackletList(trackletsInSt[listID]);
-    for(std::list<Tracklet>::iterator iter = trackletsInSt[listID].begin(); iter != trackletsInSt[listID].end(); ++iter)
+    //reduceTrackletList(tracklets);
+    for(std::vector<CompactTracklet>::iterator iter = tracklets.begin(); iter != tracklets.end(); ++iter)
     {
         iter->addDummyHits();
     }
 
-    //Only retain the best 200 tracklets if exceeded
-    if(trackletsInSt[listID].size() > 200)
+    //Only retain the best MAX_TRACKLETS_STATION tracklets if exceeded, the list may already hold the tracklets of station 3+
+    if(tracklets.size() > MAX_TRACKLETS_STATION)
     {
-        trackletsInSt[listID].sort();
-        trackletsInSt[listID].resize(200);
+        std::stable_sort(tracklets.begin(), tracklets.end());
+        tracklets.resize(MAX_TRACKLETS_STATION);
     }
 }
 
-bool KalmanFastTracking::acceptTracklet(Tracklet& tracklet)
+bool KalmanFastTracking::acceptTracklet(CompactTracklet& tracklet)
 {
     //Tracklet itself is okay with enough hits (4-out-of-6) and small chi square
     if(tracklet.isValid() == 0)
@@ -1369,45 +1512,80 @@ bool KalmanFastTracking::acceptTracklet(Tracklet& tracklet)
     return true;
 }
 
-bool KalmanFastTracking::hodoMask(Tracklet& tracklet)
+void KalmanFastTracking::fillElementBitmaps()
+{
+    //Clear the elements set by the previous event
+    for(int i = 0; i < nHodoPlanes+nPropPlanes; ++i)
+    {
+        for(int j = 0; j < nMaskWords; ++j)
+        {
+            for(uint64_t bits = elementBits[i][j]; bits != 0; bits &= bits - 1)
+            {
+                firstHitInElement[i][64*j + lowestBit(bits)] = -1;
+            }
+            elementBits[i][j] = 0;
+        }
+    }
+
+    //Walk the hits backwards so that each chain ends up in hit vector order
+    nextHitInElement.assign(hitAll.size(), -1);
+    for(int hitID = int(hitAll.size()) - 1; hitID >= 0; --hitID)
+    {
+        int idx1 = hitAll[hitID].detectorID - nChamberPlanes - 1;
+        int idx2 = hitAll[hitID].elementID - 1;
+        if(idx1 < 0 || idx1 >= nHodoPlanes+nPropPlanes || idx2 < 0 || idx2 >= 72) continue;
+
+        elementBits[idx1][idx2/64] |= (uint64_t(1) << (idx2 % 64));
+        nextHitInElement[hitID] = firstHitInElement[idx1][idx2];
+        firstHitInElement[idx1][idx2] = hitID;
+    }
+}
+
+bool KalmanFastTracking::hodoMask(CompactTracklet& tracklet)
 {
     //LogInfo(tracklet.stationID);
     int nHodoHits = 0;
+    double factor = tracklet.stationID == nChamberPlanes/6-2 ? 5. : 3.;   //special for station-2, based on real data tuning
+    double fudge = tracklet.stationID < nStations-1 ? 0.5 : 0.15;
     for(std::vector<int>::iterator stationID = stationIDs_mask[tracklet.stationID-1].begin(); stationID != stationIDs_mask[tracklet.stationID-1].end(); ++stationID)
     {
         bool masked = false;
-        for(std::list<int>::iterator iter = hitIDs_mask[*stationID-1].begin(); iter != hitIDs_mask[*stationID-1].end(); ++iter)
+        const std::vector<int>& planes = *(planes_mask[*stationID-1]);
+        for(unsigned int i = 0; i < planes.size() && !masked; ++i)
         {
-            int detectorID = hitAll[*iter].detectorID;
-            int elementID = hitAll[*iter].elementID;
-
-            int idx1 = detectorID - nChamberPlanes - 1;
-            int idx2 = elementID - 1;
+            int idx1 = planes[i] - nChamberPlanes - 1;
 
-            double factor = tracklet.stationID == nChamberPlanes/6-2 ? 5. : 3.;   //special for station-2, based on real data tuning
-            double xfudge = tracklet.stationID < nStations-1 ? 0.5*(x_mask_max[idx1][idx2] - x_mask_min[idx1][idx2]) : 0.15*(x_mask_max[idx1][idx2] - x_mask_min[idx1][idx2]);
+            //Project once per plane, then test the hit elements only
             double z_hodo = z_mask[idx1];
             double x_hodo = tracklet.getExpPositionX(z_hodo);
             double y_hodo = tracklet.getExpPositionY(z_hodo);
-            double err_x = factor*tracklet.getExpPosErrorX(z_hodo) + xfudge;
+            double err_x0 = factor*tracklet.getExpPosErrorX(z_hodo);
             double err_y = factor*tracklet.getExpPosErrorY(z_hodo);
 
-            double x_min = x_mask_min[idx1][idx2] - err_x;
-            double x_max = x_mask_max[idx1][idx2] + err_x;
-            double y_min = y_mask_min[idx1][idx2] - err_y;
-            double y_max = y_mask_max[idx1][idx2] + err_y;
+            for(int j = 0; j < nMaskWords && !masked; ++j)
+            {
+                for(uint64_t bits = elementBits[idx1][j]; bits != 0; bits &= bits - 1)
+                {
+                    int idx2 = 64*j + lowestBit(bits);
+
+                    double err_x = err_x0 + fudge*(x_mask_max[idx1][idx2] - x_mask_min[idx1][idx2]);
+                    double x_min = x_mask_min[idx1][idx2] - err_x;
+                    double x_max = x_mask_max[idx1][idx2] + err_x;
+                    double y_min = y_mask_min[idx1][idx2] - err_y;
+                    double y_max = y_mask_max[idx1][idx2] + err_y;
 
 #ifdef _DEBUG_ON
-            LogInfo(*iter);
-            hitAll[*iter].print();
-            LogInfo(nHodoHits << "/" << stationIDs_mask[tracklet.stationID-1].size() << ":  " << z_hodo << "  " << x_hodo << " +/- " << err_x << "  " << y_hodo << " +/-" << err_y << " : " << x_min << "  " << x_max << "  " << y_min << "  " << y_max);
+                    hitAll[firstHitInElement[idx1][idx2]].print();
+                    LogInfo(nHodoHits << "/" << stationIDs_mask[tracklet.stationID-1].size() << ":  " << z_hodo << "  " << x_hodo << " +/- " << err_x << "  " << y_hodo << " +/-" << err_y << " : " << x_min << "  " << x_max << "  " << y_min << "  " << y_max);
 #endif
-            if(x_hodo > x_min && x_hodo < x_max && y_hodo > y_min && y_hodo < y_max)
-            {
-                nHodoHits++;
-                masked = true;
+                    if(x_hodo > x_min && x_hodo < x_max && y_hodo > y_min && y_hodo < y_max)
+                    {
+                        nHodoHits++;
+                        masked = true;
 
-                break;
+                        break;
+                    }
+                }
             }
         }
 
@@ -1420,7 +1598,7 @@ bool KalmanFastTracking::hodoMask(Tracklet& tracklet)
     return true;
 }
 
-bool KalmanFastTracking::muonID_search(Tracklet& tracklet)
+bool KalmanFastTracking::muonID_search(CompactTracklet& tracklet)
 {
     //Set the cut value on multiple scattering
     //multiple scattering: sigma = 0.0136*sqrt(L/L0)*(1. + 0.038*ln(L/L0))/P, L = 1m, L0 = 1.76cm
@@ -1434,17 +1612,16 @@ bool KalmanFastTracking::muonID_search(Tracklet& tracklet)
 
     double slope[2] = {tracklet.tx, tracklet.ty};
     double pos_absorb[2] = {tracklet.getExpPositionX(MUID_Z_REF), tracklet.getExpPositionY(MUID_Z_REF)};
-    PropSegment* segs[2] = {&(tracklet.seg_x), &(tracklet.seg_y)};
+    CompactSegment* segs[2] = {&(tracklet.seg_x), &(tracklet.seg_y)};
     for(int i = 0; i < 2; ++i)
     {
-        //this shorting circuting can only be done to X-Z, Y-Z needs more complicated thing
-        //if(i == 0 && segs[i]->getNHits() > 2 && segs[i]->isValid() > 0 && fabs(slope[i] - segs[i]->a) < cut) continue;
-
-        segs[i]->init();
+        //the segment is searched and fitted as a full PropSegment, then stored compactly in the tracklet
+        PropSegment seg;
+        int hitIDs_seg[4] = {-1, -1, -1, -1};
         for(int j = 0; j < 4; ++j)
         {
             int index = detectorIDs_muid[i][j] - nChamberPlanes - 1;
-            double pos_ref = j < 2 ? pos_absorb[i] : segs[i]->getPosRef(pos_absorb[i] + slope[i]*(z_ref_muid[i][j] - MUID_Z_REF));
+            double pos_ref = j < 2 ? pos_absorb[i] : seg.getPosRef(pos_absorb[i] + slope[i]*(z_ref_muid[i][j] - MUID_Z_REF));
             double pos_exp = slope[i]*(z_mask[index] - z_ref_muid[i][j]) + pos_ref;
 
             if(!p_geomSvc->isInPlane(detectorIDs_muid[i][j], tracklet.getExpPositionX(z_mask[index]), tracklet.getExpPositionY(z_mask[index]))) continue;
@@ -1453,31 +1630,43 @@ bool KalmanFastTracking::muonID_search(Tracklet& tracklet)
             win_tight = win_tight > 2.54 ? win_tight : 2.54;
             double win_loose = win_tight*2;
             double dist_min = 1E6;
-            for(std::list<int>::iterator iter = hitIDs_muid[i][j].begin(); iter != hitIDs_muid[i][j].end(); ++iter)
+            bool done = false;
+            for(int k = 0; k < nMaskWords && !done; ++k)
             {
-                double pos = hitAll[*iter].pos;
-                double dist = pos - pos_exp;
-                if(dist < -win_loose) continue;
-                if(dist > win_loose) break;
-
-                double dist_l = fabs(pos - hitAll[*iter].driftDistance - pos_exp);
-                double dist_r = fabs(pos + hitAll[*iter].driftDistance - pos_exp);
-                dist = dist_l < dist_r ? dist_l : dist_r;
-                if(dist < dist_min)
+                //Elements are walked in increasing wire position
+                for(uint64_t bits = elementBits[index][k]; bits != 0; bits &= bits - 1)
                 {
-                    dist_min = dist;
-                    if(dist < win_tight)
+                    int hitID = firstHitInElement[index][64*k + lowestBit(bits)];
+                    double pos = hitAll[hitID].pos;
+                    double dist = pos - pos_exp;
+                    if(dist < -win_loose) continue;
+                    if(dist > win_loose)
+                    {
+                        done = true;
+                        break;
+                    }
+
+                    for(; hitID >= 0; hitID = nextHitInElement[hitID])
                     {
-                        segs[i]->hits[j].hit = hitAll[*iter];
-                        segs[i]->hits[j].sign = fabs(pos - hitAll[*iter].driftDistance - pos_exp) < fabs(pos + hitAll[*iter].driftDistance - pos_exp) ? -1 : 1;
+                        double dist_l = fabs(pos - hitAll[hitID].driftDistance - pos_exp);
+                        double dist_r = fabs(pos + hitAll[hitID].driftDistance - pos_exp);
+                        dist = dist_l < dist_r ? dist_l : dist_r;
+                        if(dist < dist_min)
+                        {
+                            dist_min = dist;
+                            if(dist < win_tight)
+                            {
+                                seg.hits[j].hit = hitAll[hitID];
+                                seg.hits[j].sign = dist_l < dist_r ? -1 : 1;
+                                hitIDs_seg[j] = hitID;
+                            }
+                        }
                     }
                 }
             }
         }
-        segs[i]->fit();
-
-        //this shorting circuting can only be done to X-Z, Y-Z needs more complicated thing
-        //if(i == 0 && !(segs[i]->isValid() > 0 && fabs(slope[i] - segs[i]->a) < cut)) return false;
+        seg.fit();
+        segs[i]->pack(seg, hitIDs_seg);
     }
 
     muonID_hodoAid(tracklet);
@@ -1492,7 +1681,7 @@ bool KalmanFastTracking::muonID_search(Tracklet& tracklet)
     return false;
 }
 
-bool KalmanFastTracking::muonID_comp(Tracklet& tracklet)
+bool KalmanFastTracking::muonID_comp(CompactTracklet& tracklet)
 {
     //Set the cut value on multiple scattering
     //multiple scattering: sigma = 0.0136*sqrt(L/L0)*(1. + 0.038*ln(L/L0))/P, L = 1m, L0 = 1.76cm
@@ -1508,7 +1697,7 @@ bool KalmanFastTracking::muonID_comp(Tracklet& tracklet)
 #endif
 
     double slope[2] = {tracklet.tx, tracklet.ty};
-    PropSegment* segs[2] = {&(tracklet.seg_x), &(tracklet.seg_y)};
+    CompactSegment* segs[2] = {&(tracklet.seg_x), &(tracklet.seg_y)};
 
     for(int i = 0; i < 2; ++i)
     {
@@ -1526,11 +1715,10 @@ bool KalmanFastTracking::muonID_comp(Tracklet& tracklet)
             continue;
         }
 
-        for(std::list<PropSegment>::iterator iter = propSegs[i].begin(); iter != propSegs[i].end(); ++iter)
+        for(std::vector<CompactSegment>::iterator iter = propSegs[i].begin(); iter != propSegs[i].end(); ++iter)
         {
 #ifdef _DEBUG_ON
             LogInfo("Testing this prop segment, with ref pos = " << pos_ref << ", slope_ref = " << slope[i]);
-            iter->print();
 #endif
             if(fabs(iter->a - slope[i]) < cut && fabs(iter->getExpPosition(MUID_Z_REF) - pos_ref) < MUID_R_CUT)
             {
@@ -1549,7 +1737,7 @@ bool KalmanFastTracking::muonID_comp(Tracklet& tracklet)
     return true;
 }
 
-bool KalmanFastTracking::muonID_hodoAid(Tracklet& tracklet)
+bool KalmanFastTracking::muonID_hodoAid(CompactTracklet& tracklet)
 {
     double win = 0.03;
     double factor = 5.;
@@ -1561,36 +1749,43 @@ bool KalmanFastTracking::muonID_hodoAid(Tracklet& tracklet)
         factor = 3.;
     }
 
-    PropSegment* segs[2] = {&(tracklet.seg_x), &(tracklet.seg_y)};
+    CompactSegment* segs[2] = {&(tracklet.seg_x), &(tracklet.seg_y)};
     for(int i = 0; i < 2; ++i)
     {
         segs[i]->nHodoHits = 0;
-        for(std::list<int>::iterator iter = hitIDs_muidHodoAid[i].begin(); iter != hitIDs_muidHodoAid[i].end(); ++iter)
+        for(unsigned int j = 0; j < detectorIDs_muidHodoAid[i].size() && segs[i]->nHodoHits <= 4; ++j)
         {
-            int detectorID = hitAll[*iter].detectorID;
-            int elementID = hitAll[*iter].elementID;
-
-            int idx1 = detectorID - nChamberPlanes - 1;
-            int idx2 = elementID - 1;
+            int idx1 = detectorIDs_muidHodoAid[i][j] - nChamberPlanes - 1;
 
             double z_hodo = z_mask[idx1];
             double x_hodo = tracklet.getExpPositionX(z_hodo);
             double y_hodo = tracklet.getExpPositionY(z_hodo);
-            double err_x = factor*tracklet.getExpPosErrorX(z_hodo) + win*(z_hodo - MUID_Z_REF);
-            double err_y = factor*tracklet.getExpPosErrorY(z_hodo) + win*(z_hodo - MUID_Z_REF);
+            double err_x0 = factor*tracklet.getExpPosErrorX(z_hodo) + win*(z_hodo - MUID_Z_REF);
+            double err_y0 = factor*tracklet.getExpPosErrorY(z_hodo) + win*(z_hodo - MUID_Z_REF);
 
-            err_x = err_x/(x_mask_max[idx1][idx2] - x_mask_min[idx1][idx2]) > 0.25 ? 0.25*err_x/(x_mask_max[idx1][idx2] - x_mask_min[idx1][idx2]) : err_x;
-            err_y = err_y/(y_mask_max[idx1][idx2] - y_mask_min[idx1][idx2]) > 0.25 ? 0.25*err_y/(y_mask_max[idx1][idx2] - y_mask_min[idx1][idx2]) : err_y;
+            for(int k = 0; k < nMaskWords && segs[i]->nHodoHits <= 4; ++k)
+            {
+                for(uint64_t bits = elementBits[idx1][k]; bits != 0 && segs[i]->nHodoHits <= 4; bits &= bits - 1)
+                {
+                    int idx2 = 64*k + lowestBit(bits);
 
-            double x_min = x_mask_min[idx1][idx2] - err_x;
-            double x_max = x_mask_max[idx1][idx2] + err_x;
-            double y_min = y_mask_min[idx1][idx2] - err_y;
-            double y_max = y_mask_max[idx1][idx2] + err_y;
+                    double err_x = err_x0/(x_mask_max[idx1][idx2] - x_mask_min[idx1][idx2]) > 0.25 ? 0.25*err_x0/(x_mask_max[idx1][idx2] - x_mask_min[idx1][idx2]) : err_x0;
+                    double err_y = err_y0/(y_mask_max[idx1][idx2] - y_mask_min[idx1][idx2]) > 0.25 ? 0.25*err_y0/(y_mask_max[idx1][idx2] - y_mask_min[idx1][idx2]) : err_y0;
 
-            if(x_hodo > x_min && x_hodo < x_max && y_hodo > y_min && y_hodo < y_max)
-            {
-                segs[i]->hodoHits[segs[i]->nHodoHits++] = hitAll[*iter];
-                if(segs[i]->nHodoHits > 4) break;
+                    double x_min = x_mask_min[idx1][idx2] - err_x;
+                    double x_max = x_mask_max[idx1][idx2] + err_x;
+                    double y_min = y_mask_min[idx1][idx2] - err_y;
+                    double y_max = y_mask_max[idx1][idx2] + err_y;
+
+                    if(!(x_hodo > x_min && x_hodo < x_max && y_hodo > y_min && y_hodo < y_max)) continue;
+
+                    //every hit on a matching element counts, stop once more than 4 are found
+                    for(int hitID = firstHitInElement[idx1][idx2]; hitID >= 0; hitID = nextHitInElement[hitID])
+                    {
+                        if(segs[i]->nHodoHits < 4) segs[i]->hodoHitIDs[segs[i]->nHodoHits] = hitID;
+                        if(++(segs[i]->nHodoHits) > 4) break;
+                    }
+                }
             }
         }
     }
@@ -1634,10 +1829,11 @@ void KalmanFastTracking::buildPropSegments()
                 PropSegment seg;
 
                 //Note that the backward plane comes as the first in pair
-                if(fiter->first >= 0) seg.hits[1] = SignedHit(hitAll[fiter->first], 0);
-                if(fiter->second >= 0) seg.hits[0] = SignedHit(hitAll[fiter->second], 0);
-                if(biter->first >= 0) seg.hits[3] = SignedHit(hitAll[biter->first], 0);
-                if(biter->second >= 0) seg.hits[2] = SignedHit(hitAll[biter->second], 0);
+                int hitIDs_seg[4] = {fiter->second, fiter->first, biter->second, biter->first};
+                for(int j = 0; j < 4; ++j)
+                {
+                    if(hitIDs_seg[j] >= 0) seg.hits[j] = SignedHit(hitAll[hitIDs_seg[j]], 0);
+                }
 
 #ifdef _DEBUG_ON
                 seg.print();
@@ -1649,7 +1845,9 @@ void KalmanFastTracking::buildPropSegments()
 
                 if(seg.isValid() > 0)
                 {
-                    propSegs[i].push_back(seg);
+                    CompactSegment cseg;
+                    cseg.pack(seg, hitIDs_seg);
+                    propSegs[i].push_back(cseg);
                 }
 #ifdef _DEBUG_ON
                 else
@@ -1663,86 +1861,219 @@ void KalmanFastTracking::buildPropSegments()
 }
 
 
+namespace
+{
+    //Least chi square fit of the straight line (and momentum) parameters, shared by Tracklet and CompactTracklet
+    template<class T>
+    int fitTrackletParameters(ROOT::Math::Minimizer** minimizer, T& tracklet)
+    {
+        //idx = 0, using simplex; idx = 1 using migrad
+        int idx = 1;
+#ifdef _ENABLE_MULTI_MINI
+        if(tracklet.stationID < nStations-1) idx = 0;
+#endif
+
+        minimizer[idx]->SetLimitedVariable(0, "tx", tracklet.tx, 0.001, -TX_MAX, TX_MAX);
+        minimizer[idx]->SetLimitedVariable(1, "ty", tracklet.ty, 0.001, -TY_MAX, TY_MAX);
+        minimizer[idx]->SetLimitedVariable(2, "x0", tracklet.x0, 0.1, -X0_MAX, X0_MAX);
+        minimizer[idx]->SetLimitedVariable(3, "y0", tracklet.y0, 0.1, -Y0_MAX, Y0_MAX);
+        if(KMAG_ON)
+        {
+            minimizer[idx]->SetLimitedVariable(4, "invP", tracklet.invP, 0.001*tracklet.invP, INVP_MIN, INVP_MAX);
+        }
+        minimizer[idx]->Minimize();
+
+        tracklet.tx = minimizer[idx]->X()[0];
+        tracklet.ty = minimizer[idx]->X()[1];
+        tracklet.x0 = minimizer[idx]->X()[2];
+        tracklet.y0 = minimizer[idx]->X()[3];
+
+        tracklet.err_tx = minimizer[idx]->Errors()[0];
+        tracklet.err_ty = minimizer[idx]->Errors()[1];
+        tracklet.err_x0 = minimizer[idx]->Errors()[2];
+        tracklet.err_y0 = minimizer[idx]->Errors()[3];
+
+        if(KMAG_ON && tracklet.stationID == nStations)
+        {
+            tracklet.invP = minimizer[idx]->X()[4];
+            tracklet.err_invP = minimizer[idx]->Errors()[4];
+        }
+
+        tracklet.chisq = minimizer[idx]->MinValue();
+
+        int status = minimizer[idx]->Status();
+        return status;
+    }
+}
+
 int KalmanFastTracking::fitTracklet(Tracklet& tracklet)
 {
     tracklet_curr = tracklet;
+    return fitTrackletParameters(minimizer, tracklet);
+}
 
-    //idx = 0, using simplex; idx = 1 using migrad
-    int idx = 1;
-#ifdef _ENABLE_MULTI_MINI
-    if(tracklet.stationID < nStations-1) idx = 0;
-#endif
+int KalmanFastTracking::fitTracklet(CompactTracklet& tracklet)
+{
+    FitContext* context = fitContexts[TaskPool::threadID()];
+    context->tracklet_curr = tracklet;
+    return fitTrackletParameters(context->minimizer, tracklet);
+}
 
-    minimizer[idx]->SetLimitedVariable(0, "tx", tracklet.tx, 0.001, -TX_MAX, TX_MAX);
-    minimizer[idx]->SetLimitedVariable(1, "ty", tracklet.ty, 0.001, -TY_MAX, TY_MAX);
-    minimizer[idx]->SetLimitedVariable(2, "x0", tracklet.x0, 0.1, -X0_MAX, X0_MAX);
-    minimizer[idx]->SetLimitedVariable(3, "y0", tracklet.y0, 0.1, -Y0_MAX, Y0_MAX);
-    if(KMAG_ON)
+double KalmanFastTracking::prefitTracklet(CompactTracklet& tracklet)
+{
+    //Normal equations of the weighted least square, only the lower triangle is filled
+    double A[4][4] = {{0.}};
+    double b[4] = {0., 0., 0., 0.};
+    double mm = 0.;
+    for(int i = 0; i < tracklet.nHits; ++i)
     {
-        minimizer[idx]->SetLimitedVariable(4, "invP", tracklet.invP, 0.001*tracklet.invP, INVP_MIN, INVP_MAX);
+        if(tracklet.hitIDs[i] < 0) continue;
+
+        const Hit& hit = hitAll[tracklet.hitIDs[i]];
+        const WireRow& row = wireRows[hit.detectorID][hit.elementID];
+        for(int j = 0; j < 4; ++j)
+        {
+            for(int k = 0; k <= j; ++k) A[j][k] += row.h[j]*row.h[k];
+            b[j] += row.h[j]*row.m;
+        }
+        mm += row.m*row.m;
     }
-    minimizer[idx]->Minimize();
 
-    tracklet.tx = minimizer[idx]->X()[0];
-    tracklet.ty = minimizer[idx]->X()[1];
-    tracklet.x0 = minimizer[idx]->X()[2];
-    tracklet.y0 = minimizer[idx]->X()[3];
+    //Cholesky decomposition A = L*L^T in place
+    for(int j = 0; j < 4; ++j)
+    {
+        for(int k = 0; k <= j; ++k)
+        {
+            double sum = A[j][k];
+            for(int l = 0; l < k; ++l) sum -= A[j][l]*A[k][l];
+
+            if(k < j)
+            {
+                A[j][k] = sum/A[k][k];
+            }
+            else
+            {
+                if(sum <= 1E-10*A[j][j]) return -1.;
+                A[j][j] = sqrt(sum);
+            }
+        }
+    }
 
-    tracklet.err_tx = minimizer[idx]->Errors()[0];
-    tracklet.err_ty = minimizer[idx]->Errors()[1];
-    tracklet.err_x0 = minimizer[idx]->Errors()[2];
-    tracklet.err_y0 = minimizer[idx]->Errors()[3];
+    //chisq_min = m.m - b^T A^-1 b = m.m - |y|^2 with L*y = b, and the solution from L^T*par = y
+    double y[4];
+    double chisq_min = mm;
+    for(int j = 0; j < 4; ++j)
+    {
+        y[j] = b[j];
+        for(int k = 0; k < j; ++k) y[j] -= A[j][k]*y[k];
+        y[j] /= A[j][j];
+        chisq_min -= y[j]*y[j];
+    }
 
-    if(KMAG_ON && tracklet.stationID == nStations)
+    double par[4];
+    for(int j = 3; j >= 0; --j)
     {
-        tracklet.invP = minimizer[idx]->X()[4];
-        tracklet.err_invP = minimizer[idx]->Errors()[4];
+        par[j] = y[j];
+        for(int k = j+1; k < 4; ++k) par[j] -= A[k][j]*par[k];
+        par[j] /= A[j][j];
     }
 
-    tracklet.chisq = minimizer[idx]->MinValue();
+    //Use the solution as the starting point of the full fit if it is inside the fit limits
+    if(fabs(par[0]) < TX_MAX && fabs(par[1]) < TY_MAX && fabs(par[2]) < X0_MAX && fabs(par[3]) < Y0_MAX)
+    {
+        tracklet.tx = par[0];
+        tracklet.ty = par[1];
+        tracklet.x0 = par[2];
+        tracklet.y0 = par[3];
+    }
 
-    int status = minimizer[idx]->Status();
-    return status;
+    return chisq_min > 0. ? chisq_min : 0.;
 }
 
-int KalmanFastTracking::reduceTrackletList(std::list<Tracklet>& tracklets)
+KalmanFastTracking::FitContext::FitContext(const std::vector<Hit>* hits): hitAll(hits)
 {
-    std::list<Tracklet> targetList;
+    minimizer[0] = ROOT::Math::Factory::CreateMinimizer("Minuit2", "Simplex");
+    minimizer[1] = ROOT::Math::Factory::CreateMinimizer("Minuit2", "Combined");
+    fcn = ROOT::Math::Functor(this, &KalmanFastTracking::FitContext::eval, KMAG_ON ? 5 : 4);
 
-    tracklets.sort();
-    while(!tracklets.empty())
+    for(int i = 0; i < 2; ++i)
     {
-        targetList.push_back(tracklets.front());
-        tracklets.pop_front();
+        minimizer[i]->SetMaxFunctionCalls(1000000);
+        minimizer[i]->SetMaxIterations(100);
+        minimizer[i]->SetTolerance(1E-2);
+        minimizer[i]->SetFunction(fcn);
+        minimizer[i]->SetPrintLevel(0);
+    }
+}
 
-#ifdef _DEBUG_ON_LEVEL_2
-        LogInfo("Current best tracklet in reduce");
-        targetList.back().print();
-#endif
+KalmanFastTracking::FitContext::~FitContext()
+{
+    delete minimizer[0];
+    delete minimizer[1];
+}
+
+double KalmanFastTracking::FitContext::eval(const double* par)
+{
+    tracklet_curr.tx = par[0];
+    tracklet_curr.ty = par[1];
+    tracklet_curr.x0 = par[2];
+    tracklet_curr.y0 = par[3];
+    if(KMAG_ON) tracklet_curr.invP = par[4];
+
+    return tracklet_curr.calcChisq(*hitAll);
+}
+
+int KalmanFastTracking::reduceTrackletList(std::vector<CompactTracklet>& tracklets)
+{
+    //Keep the best tracklet and drop the ones similar to it, then go on with the next best remaining one,
+    //this is done in place on the sorted list since a tracklet is only compared to the ones kept before it
+    std::stable_sort(tracklets.begin(), tracklets.end());
 
-        for(std::list<Tracklet>::iterator iter = tracklets.begin(); iter != tracklets.end(); )
+    size_t nKept = 0;
+    for(size_t i = 0; i < tracklets.size(); ++i)
+    {
+        bool similar = false;
+        for(size_t j = 0; j < nKept; ++j)
         {
-            if(iter->similarity(targetList.back()))
+            if(tracklets[i].similarity(tracklets[j]))
             {
-#ifdef _DEBUG_ON_LEVEL_2
-                LogInfo("Removing this tracklet: ");
-                iter->print();
-#endif
-                iter = tracklets.erase(iter);
-                continue;
-            }
-            else
-            {
-                ++iter;
+                similar = true;
+                break;
             }
         }
+        if(similar) continue;
+
+        if(i != nKept) tracklets[nKept] = tracklets[i];
+        ++nKept;
     }
 
-    tracklets.assign(targetList.begin(), targetList.end());
+    tracklets.resize(nKept);
     return 0;
 }
 
-void KalmanFastTracking::getExtrapoWindowsInSt1(Tracklet& tracklet, double* pos_exp, double* window, int st1ID)
+std::list<Tracklet>& KalmanFastTracking::getTrackletList(int i)
+{
+    if(!trackletsOutFilled[i])
+    {
+        trackletsOut[i].clear();
+        for(std::vector<CompactTracklet>::iterator iter = trackletsInSt[i].begin(); iter != trackletsInSt[i].end(); ++iter)
+        {
+            trackletsOut[i].push_back(Tracklet());
+            iter->fillTracklet(hitAll, trackletsOut[i].back());
+        }
+        trackletsOutFilled[i] = true;
+    }
+    return trackletsOut[i];
+}
+
+void KalmanFastTracking::printTracklet(const CompactTracklet& tracklet)
+{
+    Tracklet tracklet_print;
+    tracklet.fillTracklet(hitAll, tracklet_print);
+    tracklet_print.print();
+}
+
+void KalmanFastTracking::getExtrapoWindowsInSt1(const CompactTracklet& tracklet, double* pos_exp, double* window, int st1ID)
 {
     if(tracklet.stationID != nStations-1)
     {
@@ -1770,7 +2101,7 @@ void KalmanFastTracking::getExtrapoWindowsInSt1(Tracklet& tracklet, double* pos_
     }
 }
 
-void KalmanFastTracking::getSagittaWindowsInSt1(Tracklet& tracklet, double* pos_exp, double* window, int st1ID)
+void KalmanFastTracking::getSagittaWindowsInSt1(const CompactTracklet& tracklet, double* pos_exp, double* window, int st1ID)
 {
     if(tracklet.stationID != nStations-1)
     {
@@ -1782,7 +2113,7 @@ void KalmanFastTracking::getSagittaWindowsInSt1(Tracklet& tracklet, double* pos_
         return;
     }
 
-    double z_st3 = z_plane[tracklet.hits.back().hit.detectorID];
+    double z_st3 = z_plane[tracklet.detectorIDs[tracklet.nHits-1]];
     double x_st3 = tracklet.getExpPositionX(z_st3);
     double y_st3 = tracklet.getExpPositionY(z_st3);
 
@@ -1823,7 +2154,7 @@ void KalmanFastTracking::printAtDetectorBack(int stationID, std::string outputFi
     TCanvas c1;
 
     std::vector<double> x, y, dx, dy;
-    for(std::list<Tracklet>::iterator iter = trackletsInSt[stationID].begin(); iter != trackletsInSt[stationID].end(); ++iter)
+    for(std::vector<CompactTracklet>::iterator iter = trackletsInSt[stationID].begin(); iter != trackletsInSt[stationID].end(); ++iter)
     {
         double z = p_geomSvc->getPlanePosition(iter->stationID*6);
         x.push_back(iter->getExpPositionX(z));
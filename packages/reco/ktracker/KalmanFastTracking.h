@@ -14,6 +14,7 @@ Created: 05-24-2013
 #include <geom_svc/GeomSvc.h>
 
 #include <list>
+#include <stdint.h>
 #include <vector>
 #include <map>
 
@@ -25,11 +26,13 @@ Created: 05-24-2013
 #include "KalmanTrack.h"
 #include "KalmanFitter.h"
 #include "FastTracklet.h"
+#include "CompactTracklet.h"
 
 class TGeoManager;
 
 class PHField;
 class PHTimer;
+class TaskPool;
 
 class KalmanFastTracking
 {
@@ -42,6 +45,15 @@ public:
     int Verbosity() const {return verbosity;}
     void printTimers();
 
+    //Per-stage timers of the last event, reset by setRawEvent
+    const std::map<std::string, PHTimer*>& getTimers() const { return _timers; }
+
+    //Number of threads used to link the back partials to station 1, including the calling thread (default 1).
+    //The result does not depend on it. Only the candidate finding is threaded, the Kalman vertex
+    //evaluation still runs in the calling thread. Not to be changed while an event is processed
+    void setNThreads(unsigned int n);
+    unsigned int getNThreads() const { return fitContexts.size(); }
+
     //Set the input event
     int setRawEvent(SRawEvent* event_input);
     void setRawEventDebug(SRawEvent* event_input);
@@ -61,30 +73,35 @@ public:
 
     //Fit tracklets
     int fitTracklet(Tracklet& tracklet);
+    int fitTracklet(CompactTracklet& tracklet);
 
     //Check the quality of tracklet, number of hits
-    bool acceptTracklet(Tracklet& tracklet);
-    bool hodoMask(Tracklet& tracklet);
-    bool muonID_comp(Tracklet& tracklet);
-    bool muonID_search(Tracklet& tracklet);
-    bool muonID_hodoAid(Tracklet& tracklet);
+    bool acceptTracklet(CompactTracklet& tracklet);
+    void fillElementBitmaps();
+    bool hodoMask(CompactTracklet& tracklet);
+    bool muonID_comp(CompactTracklet& tracklet);
+    bool muonID_search(CompactTracklet& tracklet);
+    bool muonID_hodoAid(CompactTracklet& tracklet);
 
     void buildPropSegments();
 
     //Resolve left-right when possible
     void resolveLeftRight(SRawEvent::hit_pair hpair, int& LR1, int& LR2);
-    void resolveLeftRight(Tracklet& tracklet, double threshold);
-    void resolveSingleLeftRight(Tracklet& tracklet);
+    void resolveLeftRight(CompactTracklet& tracklet, double threshold);
+    void resolveSingleLeftRight(CompactTracklet& tracklet);
 
     //Remove bad hit if needed
-    void removeBadHits(Tracklet& tracklet);
+    void removeBadHits(CompactTracklet& tracklet);
 
     //Reduce the list of tracklets, returns the number of elements reduced
-    int reduceTrackletList(std::list<Tracklet>& tracklets);
+    int reduceTrackletList(std::vector<CompactTracklet>& tracklets);
 
     //Get exp postion and window using sagitta method in station 1
-    void getSagittaWindowsInSt1(Tracklet& tracklet, double* pos_exp, double* window, int st1ID);
-    void getExtrapoWindowsInSt1(Tracklet& tracklet, double* pos_exp, double* window, int st1ID);
+    void getSagittaWindowsInSt1(const CompactTracklet& tracklet, double* pos_exp, double* window, int st1ID);
+    void getExtrapoWindowsInSt1(const CompactTracklet& tracklet, double* pos_exp, double* window, int st1ID);
+
+    //Print a compact tracklet through its full Tracklet form
+    void printTracklet(const CompactTracklet& tracklet);
 
     //Print the distribution of tracklets at detector back/front
     void printAtDetectorBack(int stationID, std::string outputFileName);
@@ -99,12 +116,13 @@ public:
     //Resolve left right by Kalman fitting results
     void resolveLeftRight(KalmanTrack& kmtrk);
 
-    ///Final output
-    std::list<Tracklet>& getFinalTracklets() { return trackletsInSt[outputListIdx]; }
-    std::list<Tracklet>& getBackPartials() { return trackletsInSt[3]; }
-    std::list<Tracklet>& getTrackletList(int i) { return trackletsInSt[i]; }
+    ///Final output, the Tracklet lists are only filled from the compact candidates on request
+    std::list<Tracklet>& getFinalTracklets() { return getTrackletList(outputListIdx); }
+    std::list<Tracklet>& getBackPartials() { return getTrackletList(3); }
+    std::list<Tracklet>& getTrackletList(int i);
+    std::vector<CompactTracklet>& getCompactTracklets(int i) { return trackletsInSt[i]; }
     std::list<SRecTrack>& getSRecTracks() { return stracks; }
-    std::list<PropSegment>& getPropSegments(int i) { return propSegs[i]; }
+    std::vector<CompactSegment>& getPropSegments(int i) { return propSegs[i]; }
 
     ///Set the index of the final output tracklet list
     void setOutputListID(unsigned int i) { outputListIdx = i; }
@@ -121,8 +139,12 @@ private:
     std::vector<Hit> hitAll;
 
     //Tracklets in one event, id = 0, 1, 2 for station 0/1, 2, 3+/-, id = 3 for station 2&3 combined, id = 4 for global tracks
-    //Likewise for the next part
-    std::list<Tracklet> trackletsInSt[5];
+    //Likewise for the next part. The vectors are cleared but keep their capacity from event to event.
+    std::vector<CompactTracklet> trackletsInSt[5];
+
+    //Output Tracklet lists converted from trackletsInSt on request
+    std::list<Tracklet> trackletsOut[5];
+    bool trackletsOutFilled[5];
 
     //Final SRecTrack list
     std::list<SRecTrack> stracks;
@@ -132,14 +154,14 @@ private:
 
     //Prop. tube segments for muon id purposes
     // 0 for X-Z, 1 for Y-Z
-    std::list<PropSegment> propSegs[2];
+    std::vector<CompactSegment> propSegs[2];
 
     ///Configurations of tracklet finding
     //Hodo. IDs for masking, 4 means we have 4 hodo stations
     std::vector<int> detectorIDs_mask[4];
     std::vector<int> detectorIDs_maskX[4];
     std::vector<int> detectorIDs_maskY[4];
-    std::list<int>   hitIDs_mask[4];              //hits in T/B, L/R are combined
+    const std::vector<int>* planes_mask[4];       //maskX or maskY of the current event, T/B, L/R are combined
     std::vector<int> detectorIDs_muidHodoAid[2];  //Aux-hodoscope masking for muon ID
 
     //register difference hodo masking stations for different chamber detectors
@@ -148,8 +170,15 @@ private:
     //prop. tube IDs for MUID -- 0 for x-z, 1 for y-z
     int detectorIDs_muid[2][4];
     double z_ref_muid[2][4];
-    std::list<int> hitIDs_muid[2][4];
-    std::list<int> hitIDs_muidHodoAid[2];
+
+    //Hodo. and prop. tube hits of the current event as per-plane element bitmaps, filled in setRawEvent,
+    //plane index is detectorID - nChamberPlanes - 1 as for the masking windows, bit elementID-1 is set
+    //if the element is hit. The hits of one element are chained from firstHitInElement via nextHitInElement
+    //in hit vector order, -1 terminated
+    static const int nMaskWords = 2;
+    uint64_t elementBits[nHodoPlanes+nPropPlanes][nMaskWords];
+    int firstHitInElement[nHodoPlanes+nPropPlanes][72];
+    std::vector<int> nextHitInElement;
 
     //Masking window sizes, index is the uniqueID defined by nElement*detectorID + elementID
     double z_mask[nHodoPlanes+nPropPlanes];
@@ -197,6 +226,78 @@ private:
     ROOT::Math::Minimizer* minimizer[2];
     ROOT::Math::Functor fcn;
 
+    //Least chi square fit of the compact candidates, one per thread, index is TaskPool::threadID()
+    struct FitContext
+    {
+        FitContext(const std::vector<Hit>* hits);
+        ~FitContext();
+
+        //Chi square of tracklet_curr with the given parameters, used by fcn
+        double eval(const double* par);
+
+        CompactTracklet tracklet_curr;
+        const std::vector<Hit>* hitAll;
+        ROOT::Math::Minimizer* minimizer[2];
+        ROOT::Math::Functor fcn;
+
+        //Candidate of buildTrackletsInStation waiting for the full fit, ordered by the pre-fit chi square
+        //and then by the order it was found
+        struct Candidate
+        {
+            double chisq_min;
+            int index;
+            CompactTracklet tracklet;
+
+            bool operator<(const Candidate& other) const
+            {
+                return chisq_min < other.chisq_min || (chisq_min == other.chisq_min && index < other.index);
+            }
+        };
+
+        //Candidates with a pre-fit chi square, kept as a max-heap once full, and the ones the pre-fit
+        //could not constrain, which are always fitted
+        std::vector<Candidate> candidates;
+        std::vector<Candidate> unconstrained;
+    };
+    std::vector<FitContext*> fitContexts;
+
+    //Threads for buildGlobalTracks, nullptr when running with one thread
+    TaskPool* taskPool;
+
+    //Result of linking one back partial to the tracklets of one station-1 chamber
+    struct St1Link
+    {
+        std::vector<CompactTracklet> trackletsInSt1;  //station-1 tracklets inside the window
+        std::vector<CompactTracklet> accepted;        //accepted global candidates, only kept for the KF vertex selection
+        CompactTracklet best_prob;
+    };
+
+    //One entry per (back partial, station-1 chamber), kept from event to event for the storage
+    std::vector<St1Link> st1Links;
+
+    //Build the station-1 tracklets of chamber st1ID around a back partial and link them to it
+    void linkStation1(const CompactTracklet& tracklet23, int st1ID, St1Link& link);
+
+    //Build tracklets in a station into the given list
+    void buildTrackletsInStation(int stationID, std::vector<CompactTracklet>& tracklets, double* pos_exp, double* window);
+
+    //Linearized DCA of a straight track to each wire, |DCA|/sigma >= |h.(tx, ty, x0, y0) - m| for any
+    //slopes within TX_MAX/TY_MAX, sigma being the resolution of a hit without left-right (index is elementID)
+    struct WireRow
+    {
+        double h[4];
+        double m;
+    };
+    std::vector<WireRow> wireRows[nChamberPlanes+1];
+
+    //Least square straight line through the wires of a station tracklet. The returned chi square is a
+    //lower bound of the one of fitTracklet, and the tracklet parameters are set to the solution as the
+    //starting point of the full fit. Returns -1 if the parameters are not constrained by the hits
+    double prefitTracklet(CompactTracklet& tracklet);
+
+    //Maximum number of tracklets kept and fitted in one call of buildTrackletsInStation
+    static const unsigned int MAX_TRACKLETS_STATION = 200;
+
     //Kalman fitter
     KalmanFitter* kmfitter;
 
@@ -57,10 +57,12 @@ SQReco::SQReco(const std::string& name):
   _tracklet_vector(nullptr),
   _evt_reducer_opt(""),
   _fastfinder(nullptr),
+  _n_threads(1),
   _eventReducer(nullptr),
   _enable_KF(true),
   _kfitter(nullptr),
   _gfitter(nullptr),
+  _layered_material(false),
   _phfield(nullptr),
   _gfield(nullptr),
   _event(0),
@@ -113,6 +115,7 @@ int SQReco::InitRun(PHCompositeNode* topNode)
   _fastfinder = new KalmanFastTracking(_phfield, _t_geo_manager, _enable_KF);///Abi (Don't we turn on enable_kF ?)
 
   _fastfinder->Verbosity(Verbosity());
+  _fastfinder->setNThreads(_n_threads);
 
   if(_evt_reducer_opt == "none")  //Meaning we disable the event reducer
   {
@@ -140,6 +143,7 @@ int SQReco::InitRun(PHCompositeNode* topNode)
     else 
     {
       _gfitter = new SQGenFit::GFFitter();
+      _gfitter->setLayeredMaterial(_layered_material);
       if(_fitter_type == SQReco::KF)
       {
         _gfitter->init(_gfield, "KalmanFitter");
@@ -76,6 +76,13 @@ public:
 
   void set_legacy_rec_container(const bool b = true) { _legacy_rec_container = b; } 
 
+  //Use the z-sliced material model instead of TGeo navigation in the GenFit fitters
+  void set_layered_material(const bool b = true) { _layered_material = b; }
+
+  //Threads used by the track finder within one event, the track fitting stays in the calling thread
+  //since GenFit and the legacy Kalman filter share global state
+  void set_n_threads(const unsigned int n) { _n_threads = n; }
+
 private:
 
   int InitField(PHCompositeNode* topNode);
@@ -108,11 +115,13 @@ private:
 
   TString _evt_reducer_opt;
   KalmanFastTracking* _fastfinder;
+  unsigned int _n_threads;
   EventReducer*       _eventReducer;
 
   bool _enable_KF;
   KalmanFitter*       _kfitter;
   SQGenFit::GFFitter* _gfitter;
+  bool _layered_material;
 
   PHField* _phfield;
   SQGenFit::GFField* _gfield;
@@ -0,0 +1,93 @@
+/*
+TaskPool.cxx
+
+Implementation of class TaskPool
+*/
+
+#include "TaskPool.h"
+
+namespace
+{
+    thread_local unsigned int poolThreadID = 0;
+}
+
+TaskPool::TaskPool(unsigned int nThreads): job(nullptr), nTasksJob(0), nextTask(0), nBusy(0), generation(0), stopping(false)
+{
+    for(unsigned int i = 1; i < nThreads; ++i)
+    {
+        workers.push_back(std::thread(&TaskPool::workerLoop, this, i));
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cvStart.notify_all();
+
+    for(unsigned int i = 0; i < workers.size(); ++i) workers[i].join();
+}
+
+unsigned int TaskPool::threadID()
+{
+    return poolThreadID;
+}
+
+void TaskPool::run(unsigned int nTasks, const std::function<void(unsigned int, unsigned int)>& func)
+{
+    if(nTasks == 0) return;
+
+    //Nothing to share, avoid waking up the workers
+    if(workers.empty() || nTasks == 1)
+    {
+        for(unsigned int i = 0; i < nTasks; ++i) func(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        job = &func;
+        nTasksJob = nTasks;
+        nextTask = 0;
+        nBusy = workers.size();
+        ++generation;
+    }
+    cvStart.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mtx);
+    cvDone.wait(lock, [this] { return nBusy == 0; });
+    job = nullptr;
+}
+
+void TaskPool::workerLoop(unsigned int id)
+{
+    poolThreadID = id;
+
+    unsigned long seen = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvStart.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if(stopping) return;
+            seen = generation;
+        }
+
+        drain(id);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if(--nBusy == 0) cvDone.notify_one();
+    }
+}
+
+void TaskPool::drain(unsigned int id)
+{
+    for(unsigned int i = nextTask++; i < nTasksJob; i = nextTask++)
+    {
+        (*job)(i, id);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+TaskPool.h
+
+Small pool of persistent threads used to run the independent pieces of the
+tracking of one event (e.g. linking back partials to station 1) in parallel.
+
+run() hands the task indices out one at a time from a shared counter, the calling
+thread takes part as thread 0, so threads which finish early keep taking the
+remaining tasks and the load is balanced without a per-task queue.
+The order in which tasks are executed is not defined, callers are expected to
+write each result into its own slot and reduce them in task order afterwards.
+*/
+
+#ifndef _TASKPOOL_H
+#define _TASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskPool
+{
+public:
+    //nThreads includes the calling thread, i.e. nThreads-1 threads are started
+    explicit TaskPool(unsigned int nThreads);
+    ~TaskPool();
+
+    unsigned int getNThreads() const { return workers.size() + 1; }
+
+    //Call func(taskID, threadID) for taskID = 0 ... nTasks-1, returns when all tasks are done
+    void run(unsigned int nTasks, const std::function<void(unsigned int, unsigned int)>& func);
+
+    //Index of the pool thread running the current task, 0 outside of the pool threads
+    static unsigned int threadID();
+
+private:
+    TaskPool(const TaskPool&);
+    TaskPool& operator=(const TaskPool&);
+
+    void workerLoop(unsigned int id);
+    void drain(unsigned int id);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mtx;
+    std::condition_variable cvStart;
+    std::condition_variable cvDone;
+
+    //Current job, set under mtx before the workers are woken up
+    const std::function<void(unsigned int, unsigned int)>* job;
+    unsigned int nTasksJob;
+    std::atomic<unsigned int> nextTask;
+    unsigned int nBusy;
+    unsigned long generation;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,608 @@
+/*
+bench_tracking.cxx
+
+Replay benchmark of the track reconstruction, without Fun4All.
+A fixed set of events is read into memory, either SRawEvent (e.g. the "save" tree
+read by Fun4AllSRawEventInputManager) or SQHitVector (the "T" tree of a DST), and
+replayed through EventReducer, KalmanFastTracking and the track fitter used by SQReco.
+
+Reported, for all events and binned by the number of hits before the reduction:
+  - events/s
+  - latency percentiles of each stage, incl. the KalmanFastTracking timers
+  - number/size of operator new allocations per event
+  - peak RSS of the process
+The result is written as a flat JSON object (one "key": value per line) which can be
+given back with -B to compare a new run against it. The exit code is 2 if any latency,
+allocation count or peak RSS grew, or the event rate dropped, by more than the threshold.
+
+Usage:
+  bench_tracking -i input.root [-t tree] [-b branch] [-n nEvents] [-l nLoops] [-w nWarmUp]
+                 [-R runID | -c recoConsts.opts] [-r reducerOpts|none] [-f fitter] [-g geom.root]
+                 [-j nThreads] [-m 200,400,800] [-o result.json] [-B baseline.json] [-x 0.05]
+
+  fitter is one of none (track finding only), legacy, kf, kfref, daf, dafref, default none.
+  Any fitter other than none enables the Kalman vertex selection of the track finder, as SQReco does,
+  and needs the geometry file.
+*/
+
+#include <geom_svc/GeomSvc.h>
+#include <interface_main/SQHit.h>
+#include <interface_main/SQHitVector.h>
+#include <phfield/PHField.h>
+#include <phfield/PHFieldConfig_v3.h>
+#include <phfield/PHFieldUtility.h>
+#include <phool/PHTimer.h>
+#include <phool/recoConsts.h>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TClass.h>
+#include <TGeoManager.h>
+
+#include <GFField.h>
+#include <GFFitter.h>
+#include <GFTrack.h>
+#include <KalmanFitter.h>
+#include <KalmanTrack.h>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SRawEvent.h"
+#include "FastTracklet.h"
+#include "EventReducer.h"
+#include "KalmanFastTracking.h"
+
+//Count every operator new of the process, the libraries included
+namespace
+{
+    std::atomic<unsigned long> nAllocs(0);
+    std::atomic<unsigned long> nAllocBytes(0);
+}
+
+void* operator new(std::size_t size)
+{
+    ++nAllocs;
+    nAllocBytes += size;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double msSince(const Clock::time_point& t0)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    }
+
+    //Stages, the find.* entries are the KalmanFastTracking timers
+    const char* stageNames[] = {"reduce", "find", "find.st2", "find.st3", "find.st23", "find.global",
+                                "find.global_st1", "find.global_link", "find.global_kalman", "find.kalman", "fit", "total"};
+    const int nStages = sizeof(stageNames)/sizeof(stageNames[0]);
+
+    //Samples of one multiplicity bin
+    struct BinStat
+    {
+        std::string name;
+        int nHitsMin;
+        int nHitsMax;   //exclusive, -1 for no upper limit
+        std::vector<double> latency[nStages];
+        std::vector<double> allocs;
+        std::vector<double> allocBytes;
+        unsigned long nTracklets;
+        unsigned long nFitted;
+
+        BinStat(const std::string& n, int lo, int hi): name(n), nHitsMin(lo), nHitsMax(hi), nTracklets(0), nFitted(0) {}
+        bool contains(int nHits) const { return nHits >= nHitsMin && (nHitsMax < 0 || nHits < nHitsMax); }
+        unsigned long nEvents() const { return latency[0].size(); }
+    };
+
+    //Nearest-rank percentile, the samples are sorted in place
+    double percentile(std::vector<double>& samples, double frac)
+    {
+        if(samples.empty()) return 0.;
+        std::sort(samples.begin(), samples.end());
+
+        int idx = int(std::ceil(frac*samples.size())) - 1;
+        if(idx < 0) idx = 0;
+        return samples[idx];
+    }
+
+    double mean(const std::vector<double>& samples)
+    {
+        if(samples.empty()) return 0.;
+
+        double sum = 0.;
+        for(unsigned int i = 0; i < samples.size(); ++i) sum += samples[i];
+        return sum/samples.size();
+    }
+
+    long peakRSSkB()
+    {
+        struct rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+        return usage.ru_maxrss;   //kB on Linux
+    }
+
+    //Same conversion as SQReco::BuildSRawEvent, without the trigger information
+    SRawEvent* buildSRawEvent(const SQHitVector* hitVec, int eventID)
+    {
+        SRawEvent* rawEvent = new SRawEvent();
+        rawEvent->setEventInfo(0, 0, eventID);
+        for(size_t idx = 0; idx < hitVec->size(); ++idx)
+        {
+            const SQHit* sq_hit = hitVec->at(idx);
+
+            Hit h;
+            h.index = sq_hit->get_hit_id();
+            h.detectorID = sq_hit->get_detector_id();
+            h.elementID = sq_hit->get_element_id();
+            h.tdcTime = sq_hit->get_tdc_time();
+            h.driftDistance = fabs(sq_hit->get_drift_distance());
+            h.pos = sq_hit->get_pos();
+            if(sq_hit->is_in_time()) h.setInTime();
+
+            rawEvent->insertHit(h);
+        }
+        rawEvent->reIndex(true);
+
+        return rawEvent;
+    }
+
+    //Read the events into memory, so that the replay does not include the I/O
+    bool loadEvents(const std::string& fileName, const std::string& treeName, const std::string& branchName, int nEvents, std::vector<SRawEvent*>& events)
+    {
+        TFile* file = TFile::Open(fileName.c_str());
+        if(file == nullptr || !file->IsOpen())
+        {
+            std::cerr << "Cannot open " << fileName << std::endl;
+            return false;
+        }
+
+        TTree* tree = (TTree*)file->Get(treeName.c_str());
+        TBranch* branch = tree == nullptr ? nullptr : tree->GetBranch(branchName.c_str());
+        TClass* cl = nullptr;
+        EDataType dataType;
+        if(branch == nullptr || branch->GetExpectedType(cl, dataType) != 0 || cl == nullptr)
+        {
+            std::cerr << "No object branch " << branchName << " in tree " << treeName << " of " << fileName << std::endl;
+            return false;
+        }
+
+        Long64_t nEntries = tree->GetEntries();
+        if(nEvents > 0 && nEvents < nEntries) nEntries = nEvents;
+
+        if(cl->InheritsFrom("SRawEvent"))
+        {
+            SRawEvent* rawEvent = nullptr;
+            tree->SetBranchAddress(branchName.c_str(), &rawEvent);
+            for(Long64_t i = 0; i < nEntries; ++i)
+            {
+                tree->GetEntry(i);
+                events.push_back(new SRawEvent(*rawEvent));
+            }
+        }
+        else if(cl->InheritsFrom("SQHitVector"))
+        {
+            SQHitVector* hitVec = nullptr;
+            tree->SetBranchAddress(branchName.c_str(), &hitVec);
+            for(Long64_t i = 0; i < nEntries; ++i)
+            {
+                tree->GetEntry(i);
+                events.push_back(buildSRawEvent(hitVec, i));
+            }
+        }
+        else
+        {
+            std::cerr << "Branch " << branchName << " holds " << cl->GetName() << ", neither SRawEvent nor SQHitVector" << std::endl;
+            return false;
+        }
+
+        file->Close();
+        return !events.empty();
+    }
+
+    //The fitters used by SQReco::fitTrackCand, returns true if the fit converged
+    bool fitTrack(Tracklet& tracklet, KalmanFitter* kfitter, SQGenFit::GFFitter* gfitter)
+    {
+        if(kfitter != nullptr)
+        {
+            KalmanTrack kmtrk;
+            kmtrk.setTracklet(tracklet);
+            if(kmtrk.getNodeList().empty()) return false;
+            if(kfitter->processOneTrack(kmtrk) == 0) return false;
+            kfitter->updateTrack(kmtrk);
+            if(!kmtrk.isValid()) return false;
+
+            SRecTrack strack = kmtrk.getSRecTrack();
+            return true;
+        }
+        else if(gfitter != nullptr)
+        {
+            SQGenFit::GFTrack gftrk;
+            gftrk.setTracklet(tracklet);
+            if(gfitter->processTrack(gftrk) != 0) return false;
+
+            SRecTrack strack = gftrk.getSRecTrack();
+            return true;
+        }
+
+        return false;
+    }
+
+    void writeResult(std::ostream& os, const std::map<std::string, double>& result)
+    {
+        os << "{" << std::endl;
+        for(std::map<std::string, double>::const_iterator iter = result.begin(); iter != result.end(); ++iter)
+        {
+            if(iter != result.begin()) os << "," << std::endl;
+            os << "  \"" << iter->first << "\": " << std::setprecision(6) << iter->second;
+        }
+        os << std::endl << "}" << std::endl;
+    }
+
+    //Reads back the output of writeResult
+    bool readResult(const std::string& fileName, std::map<std::string, double>& result)
+    {
+        std::ifstream fin(fileName.c_str());
+        if(!fin) return false;
+
+        std::string line;
+        while(std::getline(fin, line))
+        {
+            size_t q1 = line.find('"');
+            size_t q2 = q1 == std::string::npos ? q1 : line.find('"', q1+1);
+            size_t colon = q2 == std::string::npos ? q2 : line.find(':', q2);
+            if(colon == std::string::npos) continue;
+
+            result[line.substr(q1+1, q2-q1-1)] = atof(line.c_str() + colon + 1);
+        }
+        return true;
+    }
+
+    //Returns the number of regressions beyond the threshold
+    int compareResult(const std::map<std::string, double>& curr, const std::map<std::string, double>& base, double threshold)
+    {
+        int nRegressions = 0;
+        std::cout << std::endl << "Comparison with the baseline (threshold " << 100.*threshold << "%):" << std::endl;
+        for(std::map<std::string, double>::const_iterator iter = curr.begin(); iter != curr.end(); ++iter)
+        {
+            std::map<std::string, double>::const_iterator ref = base.find(iter->first);
+            if(ref == base.end()) continue;
+
+            const std::string& key = iter->first;
+            bool higherIsWorse = key.find("_ms") != std::string::npos || key.find("alloc") != std::string::npos || key == "peak_rss_kB";
+            bool lowerIsWorse = key == "events_per_s";
+            if(!higherIsWorse && !lowerIsWorse) continue;
+
+            //skip the stages which are not exercised, the change there is only noise
+            if(higherIsWorse && ref->second < 1E-3 && iter->second < 1E-3) continue;
+
+            double change = ref->second != 0. ? iter->second/ref->second - 1. : 0.;
+            bool regression = (higherIsWorse && change > threshold) || (lowerIsWorse && change < -threshold);
+            if(regression) ++nRegressions;
+
+            std::cout << (regression ? " ! " : "   ") << std::left << std::setw(40) << key << std::right
+                      << std::setw(14) << ref->second << std::setw(14) << iter->second
+                      << std::setw(10) << std::fixed << std::setprecision(1) << 100.*change << "%" << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+        }
+        std::cout << nRegressions << " regression(s)" << std::endl;
+
+        return nRegressions;
+    }
+
+    void usage(const char* prog)
+    {
+        std::cout << "Usage: " << prog << " -i input.root [-t tree] [-b branch] [-n nEvents] [-l nLoops] [-w nWarmUp]" << std::endl
+                  << "         [-R runID | -c recoConsts.opts] [-r reducerOpts|none] [-f none|legacy|kf|kfref|daf|dafref] [-g geom.root]" << std::endl
+                  << "         [-j nThreads] [-m hit bin edges, e.g. 200,400,800] [-o result.json] [-B baseline.json] [-x threshold]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string inputName, treeName, branchName, reducerOpts, fitterName("none"), geomName, binEdges("200,400,800,1600"), outputName, baselineName, rcFile;
+    int nEvents = -1;
+    int nLoops = 1;
+    int nWarmUp = 0;
+    int runID = -1;
+    unsigned int nThreads = 1;
+    double threshold = 0.05;
+
+    int opt;
+    while((opt = getopt(argc, argv, "i:t:b:n:l:w:R:c:r:f:g:j:m:o:B:x:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'i': inputName = optarg; break;
+            case 't': treeName = optarg; break;
+            case 'b': branchName = optarg; break;
+            case 'n': nEvents = atoi(optarg); break;
+            case 'l': nLoops = atoi(optarg); break;
+            case 'w': nWarmUp = atoi(optarg); break;
+            case 'R': runID = atoi(optarg); break;
+            case 'c': rcFile = optarg; break;
+            case 'r': reducerOpts = optarg; break;
+            case 'f': fitterName = optarg; break;
+            case 'g': geomName = optarg; break;
+            case 'j': nThreads = atoi(optarg); break;
+            case 'm': binEdges = optarg; break;
+            case 'o': outputName = optarg; break;
+            case 'B': baselineName = optarg; break;
+            case 'x': threshold = atof(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if(inputName.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    //Default to the SRawEvent tree, switch to the DST layout if there is none
+    if(treeName.empty() && branchName.empty())
+    {
+        std::unique_ptr<TFile> probe(TFile::Open(inputName.c_str()));
+        bool isDST = probe && probe->IsOpen() && probe->Get("save") == nullptr && probe->Get("T") != nullptr;
+        treeName = isDST ? "T" : "save";
+        branchName = isDST ? "DST.SQHitVector" : "rawEvent";
+    }
+    else if(treeName.empty() || branchName.empty())
+    {
+        std::cerr << "Tree (-t) and branch (-b) have to be given together" << std::endl;
+        return 1;
+    }
+
+    //Reconstruction constants and geometry
+    recoConsts* rc = recoConsts::instance();
+    if(!rcFile.empty())
+    {
+        rc->initfile(rcFile);
+    }
+    else if(runID >= 0)
+    {
+        rc->init(runID);
+    }
+    GeomSvc::instance();
+
+    bool enable_KF = fitterName != "none";
+    PHField* field = nullptr;
+    TGeoManager* geom = nullptr;
+    KalmanFitter* kfitter = nullptr;
+    SQGenFit::GFField* gfield = nullptr;
+    SQGenFit::GFFitter* gfitter = nullptr;
+    if(enable_KF)
+    {
+        if(geomName.empty())
+        {
+            std::cerr << "The fitter " << fitterName << " needs the geometry file (-g)" << std::endl;
+            return 1;
+        }
+        geom = TGeoManager::Import(geomName.c_str());
+
+        std::unique_ptr<PHFieldConfig> field_cfg(new PHFieldConfig_v3(rc->get_CharFlag("fMagFile"), rc->get_CharFlag("kMagFile"), rc->get_DoubleFlag("FMAGSTR"), rc->get_DoubleFlag("KMAGSTR"), 5.));
+        field = PHFieldUtility::BuildFieldMap(field_cfg.get());
+
+        if(fitterName == "legacy")
+        {
+            kfitter = new KalmanFitter(field, geom);
+            kfitter->setControlParameter(50, 0.001);
+        }
+        else
+        {
+            std::map<std::string, std::string> choices;
+            choices["kf"] = "KalmanFitter";
+            choices["kfref"] = "KalmanFitterRefTrack";
+            choices["daf"] = "DafSimple";
+            choices["dafref"] = "DafRef";
+            if(choices.find(fitterName) == choices.end())
+            {
+                std::cerr << "Unknown fitter " << fitterName << std::endl;
+                return 1;
+            }
+
+            gfield = new SQGenFit::GFField(field);
+            gfitter = new SQGenFit::GFFitter();
+            gfitter->init(gfield, choices[fitterName].c_str());
+        }
+    }
+
+    KalmanFastTracking* fastfinder = new KalmanFastTracking(field, geom, enable_KF);
+    fastfinder->setNThreads(nThreads);
+
+    if(reducerOpts.empty()) reducerOpts = rc->get_CharFlag("EventReduceOpts");
+    EventReducer* eventReducer = reducerOpts == "none" ? nullptr : new EventReducer(reducerOpts.c_str());
+
+    //Multiplicity bins, the first one holds all events
+    std::vector<BinStat> bins;
+    bins.push_back(BinStat("all", 0, -1));
+    {
+        std::vector<int> edges(1, 0);
+        std::stringstream ss(binEdges);
+        std::string edge;
+        while(std::getline(ss, edge, ',')) edges.push_back(atoi(edge.c_str()));
+        for(unsigned int i = 0; i < edges.size(); ++i)
+        {
+            int hi = i+1 < edges.size() ? edges[i+1] : -1;
+            std::stringstream name;
+            name << "nhits_" << edges[i] << "_" << (hi < 0 ? std::string("inf") : std::to_string(hi));
+            bins.push_back(BinStat(name.str(), edges[i], hi));
+        }
+    }
+
+    std::vector<SRawEvent*> events;
+    if(!loadEvents(inputName, treeName, branchName, nEvents, events)) return 1;
+    std::cout << "Replaying " << events.size() << " events x " << nLoops << " from " << inputName << ":" << treeName << "/" << branchName
+              << ", fitter " << fitterName << ", " << nThreads << " thread(s)" << std::endl;
+
+    SRawEvent* rawEvent = new SRawEvent();
+    double wallTotal = 0.;
+    unsigned long nReplayed = 0;
+    for(int loop = 0; loop < nLoops; ++loop)
+    {
+        for(unsigned int i = 0; i < events.size(); ++i)
+        {
+            *rawEvent = *events[i];
+            int nHits = rawEvent->getNHitsAll();
+
+            double latency[nStages];
+            for(int j = 0; j < nStages; ++j) latency[j] = 0.;
+
+            unsigned long allocs0 = nAllocs;
+            unsigned long allocBytes0 = nAllocBytes;
+            Clock::time_point t_event = Clock::now();
+
+            Clock::time_point t0 = Clock::now();
+            if(eventReducer != nullptr) eventReducer->reduceEvent(rawEvent);
+            latency[0] = msSince(t0);
+
+            t0 = Clock::now();
+            fastfinder->setRawEvent(rawEvent);
+            latency[1] = msSince(t0);
+
+            const std::map<std::string, PHTimer*>& timers = fastfinder->getTimers();
+            for(int j = 2; j < nStages - 2; ++j)
+            {
+                std::map<std::string, PHTimer*>::const_iterator timer = timers.find(stageNames[j] + 5);
+                if(timer != timers.end()) latency[j] = timer->second->get_accumulated_time();
+            }
+
+            t0 = Clock::now();
+            unsigned long nTracklets = 0;
+            unsigned long nFitted = 0;
+            std::list<Tracklet>& tracklets = fastfinder->getFinalTracklets();
+            for(std::list<Tracklet>::iterator tracklet = tracklets.begin(); tracklet != tracklets.end(); ++tracklet)
+            {
+                tracklet->calcChisq();
+                if(enable_KF && fitTrack(*tracklet, kfitter, gfitter)) ++nFitted;
+                ++nTracklets;
+            }
+            latency[nStages-2] = msSince(t0);
+            latency[nStages-1] = msSince(t_event);
+
+            double allocs = nAllocs - allocs0;
+            double allocBytes = nAllocBytes - allocBytes0;
+
+            ++nReplayed;
+            if(nReplayed <= (unsigned long)nWarmUp) continue;
+            wallTotal += latency[nStages-1];
+
+            for(unsigned int j = 0; j < bins.size(); ++j)
+            {
+                if(!bins[j].contains(nHits)) continue;
+
+                for(int k = 0; k < nStages; ++k) bins[j].latency[k].push_back(latency[k]);
+                bins[j].allocs.push_back(allocs);
+                bins[j].allocBytes.push_back(allocBytes);
+                bins[j].nTracklets += nTracklets;
+                bins[j].nFitted += nFitted;
+            }
+        }
+    }
+
+    //Summary
+    std::map<std::string, double> result;
+    result["events"] = bins[0].nEvents();
+    result["events_per_s"] = wallTotal > 0. ? 1000.*bins[0].nEvents()/wallTotal : 0.;
+    result["peak_rss_kB"] = peakRSSkB();
+    result["threads"] = nThreads;
+
+    std::cout << std::endl << std::setw(16) << "stage" << std::setw(12) << "mean ms" << std::setw(12) << "p50 ms"
+              << std::setw(12) << "p90 ms" << std::setw(12) << "p99 ms" << std::setw(12) << "max ms" << std::endl;
+    for(unsigned int j = 0; j < bins.size(); ++j)
+    {
+        BinStat& bin = bins[j];
+        if(bin.nEvents() == 0) continue;
+
+        const std::string prefix = bin.name + ".";
+        result[prefix + "events"] = bin.nEvents();
+        result[prefix + "tracklets_per_event"] = double(bin.nTracklets)/bin.nEvents();
+        result[prefix + "fitted_per_event"] = double(bin.nFitted)/bin.nEvents();
+        result[prefix + "allocs_per_event"] = mean(bin.allocs);
+        result[prefix + "alloc_bytes_per_event"] = mean(bin.allocBytes);
+
+        std::cout << "--- " << bin.name << ": " << bin.nEvents() << " events, " << result[prefix + "tracklets_per_event"] << " tracklets/event, "
+                  << result[prefix + "allocs_per_event"] << " allocations/event" << std::endl;
+        for(int k = 0; k < nStages; ++k)
+        {
+            const std::string key = prefix + stageNames[k];
+            result[key + ".mean_ms"] = mean(bin.latency[k]);
+            result[key + ".p50_ms"] = percentile(bin.latency[k], 0.50);
+            result[key + ".p90_ms"] = percentile(bin.latency[k], 0.90);
+            result[key + ".p99_ms"] = percentile(bin.latency[k], 0.99);
+            result[key + ".max_ms"] = bin.latency[k].back();
+
+            std::cout << std::setw(16) << stageNames[k] << std::setw(12) << result[key + ".mean_ms"] << std::setw(12) << result[key + ".p50_ms"]
+                      << std::setw(12) << result[key + ".p90_ms"] << std::setw(12) << result[key + ".p99_ms"] << std::setw(12) << result[key + ".max_ms"] << std::endl;
+        }
+    }
+    std::cout << "Events/s: " << result["events_per_s"] << ", peak RSS: " << result["peak_rss_kB"] << " kB" << std::endl;
+
+    if(!outputName.empty())
+    {
+        std::ofstream fout(outputName.c_str());
+        writeResult(fout, result);
+        std::cout << "Result written to " << outputName << std::endl;
+    }
+
+    int ret = 0;
+    if(!baselineName.empty())
+    {
+        std::map<std::string, double> baseline;
+        if(!readResult(baselineName, baseline))
+        {
+            std::cerr << "Cannot read the baseline " << baselineName << std::endl;
+            ret = 1;
+        }
+        else if(compareResult(result, baseline, threshold) > 0)
+        {
+            ret = 2;
+        }
+    }
+
+    for(unsigned int i = 0; i < events.size(); ++i) delete events[i];
+    delete rawEvent;
+    delete eventReducer;
+    delete fastfinder;
+    delete kfitter;
+    delete gfitter;
+    delete gfield;
+
+    return ret;
+}
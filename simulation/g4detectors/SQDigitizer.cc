@@ -185,57 +185,51 @@ void SQDigitizer::digitizePlane(const std::string& detName)
     int eleID = p_geomSvc->getExpElementID(detID, w);
     if(eleID < 1 || eleID > p_geomSvc->getPlaneNElements(detID)) continue; //only save hits within active region
 
-    SQMCHit_v1 digiHit;
-    digiHit.set_track_id(track_id);
-    digiHit.set_g4hit_id(g4hit.get_hit_id());
-    digiHit.set_truth_x(x_ref);
-    digiHit.set_truth_y(y_ref);
-    digiHit.set_truth_z(z_ref);
-    digiHit.set_truth_px(px);
-    digiHit.set_truth_py(py);
-    digiHit.set_truth_pz(pz);
-    digiHit.set_hit_id(digits->size());
-    digiHit.set_in_time(1);
-    digiHit.set_hodo_mask(0);
-    digiHit.set_detector_id(detID);
-    digiHit.set_element_id(eleID);
-    digiHit.set_tdc_time(0.);
-    digiHit.set_pos(p_geomSvc->getMeasurement(detID, eleID));
-
     //Drift distance is calculated differently for chamber and hodos
+    double drift = 0.;
     if(detID <= nChamberPlanes || (detID > nChamberPlanes+nHodoPlanes && detID <= nChamberPlanes+nHodoPlanes+nPropPlanes))
     {
-      digiHit.set_drift_distance(p_geomSvc->getDCA(detID, eleID, tx, ty, x0, y0));
+      drift = p_geomSvc->getDCA(detID, eleID, tx, ty, x0, y0);
     }
-    else
+
+    //fill the hit in place in the output vector, no temporary copy
+    auto addHit = [&](int elementID)
     {
-      digiHit.set_drift_distance(0.);
-    }
+      SQHit* digiHit = digits->emplace_back(true);
+      digiHit->set_track_id(track_id);
+      digiHit->set_g4hit_id(g4hit.get_hit_id());
+      digiHit->set_truth_x(x_ref);
+      digiHit->set_truth_y(y_ref);
+      digiHit->set_truth_z(z_ref);
+      digiHit->set_truth_px(px);
+      digiHit->set_truth_py(py);
+      digiHit->set_truth_pz(pz);
+      digiHit->set_hit_id(digits->size() - 1);
+      digiHit->set_in_time(1);
+      digiHit->set_hodo_mask(0);
+      digiHit->set_detector_id(detID);
+      digiHit->set_element_id(elementID);
+      digiHit->set_tdc_time(0.);
+      digiHit->set_pos(p_geomSvc->getMeasurement(detID, elementID));
+      digiHit->set_drift_distance(drift);
+    };
 
     //push the hit to vector
-    digits->push_back(&digiHit);
+    addHit(eleID);
 
     //special treatment for hodoscopes
-    double dw = w - digiHit.get_pos();
+    double dw = w - p_geomSvc->getMeasurement(detID, eleID);
     double hodoWidth = p_geomSvc->getCellWidth(detID)/2.;
     double hodoOverlap = p_geomSvc->getPlaneOverlap(detID);
     if(fabs(dw) > hodoWidth - hodoOverlap && fabs(dw) < hodoWidth) //hit happens in the overlap region
     {
       if(dw < 0. && eleID != 1)
       {
-        digiHit.set_element_id(eleID-1);
-        digiHit.set_pos(p_geomSvc->getMeasurement(detID, eleID-1));
-        digiHit.set_hit_id(digits->size());
-
-        digits->push_back(&digiHit);
+        addHit(eleID-1);
       }
       else if(dw > 0. && eleID != p_geomSvc->getPlaneNElements(detID))
       {
-        digiHit.set_element_id(eleID+1);
-        digiHit.set_pos(p_geomSvc->getMeasurement(detID, eleID+1));
-        digiHit.set_hit_id(digits->size());
-
-        digits->push_back(&digiHit);
+        addHit(eleID+1);
       }
     }
   }
@@ -636,6 +636,8 @@ int PHG4Reco::process_event(PHCompositeNode *topNode)
   runManager_->BeamOn(1);
   _timer.get()->stop();
 
+  // a subsystem returns ABORTEVENT when it aborted the G4 event (e.g. SQPrimaryAccFilterSubsystem)
+  int ret = Fun4AllReturnCodes::EVENT_OK;
   //BOOST_FOREACH (PHG4Subsystem *g4sub, subsystems_)
   for (PHG4Subsystem *g4sub : subsystems_)
   {
@@ -643,7 +645,7 @@ int PHG4Reco::process_event(PHCompositeNode *topNode)
       cout << " PHG4Reco::process_event - " << g4sub->Name() << "->process_after_geant" << endl;
     try
     {
-      g4sub->process_after_geant(topNode);
+      if (g4sub->process_after_geant(topNode) == Fun4AllReturnCodes::ABORTEVENT) ret = Fun4AllReturnCodes::ABORTEVENT;
     }
     catch (const exception &e)
     {
@@ -655,7 +657,7 @@ int PHG4Reco::process_event(PHCompositeNode *topNode)
     }
   }
   TThread::UnLock();
-  return 0;
+  return ret;
 }
 
 int PHG4Reco::ResetEvent(PHCompositeNode *topNode)
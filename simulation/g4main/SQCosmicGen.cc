@@ -18,6 +18,7 @@
 #include <TMath.h>
 
 #include <cstdlib>
+#include <algorithm>
 #include <cmath>
 #include <cassert>
 
@@ -36,7 +37,6 @@ SQCosmicGen::SQCosmicGen(const std::string& name):
   _altitude(1000.),
   _size_x(800.),
   _size_z(4000.),
-  _prob_max(1.),
   _rndm(PHRandomSeed())
 {
   _req_st[0] = false;
@@ -78,6 +78,8 @@ int SQCosmicGen::InitRun(PHCompositeNode* topNode)
     dstNode->addNode(newNode);
   }
 
+  buildThetaTable();
+
   return Fun4AllReturnCodes::EVENT_OK;
 }
 
@@ -92,13 +94,11 @@ void SQCosmicGen::set_mom_range(const double lo, const double hi)
     _mom_min = 1.;
   }
 
-  if(_theta_max > 1000.)
+  if(_mom_max > 1000.)
   {
     if(Verbosity() > 2) std::cout << Name() << ": mom_max should be smaller than 1 TeV" << std::endl;
     _mom_max = 1000.;
   }
-
-  _prob_max = cosmicProb(_mom_min, 0.);
 }
 
 void SQCosmicGen::set_theta_range(const double lo, const double hi)
@@ -131,29 +131,31 @@ int SQCosmicGen::process_event(PHCompositeNode* topNode)
   int pdgcode = _rndm.Rndm() < _prob_mup ? -13 : 13;
   std::string pdgname = get_pdgname(pdgcode);
 
-  //Generate 3-momentum based on the probability function
+  //Generate the direction based on the angular part of the probability function, and the vertex
+  //within the acceptance. The acceptance only depends on the direction, so the momentum, which
+  //factorizes out of the probability function, is sampled once afterwards
   int nTries = 0;
-  bool cosmic   = false;
   bool accepted = false;
   double x_vtx, z_vtx, y_vtx = _altitude;
-  double p, px, py, pz;
-  while(!cosmic || !accepted)
+  double ux, uy, uz;
+  while(!accepted)
   {
     ++nTries;
 
-    p = uniformRand(_mom_min, _mom_max);
-    double theta = uniformRand(_theta_min, _theta_max);
+    double theta = sampleTheta();
     double phi = _rndm.Rndm()*TMath::Pi();
-    py = -p*TMath::Cos(theta);
-    px =  p*TMath::Sin(theta)*TMath::Cos(phi);
-    pz =  p*TMath::Sin(theta)*TMath::Sin(phi);
-
-    cosmic = _rndm.Rndm() < (cosmicProb(p, theta)/_prob_max);
-    if(!cosmic) continue;
+    uy = -TMath::Cos(theta);
+    ux =  TMath::Sin(theta)*TMath::Cos(phi);
+    uz =  TMath::Sin(theta)*TMath::Sin(phi);
 
-    accepted = generateVtx(px/pz, py/pz, x_vtx, y_vtx, z_vtx);
+    accepted = generateVtx(ux/uz, uy/uz, x_vtx, y_vtx, z_vtx);
   }
 
+  double p  = sampleMom();
+  double px = p*ux;
+  double py = p*uy;
+  double pz = p*uz;
+
   //Generate a muon and set common features
   int vtxID = _ineve->AddVtx(x_vtx, y_vtx, z_vtx, 0.);
   PHG4Particle* particle = new PHG4Particlev2();
@@ -228,17 +230,20 @@ bool SQCosmicGen::generateVtx(double tx, double ty, double& x, double& y, double
     getZVtxLimits(i, ty, y, z_min, z_max);
   }
   if(z_max < z_min) return false;
-  z = uniformRand(z_min, z_max);
 
+  //The x limits of all stations move together by tx*z, so the allowed x range is evaluated at z = 0
+  //and it is known before z is sampled whether the direction can be accepted at all
   double x_min = -999999.;
   double x_max =  999999.;
   for(int i = 0; i < 5; ++i)
   {
     if(!_req_st[i]) continue;
-    getXVtxLimits(i, tx, z, x_min, x_max);
+    getXVtxLimits(i, tx, 0., x_min, x_max);
   }
   if(x_max < x_min) return false;
-  x = uniformRand(x_min, x_max);
+
+  z = uniformRand(z_min, z_max);
+  x = uniformRand(x_min, x_max) + tx*z;
 
   for(int i = 0; i < 5; ++i)
   {
@@ -257,3 +262,48 @@ double SQCosmicGen::uniformRand(const double lo, const double hi)
 {
   return lo + (hi - lo)*_rndm.Rndm();
 }
+
+void SQCosmicGen::buildThetaTable()
+{
+  //p0^(cos(p1*theta)) decreases monotonically with |theta| as long as |p1*theta| < pi,
+  //so the maximum in each bin is at the edge closer to 0, or at 0 itself
+  _theta_cdf.assign(N_THETA_BINS, 0.);
+  _theta_env.assign(N_THETA_BINS, 0.);
+
+  double width = (_theta_max - _theta_min)/N_THETA_BINS;
+  double sum = 0.;
+  for(int i = 0; i < N_THETA_BINS; ++i)
+  {
+    double lo = _theta_min + i*width;
+    double hi = lo + width;
+    double theta_peak = (lo < 0. && hi > 0.) ? 0. : (fabs(lo) < fabs(hi) ? lo : hi);
+
+    _theta_env[i] = cosmicProb(1., theta_peak);
+    sum += _theta_env[i]*width;
+    _theta_cdf[i] = sum;
+  }
+  for(int i = 0; i < N_THETA_BINS; ++i) _theta_cdf[i] /= sum;
+}
+
+double SQCosmicGen::sampleTheta()
+{
+  if(!(_theta_max > _theta_min)) return _theta_min;
+
+  //Pick a bin by the inverse CDF of the envelope, then accept-reject within the bin,
+  //which is exact and accepts (1 - O(1/N_THETA_BINS)) of the tries
+  double width = (_theta_max - _theta_min)/N_THETA_BINS;
+  while(true)
+  {
+    int bin = std::upper_bound(_theta_cdf.begin(), _theta_cdf.end(), _rndm.Rndm()) - _theta_cdf.begin();
+    if(bin >= N_THETA_BINS) bin = N_THETA_BINS - 1;
+
+    double theta = _theta_min + (bin + _rndm.Rndm())*width;
+    if(_rndm.Rndm()*_theta_env[bin] < cosmicProb(1., theta)) return theta;
+  }
+}
+
+double SQCosmicGen::sampleMom()
+{
+  //Inverse CDF of 1/p^2 in [_mom_min, _mom_max]
+  return 1./(1./_mom_min - _rndm.Rndm()*(1./_mom_min - 1./_mom_max));
+}
@@ -4,6 +4,7 @@
 #include "PHG4ParticleGeneratorBase.h"
 
 #include <string>
+#include <vector>
 
 #include <TRandom1.h>
 
@@ -33,6 +34,13 @@ private:
   //! get a random number following uniform distribuion between lo and hi
   double uniformRand(const double lo, const double hi);
 
+  //! build the sampling table of the angular part p0^(cos(p1*theta)) for the current theta range
+  void buildThetaTable();
+
+  //! sample theta from the angular part, and p from the 1/p^2 part by its inverse CDF
+  double sampleTheta();
+  double sampleMom();
+
   //! calculate vtx position limits based on detector acceptance
   void getZVtxLimits(int stationID, double ty, double y, double& min, double& max);
   void getXVtxLimits(int stationID, double tx, double z, double& min, double& max);
@@ -76,8 +84,10 @@ private:
   double _size_x;
   double _size_z;
 
-  //! maximum probability used for normalization
-  double _prob_max;
+  //! piecewise-constant envelope of the angular part - cumulative weight and envelope value per theta bin
+  static const int N_THETA_BINS = 1000;
+  std::vector<double> _theta_cdf;
+  std::vector<double> _theta_env;
 
   //! Random generator
   TRandom1 _rndm;
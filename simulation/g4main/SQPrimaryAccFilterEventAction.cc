@@ -0,0 +1,154 @@
+#include "SQPrimaryAccFilterEventAction.h"
+
+#include <Geant4/G4Event.hh>
+#include <Geant4/G4PrimaryVertex.hh>
+#include <Geant4/G4PrimaryParticle.hh>
+#include <Geant4/G4PhysicalVolumeStore.hh>
+#include <Geant4/G4RunManager.hh>
+#include <Geant4/G4Track.hh>
+
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+//_________________________________________________________________
+SQPrimaryAccFilterEventAction::SQPrimaryAccFilterEventAction( void ):
+  _npl_per_par(4),
+  _npar_per_evt(2),
+  _pz_min(0.),
+  _tx_max(-1.),
+  _ty_max(-1.),
+  _verbosity(0),
+  _st_vol_found(false),
+  _active(true),
+  _n_pending(0),
+  _n_good(0),
+  _decided(false),
+  _aborted(false)
+{
+  // Same detectors as the hit containers used by RequireParticlesInAcc.
+  const char* names[4][2] = { {"H1T", "H1B"}, {"H2T", "H2B"}, {"H3T", "H3B"}, {"H4T", "H4B"} };
+  for (int st = 0; st < 4; st++) {
+    _st_vol_names[st].push_back(names[st][0]);
+    _st_vol_names[st].push_back(names[st][1]);
+  }
+}
+
+//_________________________________________________________________
+void SQPrimaryAccFilterEventAction::SetPreCheck(const double pz_min, const double tx_max, const double ty_max)
+{
+  _pz_min = pz_min;
+  _tx_max = tx_max;
+  _ty_max = ty_max;
+}
+
+//_________________________________________________________________
+void SQPrimaryAccFilterEventAction::BeginOfEventAction( const G4Event* event )
+{
+  if (! _st_vol_found) FindStationVolumes();
+
+  _primaries.clear();
+  _n_pending = 0;
+  _n_good    = 0;
+  _decided   = false;
+  _aborted   = false;
+  if (! _active) {
+    _decided = true;
+    return;
+  }
+
+  for (int iv = 0; iv < event->GetNumberOfPrimaryVertex(); iv++) {
+    for (G4PrimaryParticle* par = event->GetPrimaryVertex(iv)->GetPrimary(); par; par = par->GetNext()) {
+      if (PassPreCheck(par->GetPx(), par->GetPy(), par->GetPz(), par->GetCharge())) _n_pending++;
+    }
+  }
+  if (_n_pending < _npar_per_evt) Abort("pre-check");
+}
+
+//_________________________________________________________________
+void SQPrimaryAccFilterEventAction::StartPrimary( const G4Track* track )
+{
+  if (_primaries.find(track->GetTrackID()) != _primaries.end()) return; // resumed track
+  const G4ThreeVector& mom = track->GetMomentum();
+  Primary& pri = _primaries[track->GetTrackID()];
+  pri.st_mask = 0;
+  pri.cand    = PassPreCheck(mom.x(), mom.y(), mom.z(), track->GetDynamicParticle()->GetCharge());
+  pri.good    = false;
+}
+
+//_________________________________________________________________
+void SQPrimaryAccFilterEventAction::AddStep( const int trk_id, const G4VPhysicalVolume* vol )
+{
+  map<const G4VPhysicalVolume*, int>::const_iterator it_vol = _st_vol.find(vol);
+  if (it_vol == _st_vol.end()) return;
+  map<int, Primary>::iterator it = _primaries.find(trk_id);
+  if (it == _primaries.end() || ! it->second.cand || it->second.good) return;
+
+  Primary& pri = it->second;
+  pri.st_mask |= 1u << it_vol->second;
+  int n_st = 0;
+  for (unsigned int mask = pri.st_mask; mask; mask >>= 1) n_st += mask & 1u;
+  if (n_st < _npl_per_par) return;
+
+  pri.good = true;
+  _n_pending--;
+  _n_good++;
+  if (_n_good >= _npar_per_evt) _decided = true; // The event surely passes.
+}
+
+//_________________________________________________________________
+void SQPrimaryAccFilterEventAction::EndPrimary( const int trk_id )
+{
+  map<int, Primary>::iterator it = _primaries.find(trk_id);
+  if (it == _primaries.end() || ! it->second.cand || it->second.good) return;
+  it->second.cand = false;
+  _n_pending--;
+  if (_n_good + _n_pending < _npar_per_evt) Abort("primary track end");
+}
+
+//_________________________________________________________________
+void SQPrimaryAccFilterEventAction::FindStationVolumes()
+{
+  G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+  for (G4PhysicalVolumeStore::const_iterator it = store->begin(); it != store->end(); ++it) {
+    for (int st = 0; st < 4; st++) {
+      for (unsigned int ii = 0; ii < _st_vol_names[st].size(); ii++) {
+        if (MatchVolumeName((*it)->GetName(), _st_vol_names[st][ii])) _st_vol[*it] = st;
+      }
+    }
+  }
+  if (_st_vol.empty()) {
+    cout << "SQPrimaryAccFilterEventAction::FindStationVolumes - WARNING - no hodoscope volume found.  The filter is disabled." << endl;
+    _active = false;
+  }
+  _st_vol_found = true;
+}
+
+//_________________________________________________________________
+bool SQPrimaryAccFilterEventAction::MatchVolumeName( const string &name, const string &base )
+{
+  if (name.compare(0, base.size(), base) != 0) return false;
+  return name.size() == base.size() || name[base.size()] == '_';
+}
+
+//_________________________________________________________________
+bool SQPrimaryAccFilterEventAction::PassPreCheck( const double px, const double py, const double pz, const double charge ) const
+{
+  if (charge == 0 || pz <= _pz_min) return false;
+  if (_tx_max > 0 && fabs(px / pz) > _tx_max) return false;
+  if (_ty_max > 0 && fabs(py / pz) > _ty_max) return false;
+  return true;
+}
+
+//_________________________________________________________________
+void SQPrimaryAccFilterEventAction::Abort( const string &reason )
+{
+  if (_verbosity > 0) {
+    cout << "SQPrimaryAccFilterEventAction::Abort - " << reason << ": n_good = " << _n_good
+         << ", n_pending = " << _n_pending << " < " << _npar_per_evt << endl;
+  }
+  _decided = true;
+  _aborted = true;
+  G4RunManager::GetRunManager()->AbortEvent();
+}
@@ -0,0 +1,98 @@
+#ifndef SQPrimaryAccFilterEventAction_h
+#define SQPrimaryAccFilterEventAction_h
+
+#include "PHG4EventAction.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+class G4Event;
+class G4Track;
+class G4VPhysicalVolume;
+
+//! Per-event state of SQPrimaryAccFilterSubsystem, shared by its stepping and tracking actions.
+/*!
+  A primary charged particle is "good" once it has entered the volumes of at least
+  _npl_per_par hodoscope stations (H1-H4, top or bottom).  Secondaries are not counted.
+  The G4 event is aborted as soon as fewer than _npar_per_evt primaries can still become good:
+  - at BeginOfEventAction, when too few primaries pass the straight-line pre-check;
+  - at PostUserTrackingAction, when a primary stops (range-out, decay, leaving the world)
+    without becoming good.
+  No event is aborted when no hodoscope volume is found in the geometry.
+*/
+class SQPrimaryAccFilterEventAction: public PHG4EventAction
+{
+
+public:
+
+  //! constructor
+  SQPrimaryAccFilterEventAction( void );
+
+  //! destructor
+  virtual ~SQPrimaryAccFilterEventAction( void ) {}
+
+  void BeginOfEventAction(const G4Event*);
+
+  void SetNumHitPlanesPerParticle(const int val) { _npl_per_par  = val; }
+  void SetNumParticlesPerEvent   (const int val) { _npar_per_evt = val; }
+
+  //! pre-check cuts on the primary momentum; a non-positive slope cut is not applied
+  void SetPreCheck(const double pz_min, const double tx_max, const double ty_max);
+
+  void Verbosity(const int val) { _verbosity = val; }
+
+  //! true once the event is known to pass or has been aborted, i.e. no more work to do
+  bool IsDecided() const { return _decided; }
+
+  bool IsAborted() const { return _aborted; }
+
+  //! called by the tracking action before a primary track is processed
+  void StartPrimary(const G4Track* track);
+
+  //! called by the stepping action for each step of a primary track
+  void AddStep(const int trk_id, const G4VPhysicalVolume* vol);
+
+  //! called by the tracking action after a primary track is processed
+  void EndPrimary(const int trk_id);
+
+ private:
+
+  //! primary state
+  struct Primary {
+    unsigned int st_mask; //!< bit per station entered
+    bool cand;            //!< passed the pre-check
+    bool good;
+  };
+
+  //! map the station volumes in the G4 geometry, once
+  void FindStationVolumes();
+
+  //! true if "name" is "base" or "base_<layer>"
+  static bool MatchVolumeName(const std::string &name, const std::string &base);
+
+  bool PassPreCheck(const double px, const double py, const double pz, const double charge) const;
+
+  void Abort(const std::string &reason);
+
+  int _npl_per_par;
+  int _npar_per_evt;
+  double _pz_min;
+  double _tx_max;
+  double _ty_max;
+  int _verbosity;
+
+  //! volume-name base per station.  The volume name is "<base>_<layer>" (PHG4DetectorSubsystem)
+  std::vector<std::string> _st_vol_names[4];
+  std::map<const G4VPhysicalVolume*, int> _st_vol; //!< station volume -> station index
+  bool _st_vol_found;
+  bool _active; //!< false if no station volume is found
+
+  std::map<int, Primary> _primaries; //!< G4 track ID -> state
+  int _n_pending; //!< candidates not yet good nor finished
+  int _n_good;
+  bool _decided;
+  bool _aborted;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#include "SQPrimaryAccFilterSteppingAction.h"
+#include "SQPrimaryAccFilterEventAction.h"
+
+#include <Geant4/G4Step.hh>
+#include <Geant4/G4Track.hh>
+
+//________________________________________________________
+SQPrimaryAccFilterSteppingAction::SQPrimaryAccFilterSteppingAction( SQPrimaryAccFilterEventAction* eventAction ):
+  eventAction_( eventAction )
+  {}
+
+//________________________________________________________
+bool SQPrimaryAccFilterSteppingAction::UserSteppingAction( const G4Step* step, bool hitWasUsed )
+{
+  if ( eventAction_->IsDecided() ) return false;
+  const G4Track* track = step->GetTrack();
+  if ( track->GetParentID() != 0 ) return false;
+  eventAction_->AddStep( track->GetTrackID(), step->GetPreStepPoint()->GetPhysicalVolume() );
+  return false;
+}
@@ -0,0 +1,30 @@
+#ifndef SQPrimaryAccFilterSteppingAction_h
+#define SQPrimaryAccFilterSteppingAction_h
+
+#include "PHG4SteppingAction.h"
+
+class SQPrimaryAccFilterEventAction;
+
+class SQPrimaryAccFilterSteppingAction : public PHG4SteppingAction
+{
+
+  public:
+
+  //! constructor
+  SQPrimaryAccFilterSteppingAction( SQPrimaryAccFilterEventAction* );
+
+  //! destructor
+  virtual ~SQPrimaryAccFilterSteppingAction()
+  {}
+
+  //! stepping action.  Records the hodoscope stations entered by primary tracks
+  virtual bool UserSteppingAction(const G4Step*, bool );
+
+  private:
+
+  SQPrimaryAccFilterEventAction* eventAction_;
+
+};
+
+
+#endif
@@ -0,0 +1,74 @@
+#include "SQPrimaryAccFilterSubsystem.h"
+#include "SQPrimaryAccFilterEventAction.h"
+#include "SQPrimaryAccFilterSteppingAction.h"
+#include "SQPrimaryAccFilterTrackingAction.h"
+
+#include <fun4all/Fun4AllReturnCodes.h>
+
+#include <Geant4/G4SystemOfUnits.hh>
+
+#include <iostream>
+
+using namespace std;
+
+//_______________________________________________________________________
+SQPrimaryAccFilterSubsystem::SQPrimaryAccFilterSubsystem( const string &name ):
+  PHG4Subsystem( name ),
+  _eventAction( NULL ),
+  _steppingAction( NULL ),
+  _trackingAction( NULL ),
+  _enable( false ),
+  _npl_per_par( 4 ),
+  _npar_per_evt( 2 ),
+  _pz_min( 0. ),
+  _tx_max( -1. ),
+  _ty_max( -1. ),
+  _n_abort( 0 )
+{}
+
+//_______________________________________________________________________
+void SQPrimaryAccFilterSubsystem::SetPreCheck( const double pz_min, const double tx_max, const double ty_max )
+{
+  _pz_min = pz_min;
+  _tx_max = tx_max;
+  _ty_max = ty_max;
+}
+
+//_______________________________________________________________________
+int SQPrimaryAccFilterSubsystem::InitRun( PHCompositeNode* topNode )
+{
+  if ( ! _enable )
+    {
+      cout << "SQPrimaryAccFilterSubsystem::InitRun - not enabled.  No event is aborted." << endl;
+      return 0;
+    }
+  _eventAction = new SQPrimaryAccFilterEventAction();
+  _eventAction->SetNumHitPlanesPerParticle( _npl_per_par );
+  _eventAction->SetNumParticlesPerEvent( _npar_per_evt );
+  _eventAction->SetPreCheck( _pz_min*GeV, _tx_max, _ty_max );
+  _eventAction->Verbosity( Verbosity() );
+
+  _steppingAction = new SQPrimaryAccFilterSteppingAction( _eventAction );
+  _trackingAction = new SQPrimaryAccFilterTrackingAction( _eventAction );
+  return 0;
+}
+
+//_______________________________________________________________________
+int SQPrimaryAccFilterSubsystem::process_after_geant( PHCompositeNode* topNode )
+{
+  if ( ! _eventAction || ! _eventAction->IsAborted() ) return Fun4AllReturnCodes::EVENT_OK;
+  _n_abort++;
+  return Fun4AllReturnCodes::ABORTEVENT;
+}
+
+//_______________________________________________________________________
+PHG4EventAction* SQPrimaryAccFilterSubsystem::GetEventAction( void ) const
+{ return _eventAction; }
+
+//_______________________________________________________________________
+PHG4SteppingAction* SQPrimaryAccFilterSubsystem::GetSteppingAction( void ) const
+{ return _steppingAction; }
+
+//_______________________________________________________________________
+PHG4TrackingAction* SQPrimaryAccFilterSubsystem::GetTrackingAction( void ) const
+{ return _trackingAction; }
@@ -0,0 +1,83 @@
+#ifndef SQPrimaryAccFilterSubsystem_h
+#define SQPrimaryAccFilterSubsystem_h
+
+#include "PHG4Subsystem.h"
+#include <string>
+
+class SQPrimaryAccFilterEventAction;
+class SQPrimaryAccFilterSteppingAction;
+class SQPrimaryAccFilterTrackingAction;
+
+//! PHG4 subsystem that aborts the G4 event as soon as its primary particles cannot be in the acceptance.
+/*!
+  This is a primary-only cut, NOT equivalent to RequireParticlesInAcc.
+  A primary charged particle is counted as in-acceptance when it enters N hodoscope stations,
+  and the event is aborted once fewer than N primaries can still be counted, e.g. when the
+  last candidate primary stops, decays or leaves the world.  Primaries can also be dropped
+  before tracking by a straight-line pre-check on their momentum (SetPreCheck()).
+  Secondaries are never counted, whereas RequireParticlesInAcc counts any track that leaves
+  hodoscope hits.  Thus events accepted only via secondaries (e.g. a muon from a primary
+  pion decay, or daughters of a neutral primary) are lost.  Use it only when the sample is
+  defined by the primaries, as in dimuon productions.
+
+  The cut is off by default and has to be enabled explicitly.  An aborted event is returned
+  as ABORTEVENT by PHG4Reco.  RequireParticlesInAcc should still be registered after PHG4Reco
+  to make the final selection.
+
+    SQPrimaryAccFilterSubsystem* acc_filter = new SQPrimaryAccFilterSubsystem();
+    acc_filter->Enable();
+    acc_filter->SetNumParticlesPerEvent(2);
+    g4Reco->registerSubsystem(acc_filter);
+*/
+class SQPrimaryAccFilterSubsystem: public PHG4Subsystem
+{
+
+  public:
+
+  //! constructor
+  SQPrimaryAccFilterSubsystem( const std::string &name = "PRIMARY_ACC_FILTER" );
+
+  //! destructor
+  virtual ~SQPrimaryAccFilterSubsystem( void )
+  {}
+
+  //! init
+  int InitRun(PHCompositeNode *);
+
+  //! return ABORTEVENT if the G4 event was aborted
+  virtual int process_after_geant(PHCompositeNode *);
+
+  //! accessors (reimplemented)
+  virtual PHG4EventAction* GetEventAction( void ) const;
+  virtual PHG4SteppingAction* GetSteppingAction( void ) const;
+  virtual PHG4TrackingAction* GetTrackingAction( void ) const;
+
+  //! the cut is applied only when enabled
+  void Enable(const bool val = true) { _enable = val; }
+
+  void SetNumHitPlanesPerParticle(const int val) { _npl_per_par  = val; }
+  void SetNumParticlesPerEvent   (const int val) { _npar_per_evt = val; }
+
+  //! require pz > pz_min (GeV), |px/pz| < tx_max and |py/pz| < ty_max at the primary vertex.
+  //! A non-positive slope cut is not applied.  Default = (0, -1, -1)
+  void SetPreCheck(const double pz_min, const double tx_max = -1., const double ty_max = -1.);
+
+  int GetNumAborted() const { return _n_abort; }
+
+  private:
+
+  SQPrimaryAccFilterEventAction* _eventAction;
+  SQPrimaryAccFilterSteppingAction* _steppingAction;
+  SQPrimaryAccFilterTrackingAction* _trackingAction;
+
+  bool _enable;
+  int _npl_per_par;
+  int _npar_per_evt;
+  double _pz_min;
+  double _tx_max;
+  double _ty_max;
+
+  int _n_abort;
+};
+
+#endif
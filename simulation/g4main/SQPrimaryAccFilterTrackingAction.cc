@@ -0,0 +1,23 @@
+#include "SQPrimaryAccFilterTrackingAction.h"
+#include "SQPrimaryAccFilterEventAction.h"
+
+#include <Geant4/G4Track.hh>
+
+//________________________________________________________
+SQPrimaryAccFilterTrackingAction::SQPrimaryAccFilterTrackingAction( SQPrimaryAccFilterEventAction* eventAction ):
+  eventAction_( eventAction )
+  {}
+
+//________________________________________________________
+void SQPrimaryAccFilterTrackingAction::PreUserTrackingAction( const G4Track* track )
+{
+  if ( eventAction_->IsDecided() || track->GetParentID() != 0 ) return;
+  eventAction_->StartPrimary( track );
+}
+
+//________________________________________________________
+void SQPrimaryAccFilterTrackingAction::PostUserTrackingAction( const G4Track* track )
+{
+  if ( eventAction_->IsDecided() || track->GetParentID() != 0 ) return;
+  eventAction_->EndPrimary( track->GetTrackID() );
+}
@@ -0,0 +1,32 @@
+#ifndef SQPrimaryAccFilterTrackingAction_h
+#define SQPrimaryAccFilterTrackingAction_h
+
+#include "PHG4TrackingAction.h"
+
+class SQPrimaryAccFilterEventAction;
+
+class SQPrimaryAccFilterTrackingAction : public PHG4TrackingAction
+{
+
+  public:
+
+  //! constructor
+  SQPrimaryAccFilterTrackingAction( SQPrimaryAccFilterEventAction* );
+
+  //! destructor
+  virtual ~SQPrimaryAccFilterTrackingAction()
+  {}
+
+  //! tracking actions.  Only primary tracks are looked at
+  virtual void PreUserTrackingAction(const G4Track*);
+
+  virtual void PostUserTrackingAction(const G4Track*);
+
+  private:
+
+  SQPrimaryAccFilterEventAction* eventAction_;
+
+};
+
+
+#endif